@@ -12,6 +12,15 @@ public class BangGuCha : ModuleRules
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
+		// Editor automation tests start PIE sessions (Tests/BangGuChaNetTests.cpp)
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.Add("UnrealEd");
+		}
+
+		// Engine-independent rules under Sim/ are included as "Sim/..."
+		PublicIncludePaths.Add(ModuleDirectory);
+
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		
@@ -3,3 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Sim/BangGuChaSimTypes.h"
+
+// Sim directions live on the XY plane of the level
+inline FVector BangGuChaDirectionToVector(BangGuChaSim::EDirection Dir) {
+  return FVector(BangGuChaSim::StepX(Dir), BangGuChaSim::StepY(Dir), 0.f);
+}
@@ -0,0 +1,218 @@
+#include "BangGuChaActorPoolSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+namespace {
+// Parked actors sit far below the map so stray queries never find them
+const FVector PoolParkingLocation(0.f, 0.f, -100000.f);
+} // namespace
+
+static FAutoConsoleCommandWithWorld BangGuChaPoolStatsCommand(
+    TEXT("bgc.PoolStats"),
+    TEXT("Log spawned/active/free counts, high water marks and misses for ")
+        TEXT("every actor pool in the world."),
+    FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld *World) {
+      if (const UBangGuChaActorPoolSubsystem *Pool =
+              World ? World->GetSubsystem<UBangGuChaActorPoolSubsystem>()
+                    : nullptr) {
+        Pool->LogStats();
+      }
+    }));
+
+bool UBangGuChaActorPoolSubsystem::DoesSupportWorldType(
+    EWorldType::Type WorldType) const {
+  return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBangGuChaActorPoolSubsystem::Prewarm(TSubclassOf<AActor> Class,
+                                           int32 Count) {
+  if (!Class)
+    return;
+
+  FBangGuChaActorPoolBucket &Bucket = Buckets.FindOrAdd(Class);
+  Bucket.Free.Reserve(Count);
+  while (Bucket.Stats.Spawned < Count) {
+    if (AActor *Actor =
+            SpawnPooled(Class, PoolParkingLocation, FRotator::ZeroRotator)) {
+      Bucket.Stats.Spawned++;
+      if (IBangGuChaPooledActor *Pooled = Cast<IBangGuChaPooledActor>(Actor)) {
+        Pooled->OnReturnedToPool();
+      }
+      Deactivate(Actor);
+      Bucket.Free.Add(Actor);
+    } else {
+      break;
+    }
+  }
+}
+
+AActor *UBangGuChaActorPoolSubsystem::Acquire(TSubclassOf<AActor> Class,
+                                              const FVector &Location,
+                                              const FRotator &Rotation) {
+  if (!Class)
+    return nullptr;
+
+  FBangGuChaActorPoolBucket &Bucket = Buckets.FindOrAdd(Class);
+  Bucket.Stats.Acquires++;
+
+  // Entries can go stale if someone destroyed a parked actor directly
+  AActor *Actor = nullptr;
+  while (!Actor && Bucket.Free.Num() > 0) {
+    Actor = Bucket.Free.Pop(false);
+    if (!IsValid(Actor)) {
+      Actor = nullptr;
+    }
+  }
+
+  if (Actor) {
+    Activate(Actor, Location, Rotation);
+  } else {
+    Bucket.Stats.Misses++;
+    Actor = SpawnPooled(Class, Location, Rotation);
+    if (!Actor)
+      return nullptr;
+    Bucket.Stats.Spawned++;
+  }
+
+  ActiveActors.Add(FObjectKey(Actor));
+  Bucket.Stats.Active++;
+  Bucket.Stats.HighWaterMark =
+      FMath::Max(Bucket.Stats.HighWaterMark, Bucket.Stats.Active);
+
+  if (IBangGuChaPooledActor *Pooled = Cast<IBangGuChaPooledActor>(Actor)) {
+    Pooled->OnAcquiredFromPool();
+  }
+  return Actor;
+}
+
+void UBangGuChaActorPoolSubsystem::Release(AActor *Actor) {
+  if (!IsValid(Actor))
+    return;
+
+  FBangGuChaActorPoolBucket *Bucket = Buckets.Find(Actor->GetClass());
+  if (!Bucket || ActiveActors.Remove(FObjectKey(Actor)) == 0) {
+    // Placed in the level or spawned directly; keep the old behaviour.
+    // A second release of a parked actor is ignored.
+    if (!Bucket || !Bucket->Free.Contains(Actor)) {
+      Actor->Destroy();
+    }
+    return;
+  }
+
+  if (IBangGuChaPooledActor *Pooled = Cast<IBangGuChaPooledActor>(Actor)) {
+    Pooled->OnReturnedToPool();
+  }
+  Deactivate(Actor);
+  Bucket->Free.Add(Actor);
+  Bucket->Stats.Active--;
+}
+
+void UBangGuChaActorPoolSubsystem::ReleaseAll(TSubclassOf<AActor> Class) {
+  const FBangGuChaActorPoolBucket *Bucket =
+      Class ? Buckets.Find(Class) : nullptr;
+  if (!Bucket || Bucket->Stats.Active == 0)
+    return;
+
+  ReleaseScratch.Reset();
+  for (const FObjectKey &Key : ActiveActors) {
+    AActor *Actor = Cast<AActor>(Key.ResolveObjectPtr());
+    if (Actor && Actor->GetClass() == Class) {
+      ReleaseScratch.Add(Actor);
+    }
+  }
+  for (AActor *Actor : ReleaseScratch) {
+    Release(Actor);
+  }
+  ReleaseScratch.Reset();
+}
+
+AActor *UBangGuChaActorPoolSubsystem::AcquireOrSpawn(
+    const UObject *WorldContextObject, TSubclassOf<AActor> Class,
+    const FVector &Location, const FRotator &Rotation) {
+  UWorld *World =
+      WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+  if (!World || !Class)
+    return nullptr;
+
+  if (UBangGuChaActorPoolSubsystem *Pool =
+          World->GetSubsystem<UBangGuChaActorPoolSubsystem>()) {
+    return Pool->Acquire(Class, Location, Rotation);
+  }
+  return World->SpawnActor<AActor>(Class, Location, Rotation);
+}
+
+void UBangGuChaActorPoolSubsystem::ReleaseOrDestroy(AActor *Actor) {
+  if (!IsValid(Actor))
+    return;
+
+  if (UBangGuChaActorPoolSubsystem *Pool =
+          Actor->GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>()) {
+    Pool->Release(Actor);
+  } else {
+    Actor->Destroy();
+  }
+}
+
+FBangGuChaActorPoolStats
+UBangGuChaActorPoolSubsystem::GetPoolStats(TSubclassOf<AActor> Class) const {
+  const FBangGuChaActorPoolBucket *Bucket = Buckets.Find(Class);
+  if (!Bucket)
+    return FBangGuChaActorPoolStats();
+
+  FBangGuChaActorPoolStats Stats = Bucket->Stats;
+  Stats.Free = Bucket->Free.Num();
+  return Stats;
+}
+
+void UBangGuChaActorPoolSubsystem::LogStats() const {
+  for (const TPair<UClass *, FBangGuChaActorPoolBucket> &Pair : Buckets) {
+    const FBangGuChaActorPoolStats Stats = GetPoolStats(Pair.Key);
+    UE_LOG(LogTemp, Log,
+           TEXT("Pool %s: spawned %d, active %d, free %d, high water %d, "
+                "misses %d / %d acquires"),
+           *GetNameSafe(Pair.Key), Stats.Spawned, Stats.Active, Stats.Free,
+           Stats.HighWaterMark, Stats.Misses, Stats.Acquires);
+  }
+}
+
+AActor *UBangGuChaActorPoolSubsystem::SpawnPooled(UClass *Class,
+                                                  const FVector &Location,
+                                                  const FRotator &Rotation) {
+  FActorSpawnParameters SpawnParams;
+  SpawnParams.SpawnCollisionHandlingOverride =
+      ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+  return GetWorld()->SpawnActor<AActor>(Class, Location, Rotation,
+                                        SpawnParams);
+}
+
+void UBangGuChaActorPoolSubsystem::Deactivate(AActor *Actor) {
+  Actor->SetActorTickEnabled(false);
+  Actor->SetActorEnableCollision(false);
+  Actor->SetActorHiddenInGame(true);
+  Actor->SetActorLocation(PoolParkingLocation);
+  // Hidden and parked, the actor stops being net relevant and clients would
+  // destroy their copy. Dormancy sends the parked state once, then keeps
+  // the channel out of relevancy checks so the client copy stays pooled.
+  if (Actor->GetIsReplicated()) {
+    Actor->SetNetDormancy(DORM_DormantAll);
+  }
+  Actor->FlushNetDormancy();
+}
+
+void UBangGuChaActorPoolSubsystem::Activate(AActor *Actor,
+                                            const FVector &Location,
+                                            const FRotator &Rotation) {
+  // Move before re-enabling collision so overlaps are found at the new spot
+  Actor->SetActorLocationAndRotation(Location, Rotation);
+  Actor->SetActorHiddenInGame(false);
+  Actor->SetActorEnableCollision(true);
+  Actor->SetActorTickEnabled(Actor->PrimaryActorTick.bStartWithTickEnabled);
+  Actor->UpdateOverlaps();
+  if (Actor->GetIsReplicated()) {
+    Actor->SetNetDormancy(Actor->GetClass()->GetDefaultObject<AActor>()
+                              ->NetDormancy.GetValue());
+  }
+  Actor->FlushNetDormancy();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "BangGuChaActorPoolSubsystem.generated.h"
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/Interface.h"
+#include "UObject/ObjectKey.h"
+
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class UBangGuChaPooledActor : public UInterface {
+  GENERATED_BODY()
+};
+
+// Optional hooks for actors recycled by UBangGuChaActorPoolSubsystem.
+// BeginPlay only runs once, so per-use state is reset here instead.
+class BANGGUCHA_API IBangGuChaPooledActor {
+  GENERATED_BODY()
+
+public:
+  // Called after the actor is moved into place and made visible again
+  virtual void OnAcquiredFromPool() {}
+
+  // Called before the actor is hidden and parked, including when it is
+  // first spawned by Prewarm
+  virtual void OnReturnedToPool() {}
+};
+
+USTRUCT(BlueprintType)
+struct FBangGuChaActorPoolStats {
+  GENERATED_BODY()
+
+  // Actors this pool has ever spawned
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 Spawned = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 Active = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 Free = 0;
+
+  // Most actors in use at once; a good prewarm size
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 HighWaterMark = 0;
+
+  // Acquires that found no free actor and had to spawn one
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 Misses = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Pool")
+  int32 Acquires = 0;
+};
+
+USTRUCT()
+struct FBangGuChaActorPoolBucket {
+  GENERATED_BODY()
+
+  UPROPERTY()
+  TArray<AActor *> Free;
+
+  FBangGuChaActorPoolStats Stats;
+};
+
+/**
+ * Per-class free lists of deactivated actors. Released actors are hidden,
+ * stripped of collision and tick, and parked out of sight instead of being
+ * destroyed, so short-lived actors like smoke do not churn the GC.
+ * Replicated actors go dormant while parked, so clients keep them too.
+ */
+UCLASS()
+class BANGGUCHA_API UBangGuChaActorPoolSubsystem : public UWorldSubsystem {
+  GENERATED_BODY()
+
+public:
+  // Spawns parked actors until Class has at least Count in the pool
+  void Prewarm(TSubclassOf<AActor> Class, int32 Count);
+
+  AActor *Acquire(TSubclassOf<AActor> Class, const FVector &Location,
+                  const FRotator &Rotation);
+
+  // Actors the pool did not hand out are destroyed instead
+  void Release(AActor *Actor);
+
+  // Releases every handed-out actor of exactly Class
+  void ReleaseAll(TSubclassOf<AActor> Class);
+
+  // Pool if the world has one, plain SpawnActor/Destroy otherwise
+  static AActor *AcquireOrSpawn(const UObject *WorldContextObject,
+                                TSubclassOf<AActor> Class,
+                                const FVector &Location,
+                                const FRotator &Rotation);
+  static void ReleaseOrDestroy(AActor *Actor);
+
+  UFUNCTION(BlueprintCallable, Category = "Pool")
+  FBangGuChaActorPoolStats GetPoolStats(TSubclassOf<AActor> Class) const;
+
+  void LogStats() const;
+
+protected:
+  virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+  AActor *SpawnPooled(UClass *Class, const FVector &Location,
+                      const FRotator &Rotation);
+  static void Deactivate(AActor *Actor);
+  static void Activate(AActor *Actor, const FVector &Location,
+                       const FRotator &Rotation);
+
+  UPROPERTY()
+  TMap<UClass *, FBangGuChaActorPoolBucket> Buckets;
+
+  // Handed-out actors, keyed safely against address reuse
+  TSet<FObjectKey> ActiveActors;
+
+  // ReleaseAll scratch; Release edits ActiveActors
+  TArray<AActor *> ReleaseScratch;
+};
@@ -1,13 +1,28 @@
 #include "BangGuChaEnemy.h"
+#include "BangGuCha.h"
+#include "BangGuChaEnemySubsystem.h"
 #include "BangGuChaGameModeBase.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaNet.h"
+#include "BangGuChaOverlapSubsystem.h"
 #include "BangGuChaPawn.h"
+#include "BangGuChaSignificanceSubsystem.h"
+#include "BangGuChaStats.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Sim/BangGuChaSimNet.h"
 
 ABangGuChaEnemy::ABangGuChaEnemy() {
   PrimaryActorTick.bCanEverTick = true;
 
+  // Position goes out as NetGridState instead of replicated movement. It
+  // changes a few times a second at most, so a low rate loses nothing.
+  SetReplicateMovement(false);
+  NetUpdateFrequency = 10.f;
+  MinNetUpdateFrequency = 2.f;
+
   CollisionComp = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionComp"));
   RootComponent = CollisionComp;
   CollisionComp->SetBoxExtent(FVector(40.f, 40.f, 40.f));
@@ -21,111 +36,188 @@ ABangGuChaEnemy::ABangGuChaEnemy() {
   StunDuration = 3.0f;
   bIsStunned = false;
   StunTimer = 0.f;
-
-  CurrentDirection = FVector(1, 0, 0); // Start moving somewhere
+  ManagedIndex = INDEX_NONE;
+  NetGridState = 0;
 }
 
 void ABangGuChaEnemy::BeginPlay() {
   Super::BeginPlay();
-  TargetLocation = GetActorLocation();
+  ResetMovement();
+  if (!HasAuthority() && NetGridState != 0) {
+    // The spawn bunch already carried the server's state
+    OnRep_NetGridState();
+  }
+  UpdateTickLOD(!IsManaged());
+  UBangGuChaOverlapSubsystem::Register(this);
 }
 
-void ABangGuChaEnemy::Tick(float DeltaTime) {
-  Super::Tick(DeltaTime);
+void ABangGuChaEnemy::GetLifetimeReplicatedProps(
+    TArray<FLifetimeProperty> &OutLifetimeProps) const {
+  Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-  if (bIsStunned) {
-    StunTimer -= DeltaTime;
-    if (StunTimer <= 0) {
-      bIsStunned = false;
-      // Resume movement logic if needed
-    }
-    return;
+  DOREPLIFETIME(ABangGuChaEnemy, NetGridState);
+  DOREPLIFETIME(ABangGuChaEnemy, bIsStunned);
+}
+
+bool ABangGuChaEnemy::IsNetRelevantFor(const AActor *RealViewer,
+                                       const AActor *ViewTarget,
+                                       const FVector &SrcLocation) const {
+  return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation) &&
+         BangGuChaIsWithinNetRelevantTiles(this, SrcLocation, GridSize);
+}
+
+void ABangGuChaEnemy::UpdateNetGridState() {
+  if (HasAuthority()) {
+    NetGridState = BangGuChaSim::PackNetGridState(Mover);
   }
+}
 
-  UpdateMovement(DeltaTime);
+void ABangGuChaEnemy::OnRep_NetGridState() {
+  BangGuChaSim::UnpackNetGridState(NetGridState, GridSize, Mover);
+  SetActorLocation(FVector(Mover.X, Mover.Y, GetActorLocation().Z));
+  if (Mover.Direction != BangGuChaSim::EDirection::None) {
+    MeshComp->SetWorldRotation(
+        BangGuChaDirectionToVector(Mover.Direction).Rotation());
+  }
 }
 
-void ABangGuChaEnemy::UpdateMovement(float DeltaTime) {
-  FVector CurrentLoc = GetActorLocation();
+void ABangGuChaEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+  UpdateTickLOD(false);
+  UBangGuChaOverlapSubsystem::Unregister(this);
+  Super::EndPlay(EndPlayReason);
+}
 
-  if (FVector::DistSquared(CurrentLoc, TargetLocation) < 10.f) {
-    SetActorLocation(TargetLocation);
-    ChooseNewDirection();
+void ABangGuChaEnemy::OnAcquiredFromPool() {
+  bIsStunned = false;
+  StunTimer = 0.f;
+  ResetMovement();
+  UpdateTickLOD(!IsManaged());
+  UBangGuChaOverlapSubsystem::Register(this);
+}
 
-    if (!CurrentDirection.IsZero()) {
-      TargetLocation = TargetLocation + CurrentDirection * GridSize;
-      MeshComp->SetWorldRotation(CurrentDirection.Rotation());
-    }
+void ABangGuChaEnemy::OnReturnedToPool() {
+  UpdateTickLOD(false);
+  UBangGuChaOverlapSubsystem::Unregister(this);
+}
+
+void ABangGuChaEnemy::UpdateTickLOD(bool bRegister) {
+  UBangGuChaSignificanceSubsystem *Significance =
+      GetWorld() ? GetWorld()->GetSubsystem<UBangGuChaSignificanceSubsystem>()
+                 : nullptr;
+  if (!Significance)
+    return;
+
+  if (bRegister) {
+    Significance->Register(this);
   } else {
-    FVector NewLoc = FMath::VInterpConstantTo(CurrentLoc, TargetLocation,
-                                              DeltaTime, MoveSpeed);
-    SetActorLocation(NewLoc);
+    Significance->Unregister(this);
   }
 }
 
-void ABangGuChaEnemy::ChooseNewDirection() {
-  // Simple AI: Try to move towards player, but stick to grid
-  APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
-  if (!PlayerPawn)
-    return;
+void ABangGuChaEnemy::ResetMovement() {
+  const FVector Location = GetActorLocation();
+  BangGuChaSim::InitMover(Mover, float(Location.X), float(Location.Y),
+                          GridSize);
+  Mover.Direction = BangGuChaSim::EDirection::PosX; // Start moving somewhere
+  UpdateNetGridState();
+}
 
-  FVector PlayerLoc = PlayerPawn->GetActorLocation();
-  FVector MyLoc = GetActorLocation();
-  FVector Diff = PlayerLoc - MyLoc;
+void ABangGuChaEnemy::Tick(float DeltaTime) {
+  BANGGUCHA_SCOPE(EnemyTick);
 
-  // Prefer axis with larger difference
-  FVector PreferredDir = (FMath::Abs(Diff.X) > FMath::Abs(Diff.Y))
-                             ? FVector(FMath::Sign(Diff.X), 0, 0)
-                             : FVector(0, FMath::Sign(Diff.Y), 0);
+  Super::Tick(DeltaTime);
 
-  // Try preferred direction
-  if (CanMoveTo(MyLoc + PreferredDir * GridSize)) {
-    CurrentDirection = PreferredDir;
+  if (!HasAuthority()) {
+    // Stun comes from the server; clients only move the proxy along
+    if (!bIsStunned) {
+      UpdateMovement(DeltaTime);
+    }
     return;
   }
 
-  // Try other axis
-  FVector SecondaryDir = (PreferredDir.X != 0)
-                             ? FVector(0, FMath::Sign(Diff.Y), 0)
-                             : FVector(FMath::Sign(Diff.X), 0, 0);
+  if (BangGuChaSim::TickStun(bIsStunned, StunTimer, DeltaTime)) {
+    if (!bIsStunned) {
+      // Clients held still for the stun; resync them as it ends
+      UpdateNetGridState();
+    }
+    return;
+  }
 
-  if (SecondaryDir.IsZero())
-    SecondaryDir = FVector(1, 0, 0); // Fallback
+  UpdateMovement(DeltaTime);
+}
 
-  if (CanMoveTo(MyLoc + SecondaryDir * GridSize)) {
-    CurrentDirection = SecondaryDir;
-    return;
+void ABangGuChaEnemy::UpdateMovement(float DeltaTime) {
+  // The sim rules substep internally, so a long tick-LOD frame still
+  // decides at every tile center it passes
+  const float Z = float(GetActorLocation().Z);
+  bool bNewTarget = false;
+  bool bTurned = false;
+  if (HasAuthority()) {
+    bNewTarget = BangGuChaSim::StepEnemyMover(
+        Mover, DeltaTime, MoveSpeed, GridSize, [this, &bTurned]() {
+          const BangGuChaSim::EDirection Dir = ChooseNewDirection();
+          bTurned |= Dir != Mover.Direction;
+          return Dir;
+        });
+  } else {
+    // Dead reckoning: straight on until the server says otherwise, which
+    // is what PackNetGridState senders assume
+    bNewTarget = BangGuChaSim::StepPlayerMover(
+        Mover, DeltaTime, MoveSpeed, GridSize, [this, Z](int32 X, int32 Y) {
+          return CanMoveTo(FVector(X * GridSize, Y * GridSize, Z));
+        });
   }
 
-  // If stuck, try random valid direction or reverse
-  TArray<FVector> Dirs = {FVector(1, 0, 0), FVector(-1, 0, 0), FVector(0, 1, 0),
-                          FVector(0, -1, 0)};
-  for (const FVector &Dir : Dirs) {
-    if (CanMoveTo(MyLoc + Dir * GridSize)) {
-      CurrentDirection = Dir;
-      return;
-    }
+  SetActorLocation(FVector(Mover.X, Mover.Y, Z));
+  if (bTurned) {
+    UpdateNetGridState();
   }
 
-  CurrentDirection = -CurrentDirection; // Reverse as last resort
+  if (bNewTarget) {
+    MeshComp->SetWorldRotation(
+        BangGuChaDirectionToVector(Mover.Direction).Rotation());
+  }
 }
 
-bool ABangGuChaEnemy::CanMoveTo(FVector NewLocation) {
-  FHitResult Hit;
-  FCollisionQueryParams Params;
-  Params.AddIgnoredActor(this);
+BangGuChaSim::EDirection ABangGuChaEnemy::ChooseNewDirection() {
+  BANGGUCHA_SCOPE(EnemyChooseNewDirection);
+
+  // Simple AI: Try to move towards player, but stick to grid
+  APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+  if (!PlayerPawn)
+    return Mover.Direction;
+
+  const FVector PlayerLoc = PlayerPawn->GetActorLocation();
+  const float Z = float(GetActorLocation().Z);
+  ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  BangGuChaSim::FHierarchicalPath *Clusters =
+      Map ? Map->GetHierarchicalPath() : nullptr;
+  if (Clusters) {
+    Clusters->Prepare(Mover.Target);
+  }
 
-  bool bHit = GetWorld()->SweepSingleByChannel(
-      Hit, GetActorLocation(), NewLocation, FQuat::Identity, ECC_WorldStatic,
-      FCollisionShape::MakeBox(FVector(40.f)), Params);
+  return BangGuChaSim::ChooseEnemyDirection(
+      Mover.Target, Mover.X, Mover.Y, Mover.Direction, float(PlayerLoc.X),
+      float(PlayerLoc.Y), Map ? Map->GetJunctionGraph() : nullptr, Clusters,
+      Map ? &Map->GetFlowField() : nullptr,
+      [this, Z](int32 X, int32 Y) {
+        return CanMoveTo(FVector(X * GridSize, Y * GridSize, Z));
+      });
+}
 
-  return !bHit;
+bool ABangGuChaEnemy::CanMoveTo(FVector NewLocation) {
+  if (const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this)) {
+    return Map->CanActorMoveTo(this, NewLocation);
+  }
+  return ABangGuChaMapGenerator::SweepCanMoveTo(this, NewLocation);
 }
 
 void ABangGuChaEnemy::NotifyActorBeginOverlap(AActor *OtherActor) {
+  BANGGUCHA_SCOPE(EnemyOverlap);
+
   Super::NotifyActorBeginOverlap(OtherActor);
 
-  if (bIsStunned)
+  if (bIsStunned || !HasAuthority())
     return;
 
   if (ABangGuChaPawn *Player = Cast<ABangGuChaPawn>(OtherActor)) {
@@ -138,6 +230,44 @@ void ABangGuChaEnemy::NotifyActorBeginOverlap(AActor *OtherActor) {
 }
 
 void ABangGuChaEnemy::Stun() {
-  bIsStunned = true;
-  StunTimer = StunDuration;
+  if (IsManaged()) {
+    if (UBangGuChaEnemySubsystem *Enemies =
+            GetWorld()->GetSubsystem<UBangGuChaEnemySubsystem>()) {
+      Enemies->StunEnemy(ManagedIndex);
+      bIsStunned = Enemies->IsEnemyStunned(ManagedIndex);
+    }
+    return;
+  }
+  BangGuChaSim::ApplyStun(bIsStunned, StunTimer, StunDuration);
+  UpdateNetGridState();
+}
+
+void ABangGuChaEnemy::SetManagedIndex(int32 Index) {
+  ManagedIndex = Index;
+  SetActorTickEnabled(!IsManaged());
+  UpdateTickLOD(!IsManaged());
+
+  if (!IsManaged()) {
+    // Resume self-ticking from wherever the proxy was left
+    const FVector Location = GetActorLocation();
+    BangGuChaSim::InitMover(Mover, float(Location.X), float(Location.Y),
+                            GridSize);
+  }
+}
+
+void ABangGuChaEnemy::ApplyManagedState(const BangGuChaSim::FMover &State,
+                                        bool bNewTarget, bool bStunned) {
+  const bool bChanged =
+      State.Direction != Mover.Direction || bStunned != bIsStunned;
+  Mover = State;
+  bIsStunned = bStunned;
+  if (bChanged) {
+    UpdateNetGridState();
+  }
+
+  SetActorLocation(FVector(State.X, State.Y, GetActorLocation().Z));
+  if (bNewTarget) {
+    MeshComp->SetWorldRotation(
+        BangGuChaDirectionToVector(State.Direction).Rotation());
+  }
 }
@@ -1,14 +1,17 @@
 #pragma once
 
 #include "BangGuChaEnemy.generated.h"
+#include "BangGuChaActorPoolSubsystem.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Sim/BangGuChaSimRules.h"
 
 class UBoxComponent;
 class UStaticMeshComponent;
 
 UCLASS()
-class BANGGUCHA_API ABangGuChaEnemy : public APawn {
+class BANGGUCHA_API ABangGuChaEnemy : public APawn,
+                                      public IBangGuChaPooledActor {
   GENERATED_BODY()
 
 public:
@@ -16,10 +19,18 @@ public:
 
 protected:
   virtual void BeginPlay() override;
+  virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
   virtual void Tick(float DeltaTime) override;
   virtual void NotifyActorBeginOverlap(AActor *OtherActor) override;
+  virtual void GetLifetimeReplicatedProps(
+      TArray<FLifetimeProperty> &OutLifetimeProps) const override;
+  virtual bool IsNetRelevantFor(const AActor *RealViewer,
+                                const AActor *ViewTarget,
+                                const FVector &SrcLocation) const override;
+  virtual void OnAcquiredFromPool() override;
+  virtual void OnReturnedToPool() override;
 
   // Components
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
@@ -36,7 +47,7 @@ public:
   float GridSize;
 
   // State
-  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "State")
+  UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "State")
   bool bIsStunned;
 
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State")
@@ -45,12 +56,35 @@ public:
   UFUNCTION(BlueprintCallable, Category = "State")
   void Stun();
 
+  // Managed mode: UBangGuChaEnemySubsystem simulates this enemy and the
+  // actor is only a visual proxy. INDEX_NONE returns it to self-ticking.
+  void SetManagedIndex(int32 Index);
+  bool IsManaged() const { return ManagedIndex != INDEX_NONE; }
+
+  void ApplyManagedState(const BangGuChaSim::FMover &State, bool bNewTarget,
+                         bool bStunned);
+
 private:
-  FVector TargetLocation;
-  FVector CurrentDirection;
+  int32 ManagedIndex;
+
+  // Grid movement state, advanced by the shared sim rules
+  BangGuChaSim::FMover Mover;
   float StunTimer;
 
+  // Mover packed by BangGuChaSim::PackNetGridState. The server only
+  // rewrites it when the direction or stun changes; clients dead-reckon in
+  // between, so a chaser running down a corridor sends nothing.
+  UPROPERTY(ReplicatedUsing = OnRep_NetGridState)
+  uint32 NetGridState;
+
+  UFUNCTION()
+  void OnRep_NetGridState();
+  void UpdateNetGridState();
+
+  void ResetMovement();
+  // Self-ticking enemies get their tick rate from the significance system
+  void UpdateTickLOD(bool bRegister);
   void UpdateMovement(float DeltaTime);
-  void ChooseNewDirection();
+  BangGuChaSim::EDirection ChooseNewDirection();
   bool CanMoveTo(FVector NewLocation);
 };
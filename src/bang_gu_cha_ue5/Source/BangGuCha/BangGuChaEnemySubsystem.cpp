@@ -0,0 +1,175 @@
+#include "BangGuChaEnemySubsystem.h"
+#include "BangGuCha.h"
+#include "BangGuChaEnemy.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaStats.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<int32> CVarBangGuChaEnemyBatchSize(
+    TEXT("bgc.EnemyBatchSize"), 256,
+    TEXT("Managed enemies stepped per worker task. Swarms of at most this ")
+        TEXT("many run on the game thread; 0 always does."),
+    ECVF_Default);
+
+void UBangGuChaEnemySubsystem::Tick(float DeltaTime) {
+  BANGGUCHA_SCOPE(EnemyManagerTick);
+
+  Super::Tick(DeltaTime);
+
+  if (Swarm.Num() == 0)
+    return;
+
+  ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+  if (!Map || !Map->GetOccupancy().IsValid() || !PlayerPawn)
+    return;
+
+  // The map, pathing and player only change on the game thread, which
+  // waits in ParallelFor, so every task sees the same snapshot. Clusters
+  // are flooded here for the same reason.
+  BangGuChaSim::FHierarchicalPath *Clusters = Map->GetHierarchicalPath();
+  if (Clusters) {
+    Swarm.PreparePaths(DeltaTime, Params, *Clusters);
+  }
+  const FVector PlayerLoc = PlayerPawn->GetActorLocation();
+  const BangGuChaSim::FEnemySwarmSnapshot Snapshot{
+      float(PlayerLoc.X), float(PlayerLoc.Y), &Map->GetOccupancy(),
+      &Map->GetFlowField(), Map->GetJunctionGraph(), Clusters};
+  const int32 BatchSize = CVarBangGuChaEnemyBatchSize.GetValueOnGameThread();
+  Swarm.AdvanceParallel(DeltaTime, Params, Snapshot,
+                        size_t(FMath::Max(BatchSize, 0)),
+                        [](int32 Num, const auto &Body) {
+                          ParallelFor(Num,
+                                      [&Body](int32 Index) { Body(Index); });
+                        });
+
+  WriteBackProxies();
+  WriteBackInstances();
+}
+
+TStatId UBangGuChaEnemySubsystem::GetStatId() const {
+  RETURN_QUICK_DECLARE_CYCLE_STAT(UBangGuChaEnemySubsystem,
+                                  STATGROUP_Tickables);
+}
+
+bool UBangGuChaEnemySubsystem::DoesSupportWorldType(
+    EWorldType::Type WorldType) const {
+  return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBangGuChaEnemySubsystem::Configure(float InMoveSpeed,
+                                         float InStunDuration,
+                                         float InGridSize) {
+  Params.MoveSpeed = InMoveSpeed;
+  Params.GridSize = InGridSize;
+  StunDuration = InStunDuration;
+}
+
+void UBangGuChaEnemySubsystem::Reset() {
+  for (const TWeakObjectPtr<ABangGuChaEnemy> &Proxy : Proxies) {
+    if (Proxy.IsValid()) {
+      Proxy->SetManagedIndex(INDEX_NONE);
+    }
+  }
+  Swarm.Reset();
+  Proxies.Reset();
+  SetInstancedVisuals(nullptr, FTransform::Identity, 0.f);
+}
+
+void UBangGuChaEnemySubsystem::SetInstancedVisuals(
+    UInstancedStaticMeshComponent *Instances, const FTransform &MeshTransform,
+    float Height) {
+  if (UInstancedStaticMeshComponent *Previous = EnemyInstances.Get()) {
+    Previous->ClearInstances();
+  }
+  EnemyInstances = Instances;
+  InstanceMeshTransform = MeshTransform;
+  InstanceHeight = Height;
+  if (Instances) {
+    Instances->ClearInstances();
+  }
+}
+
+int32 UBangGuChaEnemySubsystem::AddEnemy(const FIntPoint &Tile,
+                                         ABangGuChaEnemy *Proxy) {
+  const int32 Index = int32(
+      Swarm.Add(BangGuChaSim::FTile{Tile.X, Tile.Y}, Params.GridSize));
+  Proxies.Add(Proxy);
+  if (Proxy) {
+    Proxy->SetManagedIndex(Index);
+  }
+  return Index;
+}
+
+void UBangGuChaEnemySubsystem::StunEnemy(int32 Index) {
+  if (Proxies.IsValidIndex(Index)) {
+    Swarm.Stun(Index, StunDuration);
+  }
+}
+
+bool UBangGuChaEnemySubsystem::IsEnemyStunned(int32 Index) const {
+  return Proxies.IsValidIndex(Index) && Swarm.bIsStunned[Index] != 0;
+}
+
+void UBangGuChaEnemySubsystem::WriteBackProxies() {
+  for (int32 i = 0; i < Proxies.Num(); i++) {
+    if (ABangGuChaEnemy *Proxy = Proxies[i].Get()) {
+      BangGuChaSim::FMover State;
+      State.X = Swarm.X[i];
+      State.Y = Swarm.Y[i];
+      State.Target = BangGuChaSim::FTile{Swarm.TargetX[i], Swarm.TargetY[i]};
+      State.Direction = Swarm.Direction[i];
+      State.Remaining = Swarm.Remaining[i];
+      Proxy->ApplyManagedState(State, Swarm.bNewTarget[i] != 0,
+                               Swarm.bIsStunned[i] != 0);
+    }
+  }
+}
+
+void UBangGuChaEnemySubsystem::WriteBackInstances() {
+  UInstancedStaticMeshComponent *Instances = EnemyInstances.Get();
+  if (!Instances)
+    return;
+
+  BANGGUCHA_SCOPE(EnemyInstances);
+
+  const int32 Num = GetNumEnemies();
+  InstanceTransforms.SetNumUninitialized(Num, false);
+  InstanceYaw.SetNumZeroed(Num, false);
+  for (int32 i = 0; i < Num; i++) {
+    // Like the proxies, an enemy keeps facing its last move while it waits
+    if (Swarm.bNewTarget[i]) {
+      InstanceYaw[i] = float(
+          BangGuChaDirectionToVector(Swarm.Direction[i]).Rotation().Yaw);
+    }
+    InstanceTransforms[i] =
+        InstanceMeshTransform *
+        FTransform(FRotator(0.f, InstanceYaw[i], 0.f),
+                   FVector(Swarm.X[i], Swarm.Y[i], InstanceHeight));
+  }
+
+  // Instances are only added when the swarm grows, all in one go; every
+  // other frame moves them in place
+  if (Instances->GetInstanceCount() != Num) {
+    Instances->ClearInstances();
+    Instances->AddInstances(InstanceTransforms, false, true);
+    InstanceStunned.Init(0xff, Num);
+  } else {
+    Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true,
+                                              false, true);
+  }
+
+  for (int32 i = 0; i < Num; i++) {
+    const uint8 bStunned = Swarm.bIsStunned[i];
+    if (InstanceStunned[i] != bStunned) {
+      InstanceStunned[i] = bStunned;
+      Instances->SetCustomDataValue(i, 0, bStunned ? 1.f : 0.f, false);
+    }
+  }
+
+  // One render state update for the transforms and custom data together
+  Instances->MarkRenderStateDirty();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "BangGuChaEnemySubsystem.generated.h"
+#include "CoreMinimal.h"
+#include "Sim/BangGuChaSimEnemySwarm.h"
+#include "Subsystems/WorldSubsystem.h"
+
+class ABangGuChaEnemy;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Central enemy manager. Keeps every managed enemy in struct-of-arrays form
+ * (BangGuChaSim::FEnemySwarm), advances them all in one pass per frame, and
+ * then writes transforms to the optional ABangGuChaEnemy visual proxies in
+ * a single loop. Managed proxies do not tick themselves.
+ *
+ * With instanced visuals set, every enemy is instead drawn as an instance
+ * of one component, moved with one batched transform update per frame.
+ * Custom data float 0 is 1 while the enemy is stunned.
+ */
+UCLASS()
+class BANGGUCHA_API UBangGuChaEnemySubsystem : public UTickableWorldSubsystem {
+  GENERATED_BODY()
+
+public:
+  virtual void Tick(float DeltaTime) override;
+  virtual TStatId GetStatId() const override;
+
+  void Configure(float InMoveSpeed, float InStunDuration, float InGridSize);
+  void Reset();
+
+  // Proxy may be null for enemies without an actor
+  int32 AddEnemy(const FIntPoint &Tile, ABangGuChaEnemy *Proxy);
+
+  // Draws every managed enemy as an instance of Instances from now on;
+  // null goes back to proxies only. MeshTransform places the mesh relative
+  // to the enemy's location at Height above the floor.
+  void SetInstancedVisuals(UInstancedStaticMeshComponent *Instances,
+                           const FTransform &MeshTransform, float Height);
+
+  void StunEnemy(int32 Index);
+  bool IsEnemyStunned(int32 Index) const;
+
+  int32 GetNumEnemies() const { return int32(Swarm.Num()); }
+  const BangGuChaSim::FEnemySwarm &GetSwarm() const { return Swarm; }
+  // For UBangGuChaOverlapSubsystem, which keeps its per-enemy overlap state
+  // in the swarm; never add or remove enemies through it
+  BangGuChaSim::FEnemySwarm &GetMutableSwarm() { return Swarm; }
+
+protected:
+  virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+  void WriteBackProxies();
+  void WriteBackInstances();
+
+  BangGuChaSim::FEnemySwarm Swarm;
+  BangGuChaSim::FEnemySwarmParams Params;
+  float StunDuration = 3.f;
+
+  // Parallel to the swarm arrays
+  TArray<TWeakObjectPtr<ABangGuChaEnemy>> Proxies;
+
+  TWeakObjectPtr<UInstancedStaticMeshComponent> EnemyInstances;
+  FTransform InstanceMeshTransform;
+  float InstanceHeight = 0.f;
+  // Parallel to the swarm arrays and kept between frames, so the update
+  // does not allocate. Stun flags are only pushed when they change.
+  TArray<FTransform> InstanceTransforms;
+  TArray<float> InstanceYaw;
+  TArray<uint8> InstanceStunned;
+};
@@ -1,10 +1,35 @@
 #include "BangGuChaGameModeBase.h"
+#include "BangGuChaActorPoolSubsystem.h"
+#include "BangGuChaGameState.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaPawn.h"
+#include "BangGuChaStats.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
+#include "Sim/BangGuChaSimRules.h"
+#include "TimerManager.h"
+
+namespace {
+// A restart should fit in one frame at 60 Hz
+constexpr float RestartBudgetMs = 1000.f / 60.f;
+} // namespace
 
 ABangGuChaGameModeBase::ABangGuChaGameModeBase() {
   Score = 0;
   CollectedFlags = 0;
   TotalFlags = 0; // Should be set by MapGenerator
+  MapGenerator = nullptr;
+  bRestartOnGameOver = true;
+  bRestartOnVictory = true;
+  bNewLayoutOnVictory = true;
+  LastRestartMs = 0.f;
+  LastRestartWaitMs = 0.f;
+  bRestartQueued = false;
+  MatchEndTime = 0.0;
+
+  GameStateClass = ABangGuChaGameState::StaticClass();
+  DefaultPawnClass = ABangGuChaPawn::StaticClass();
 }
 
 void ABangGuChaGameModeBase::BeginPlay() {
@@ -12,26 +37,131 @@ void ABangGuChaGameModeBase::BeginPlay() {
   UE_LOG(LogTemp, Warning, TEXT("BangGuCha Game Started!"));
 }
 
-void ABangGuChaGameModeBase::AddScore(int32 Amount) { Score += Amount; }
+APawn *ABangGuChaGameModeBase::SpawnDefaultPawnAtTransform_Implementation(
+    AController *NewPlayer, const FTransform &SpawnTransform) {
+  // Generated levels have no player starts: everyone begins on the layout's
+  // start tile, and co-op players share it. Players can log in before the
+  // generator's BeginPlay has registered it.
+  const ABangGuChaMapGenerator *Map = MapGenerator;
+  if (!Map) {
+    TActorIterator<ABangGuChaMapGenerator> It(GetWorld());
+    Map = It ? *It : nullptr;
+  }
+
+  FTransform Transform = SpawnTransform;
+  if (Map) {
+    const BangGuChaSim::FTile Start = Map->GetLayout().PlayerStart;
+    Transform.SetLocation(Map->TileToWorld(Start.X, Start.Y));
+  }
+
+  FActorSpawnParameters SpawnInfo;
+  SpawnInfo.Instigator = GetInstigator();
+  SpawnInfo.ObjectFlags |= RF_Transient;
+  SpawnInfo.SpawnCollisionHandlingOverride =
+      ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+  return GetWorld()->SpawnActor<APawn>(
+      GetDefaultPawnClassForController(NewPlayer), Transform, SpawnInfo);
+}
+
+void ABangGuChaGameModeBase::AddScore(int32 Amount) {
+  Score += Amount;
+  UpdateGameState();
+}
 
 void ABangGuChaGameModeBase::OnFlagCollected() {
-  CollectedFlags++;
-  AddScore(100);
+  BangGuChaSim::CollectFlag(Score, CollectedFlags);
+  UpdateGameState();
   CheckWinCondition();
 }
 
+void ABangGuChaGameModeBase::SetTotalFlags(int32 Count) {
+  TotalFlags = Count;
+  UpdateGameState();
+}
+
+void ABangGuChaGameModeBase::UpdateGameState() {
+  if (ABangGuChaGameState *State = GetGameState<ABangGuChaGameState>()) {
+    State->Score = Score;
+    State->TotalFlags = TotalFlags;
+    State->CollectedFlags = CollectedFlags;
+  }
+}
+
 void ABangGuChaGameModeBase::CheckWinCondition() {
-  if (TotalFlags > 0 && CollectedFlags >= TotalFlags) {
+  if (BangGuChaSim::HasCollectedAllFlags(CollectedFlags, TotalFlags)) {
     Victory();
   }
 }
 
 void ABangGuChaGameModeBase::GameOver() {
   UE_LOG(LogTemp, Warning, TEXT("GAME OVER!"));
-  // Implement UI logic or restart here
+  if (bRestartOnGameOver) {
+    QueueRestart(false);
+  }
 }
 
 void ABangGuChaGameModeBase::Victory() {
   UE_LOG(LogTemp, Warning, TEXT("VICTORY!"));
-  // Implement UI logic or restart here
+  if (bRestartOnVictory) {
+    QueueRestart(bNewLayoutOnVictory);
+  }
+}
+
+void ABangGuChaGameModeBase::QueueRestart(bool bNewLayout) {
+  // Several enemies can catch the player in the same pass
+  if (bRestartQueued)
+    return;
+  bRestartQueued = true;
+  MatchEndTime = FPlatformTime::Seconds();
+  GetWorldTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(
+      this, &ABangGuChaGameModeBase::RestartMatch, bNewLayout));
+}
+
+void ABangGuChaGameModeBase::RestartMatch(bool bNewLayout) {
+  BANGGUCHA_SCOPE(MatchRestart);
+
+  const double StartTime = FPlatformTime::Seconds();
+  const double EndTime = bRestartQueued ? MatchEndTime : StartTime;
+  bRestartQueued = false;
+
+  // Cleared first: the map reports the new flag count as it restarts
+  Score = 0;
+  CollectedFlags = 0;
+  if (!MapGenerator || !MapGenerator->RestartMap(bNewLayout)) {
+    UE_LOG(LogTemp, Warning, TEXT("RestartMatch: no map ready to restart"));
+    UpdateGameState();
+    return;
+  }
+  UpdateGameState();
+
+  const BangGuChaSim::FTile Start = MapGenerator->GetLayout().PlayerStart;
+  const FVector StartLocation = MapGenerator->TileToWorld(Start.X, Start.Y);
+  UBangGuChaActorPoolSubsystem *Pool =
+      GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>();
+  for (FConstPlayerControllerIterator It =
+           GetWorld()->GetPlayerControllerIterator();
+       It; ++It) {
+    ABangGuChaPawn *Pawn =
+        It->IsValid() ? Cast<ABangGuChaPawn>((*It)->GetPawn()) : nullptr;
+    if (!Pawn)
+      continue;
+    if (Pool) {
+      Pool->ReleaseAll(Pawn->SmokeClass.Get());
+    }
+    Pawn->Respawn(StartLocation);
+  }
+
+  const double Now = FPlatformTime::Seconds();
+  LastRestartMs = float((Now - StartTime) * 1000.0);
+  LastRestartWaitMs = float((Now - EndTime) * 1000.0);
+  UE_LOG(LogTemp, Log,
+         TEXT("RestartMatch (%s layout): %.2f ms, playable %.2f ms after "
+              "the match ended"),
+         bNewLayout ? TEXT("new") : TEXT("same"), LastRestartMs,
+         LastRestartWaitMs);
+  if (LastRestartMs > RestartBudgetMs) {
+    UE_LOG(LogTemp, Warning,
+           TEXT("RestartMatch took %.2f ms, over the %.2f ms frame budget"),
+           LastRestartMs, RestartBudgetMs);
+  }
 }
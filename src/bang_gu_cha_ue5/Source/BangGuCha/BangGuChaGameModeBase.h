@@ -4,6 +4,8 @@
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
 
+class ABangGuChaMapGenerator;
+
 /**
  *
  */
@@ -15,6 +17,8 @@ public:
   ABangGuChaGameModeBase();
 
   virtual void BeginPlay() override;
+  virtual APawn *SpawnDefaultPawnAtTransform_Implementation(
+      AController *NewPlayer, const FTransform &SpawnTransform) override;
 
   // Game State
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Game State")
@@ -26,18 +30,61 @@ public:
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Game State")
   int32 CollectedFlags;
 
+  // Registered by the map generator; owns the tile occupancy used for movement
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Game State")
+  ABangGuChaMapGenerator *MapGenerator;
+
   UFUNCTION(BlueprintCallable, Category = "Game Logic")
   void AddScore(int32 Amount);
 
   UFUNCTION(BlueprintCallable, Category = "Game Logic")
   void OnFlagCollected();
 
+  // Called by the map generator once a layout is known
+  void SetTotalFlags(int32 Count);
+
   UFUNCTION(BlueprintCallable, Category = "Game Logic")
   void GameOver();
 
   UFUNCTION(BlueprintCallable, Category = "Game Logic")
   void Victory();
 
+  // Starts a new match in place: the map puts its flags and enemies back,
+  // players return to the start tile with a full tank and the counters
+  // reset. Nothing is destroyed or garbage collected.
+  UFUNCTION(BlueprintCallable, Category = "Game Logic")
+  void RestartMatch(bool bNewLayout);
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Restart")
+  bool bRestartOnGameOver;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Restart")
+  bool bRestartOnVictory;
+
+  // Play the next seed's map after a win instead of the same one again
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Restart",
+            meta = (EditCondition = "bRestartOnVictory"))
+  bool bNewLayoutOnVictory;
+
+  // Stats from the last restart. The wait includes the frame between the
+  // match ending and the restart running.
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Restart")
+  float LastRestartMs;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Restart")
+  float LastRestartWaitMs;
+
 protected:
   void CheckWinCondition();
+
+  // Game over and victory are reported from inside the overlap passes,
+  // which a restart would change under them, so it runs next frame
+  void QueueRestart(bool bNewLayout);
+
+  // Copies the counters to ABangGuChaGameState for clients
+  void UpdateGameState();
+
+private:
+  bool bRestartQueued;
+  double MatchEndTime;
 };
@@ -0,0 +1,18 @@
+#include "BangGuChaGameState.h"
+#include "Net/UnrealNetwork.h"
+
+ABangGuChaGameState::ABangGuChaGameState() {
+  Score = 0;
+  TotalFlags = 0;
+  CollectedFlags = 0;
+  MapGenerator = nullptr;
+}
+
+void ABangGuChaGameState::GetLifetimeReplicatedProps(
+    TArray<FLifetimeProperty> &OutLifetimeProps) const {
+  Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+  DOREPLIFETIME(ABangGuChaGameState, Score);
+  DOREPLIFETIME(ABangGuChaGameState, TotalFlags);
+  DOREPLIFETIME(ABangGuChaGameState, CollectedFlags);
+}
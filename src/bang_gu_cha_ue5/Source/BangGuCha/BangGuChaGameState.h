@@ -0,0 +1,40 @@
+#pragma once
+
+#include "BangGuChaGameState.generated.h"
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+
+class ABangGuChaMapGenerator;
+
+/**
+ * Match state every machine can read. The game mode owns the counters and
+ * mirrors them here for clients.
+ */
+UCLASS()
+class BANGGUCHA_API ABangGuChaGameState : public AGameStateBase {
+  GENERATED_BODY()
+
+public:
+  ABangGuChaGameState();
+
+  virtual void GetLifetimeReplicatedProps(
+      TArray<FLifetimeProperty> &OutLifetimeProps) const override;
+
+  UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly,
+            Category = "Game State")
+  int32 Score;
+
+  UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly,
+            Category = "Game State")
+  int32 TotalFlags;
+
+  UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly,
+            Category = "Game State")
+  int32 CollectedFlags;
+
+  // Registered locally by the map generator, so clients (which have no game
+  // mode) can find it too
+  UPROPERTY(Transient, VisibleAnywhere, BlueprintReadOnly,
+            Category = "Game State")
+  ABangGuChaMapGenerator *MapGenerator;
+};
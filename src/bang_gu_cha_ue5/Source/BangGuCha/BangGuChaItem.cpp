@@ -1,11 +1,23 @@
 #include "BangGuChaItem.h"
+#include "BangGuChaActorPoolSubsystem.h"
 #include "BangGuChaGameModeBase.h"
+#include "BangGuChaOverlapSubsystem.h"
 #include "BangGuChaPawn.h"
+#include "BangGuChaSignificanceSubsystem.h"
+#include "BangGuChaStats.h"
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 
 ABangGuChaItem::ABangGuChaItem() {
-  PrimaryActorTick.bCanEverTick = true; // Maybe for rotation animation
+  // Flags do nothing per frame; pickup is driven by overlap events or by
+  // UBangGuChaOverlapSubsystem
+  PrimaryActorTick.bCanEverTick = false;
+
+  // Replicated once, then dormant; the pool wakes a flag when it is picked
+  // up or reused
+  bReplicates = true;
+  SetReplicateMovement(true);
+  NetDormancy = DORM_DormantAll;
 
   CollisionComp =
       CreateDefaultSubobject<USphereComponent>(TEXT("CollisionComp"));
@@ -17,16 +29,56 @@ ABangGuChaItem::ABangGuChaItem() {
   MeshComp->SetupAttachment(RootComponent);
 }
 
-void ABangGuChaItem::BeginPlay() { Super::BeginPlay(); }
+void ABangGuChaItem::BeginPlay() {
+  Super::BeginPlay();
+  UpdateTickLOD(true);
+  UBangGuChaOverlapSubsystem::Register(this);
+}
+
+void ABangGuChaItem::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+  UpdateTickLOD(false);
+  UBangGuChaOverlapSubsystem::Unregister(this);
+  Super::EndPlay(EndPlayReason);
+}
+
+void ABangGuChaItem::OnAcquiredFromPool() {
+  UpdateTickLOD(true);
+  UBangGuChaOverlapSubsystem::Register(this);
+}
+
+void ABangGuChaItem::OnReturnedToPool() {
+  UpdateTickLOD(false);
+  UBangGuChaOverlapSubsystem::Unregister(this);
+}
+
+void ABangGuChaItem::UpdateTickLOD(bool bRegister) {
+  UBangGuChaSignificanceSubsystem *Significance =
+      GetWorld() ? GetWorld()->GetSubsystem<UBangGuChaSignificanceSubsystem>()
+                 : nullptr;
+  if (!Significance)
+    return;
+
+  if (bRegister) {
+    Significance->Register(this, true);
+  } else {
+    Significance->Unregister(this);
+  }
+}
 
 void ABangGuChaItem::NotifyActorBeginOverlap(AActor *OtherActor) {
+  BANGGUCHA_SCOPE(ItemOverlap);
+
   Super::NotifyActorBeginOverlap(OtherActor);
 
-  if (Cast<ABangGuChaPawn>(OtherActor)) {
-    if (ABangGuChaGameModeBase *GM =
-            Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode())) {
-      GM->OnFlagCollected();
-    }
-    Destroy();
+  if (HasAuthority() && Cast<ABangGuChaPawn>(OtherActor)) {
+    Collect();
+  }
+}
+
+void ABangGuChaItem::Collect() {
+  if (ABangGuChaGameModeBase *GM =
+          Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode())) {
+    GM->OnFlagCollected();
   }
+  UBangGuChaActorPoolSubsystem::ReleaseOrDestroy(this);
 }
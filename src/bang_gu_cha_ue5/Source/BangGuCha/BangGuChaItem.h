@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BangGuChaItem.generated.h"
+#include "BangGuChaActorPoolSubsystem.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 
@@ -8,7 +9,8 @@ class USphereComponent;
 class UStaticMeshComponent;
 
 UCLASS()
-class BANGGUCHA_API ABangGuChaItem : public AActor {
+class BANGGUCHA_API ABangGuChaItem : public AActor,
+                                     public IBangGuChaPooledActor {
   GENERATED_BODY()
 
 public:
@@ -16,13 +18,23 @@ public:
 
 protected:
   virtual void BeginPlay() override;
+  virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
   virtual void NotifyActorBeginOverlap(AActor *OtherActor) override;
+  virtual void OnAcquiredFromPool() override;
+  virtual void OnReturnedToPool() override;
+
+  // Scores the flag and puts it back in the pool; server only
+  void Collect();
 
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
   USphereComponent *CollisionComp;
 
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
   UStaticMeshComponent *MeshComp;
+
+private:
+  // Counted in the significance system's Static bucket while in play
+  void UpdateTickLOD(bool bRegister);
 };
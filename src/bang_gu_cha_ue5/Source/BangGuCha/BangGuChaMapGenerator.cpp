@@ -1,75 +1,1033 @@
 #include "BangGuChaMapGenerator.h"
+#include "BangGuChaActorPoolSubsystem.h"
+#include "BangGuChaEnemy.h"
+#include "BangGuChaEnemySubsystem.h"
 #include "BangGuChaGameModeBase.h"
+#include "BangGuChaGameState.h"
+#include "BangGuChaStats.h"
+#include "BangGuChaWall.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Net/UnrealNetwork.h"
+#include "Sim/BangGuChaSimLevelFile.h"
+#include "Sim/BangGuChaSimNet.h"
+#include "Sim/BangGuChaSimRules.h"
+
+static TAutoConsoleVariable<int32> CVarBangGuChaSweepCrossCheck(
+    TEXT("bgc.DebugSweepCrossCheck"), 0,
+    TEXT("Also run the legacy physics sweep for every grid move query and ")
+        TEXT("log when it disagrees with the occupancy bitmap."),
+    ECVF_Cheat);
+
+// Safe off the game thread, so chunked generation can fill the cache from
+// its worker
+static bool WriteLevelFile(const FString &Path,
+                           const BangGuChaSim::FMapLayout &Layout,
+                           uint64 Seed, uint64 CacheKey) {
+  std::vector<uint8_t> Bytes;
+  BangGuChaSim::WriteLevel(Layout, Seed, CacheKey, Bytes);
+  return FFileHelper::SaveArrayToFile(
+      TArrayView<const uint8>(Bytes.data(), int32(Bytes.size())), *Path);
+}
+
+// Writes a cache entry, then deletes the oldest entries beyond MaxFiles.
+// Runs on a worker; the cache is only ever read on a later GenerateMap.
+static void WriteLevelCacheFile(const FString &Path,
+                                const BangGuChaSim::FMapLayout &Layout,
+                                uint64 Seed, uint64 CacheKey,
+                                int32 MaxFiles) {
+  if (!WriteLevelFile(Path, Layout, Seed, CacheKey))
+    return;
+
+  IFileManager &FileManager = IFileManager::Get();
+  const FString Dir = FPaths::GetPath(Path);
+  TArray<FString> Names;
+  FileManager.FindFiles(Names, *Dir, TEXT("bgcl"));
+  if (Names.Num() <= MaxFiles)
+    return;
+
+  TArray<TPair<FDateTime, FString>> Entries;
+  Entries.Reserve(Names.Num());
+  for (const FString &Name : Names) {
+    const FString EntryPath = FPaths::Combine(Dir, Name);
+    Entries.Emplace(FileManager.GetTimeStamp(*EntryPath), EntryPath);
+  }
+  Entries.Sort([](const TPair<FDateTime, FString> &A,
+                  const TPair<FDateTime, FString> &B) {
+    return A.Key < B.Key;
+  });
+  for (int32 Index = 0; Index < Entries.Num() - MaxFiles; Index++) {
+    FileManager.Delete(*Entries[Index].Value, false, false, true);
+  }
+}
 
 ABangGuChaMapGenerator::ABangGuChaMapGenerator() {
-  PrimaryActorTick.bCanEverTick = false;
+  PrimaryActorTick.bCanEverTick = true;
+
+  // Only the seed and params ever change, and only on regeneration
+  bReplicates = true;
+  bAlwaysRelevant = true;
+  NetUpdateFrequency = 1.f;
+
+  // Instances are placed in world space, independent of where the generator
+  // actor sits in the level
+  WallInstances =
+      CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(
+          TEXT("WallInstances"));
+  RootComponent = WallInstances;
+  WallInstances->SetUsingAbsoluteLocation(true);
+  WallInstances->SetUsingAbsoluteRotation(true);
+  WallInstances->SetUsingAbsoluteScale(true);
+  WallInstances->SetMobility(EComponentMobility::Static);
+  WallInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+  // Moved every frame by UBangGuChaEnemySubsystem, so a plain ISM: a HISM
+  // would rebuild its cluster tree on each update
+  EnemyInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(
+      TEXT("EnemyInstances"));
+  EnemyInstances->SetupAttachment(RootComponent);
+  EnemyInstances->SetUsingAbsoluteLocation(true);
+  EnemyInstances->SetUsingAbsoluteRotation(true);
+  EnemyInstances->SetUsingAbsoluteScale(true);
+  EnemyInstances->SetMobility(EComponentMobility::Movable);
+  EnemyInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+  EnemyInstances->NumCustomDataFloats = 1;
+
+  WallMode = EBangGuChaWallMode::Actors;
+  WallMesh = nullptr;
+  bInstancedWallCollision = true;
+  LastGenerateMs = 0.f;
+  LastSpawnedActors = 0;
+  TimeToPlayableSeconds = 0.f;
 
   MapWidth = 20;
   MapHeight = 15;
   GridSize = 100.f;
+  WallChance = 0.1f;
+  ItemChance = 0.05f;
+  MapStyle = EBangGuChaMapStyle::Scatter;
+  BraidChance = 0.5f;
+  bEnsureReachable = true;
+  Seed = 0;
+  GeneratedSeed = 0;
+  bUseEnemyManager = false;
+  bSpawnEnemyProxies = true;
+  bInstancedEnemies = false;
+  EnemyMesh = nullptr;
+  SwarmEnemyCount = 0;
+  Pathing = EBangGuChaPathing::JunctionGraph;
+  bGridOverlaps = true;
+  bSmokeField = false;
+  SmokeAmount = 1.f;
+  SmokeSpreadRate = 0.5f;
+  SmokeFadeRate = 0.5f;
+  SmokeStunDensity = 0.1f;
+  NewSmokeFrame = 0;
+  FlowFieldTilesPerTick = 16384; // A quarter of a 256x256 map per frame
+  bUseLevelCache = false;
+  MaxLevelCacheFiles = 32;
+  NewLayoutCount = 0;
+  PathClusterSize = 16;
+
+  bChunkedGeneration = false;
+  ChunkSize = 64;
+  SpawnBudgetMs = 2.f;
+  PendingChunks = 0;
+  NextChunk = 0;
+  NextInChunk = 0;
+  GenerateStartTime = 0.0;
+  LayoutReadyTime = 0.0;
+  ActorsBeforeGenerate = 0;
+  StreamFrames = 0;
+  bInstancedWallsReady = false;
+  BeginPlayTime = 0.0;
+  ClassesLoadedTime = 0.0;
+  bWallsPending = false;
+  bFlagsPending = false;
+  bEnemiesPending = false;
+  LastWallCount = 0;
 }
 
 void ABangGuChaMapGenerator::BeginPlay() {
   Super::BeginPlay();
-  GenerateMap();
+  BeginPlayTime = FPlatformTime::Seconds();
+  // The classes stream in while the layout is built below
+  RequestClassLoads();
+  // Clients wait for the server's seed unless it arrived with the actor
+  if (HasAuthority() || GeneratedSeed != 0) {
+    GenerateMap();
+  }
+}
+
+void ABangGuChaMapGenerator::GetLifetimeReplicatedProps(
+    TArray<FLifetimeProperty> &OutLifetimeProps) const {
+  Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+  DOREPLIFETIME(ABangGuChaMapGenerator, MapWidth);
+  DOREPLIFETIME(ABangGuChaMapGenerator, MapHeight);
+  DOREPLIFETIME(ABangGuChaMapGenerator, GridSize);
+  DOREPLIFETIME(ABangGuChaMapGenerator, WallChance);
+  DOREPLIFETIME(ABangGuChaMapGenerator, ItemChance);
+  DOREPLIFETIME(ABangGuChaMapGenerator, MapStyle);
+  DOREPLIFETIME(ABangGuChaMapGenerator, BraidChance);
+  DOREPLIFETIME(ABangGuChaMapGenerator, bEnsureReachable);
+  DOREPLIFETIME(ABangGuChaMapGenerator, GeneratedSeed);
+  DOREPLIFETIME(ABangGuChaMapGenerator, bChunkedGeneration);
+  DOREPLIFETIME(ABangGuChaMapGenerator, ChunkSize);
+  DOREPLIFETIME(ABangGuChaMapGenerator, SwarmEnemyCount);
+}
+
+void ABangGuChaMapGenerator::OnRep_GeneratedSeed() {
+  // Before BeginPlay the seed came with the actor, and BeginPlay generates
+  if (HasActorBegunPlay() && GeneratedSeed != 0) {
+    GenerateMap();
+  }
+}
+
+void ABangGuChaMapGenerator::Tick(float DeltaTime) {
+  Super::Tick(DeltaTime);
+
+  if (ChunkedLayoutTask.IsValid() && ChunkedLayoutTask.IsReady()) {
+    OnChunkedLayoutReady();
+  }
+  if (ChunkedLayout.IsValid() && !ChunkedLayoutTask.IsValid() &&
+      AreMapClassesReady()) {
+    StreamChunks();
+  }
+  ReportTimeToPlayable();
+
+  // Clients never choose enemy moves, so they have no use for the field
+  if (!Layout.Walls.IsValid() || !HasAuthority())
+    return;
+
+  if (GetSmokeField()) {
+    BANGGUCHA_SCOPE(SmokeField);
+    SmokeField.Step(DeltaTime, SmokeSpreadRate, SmokeFadeRate);
+  }
+
+  BANGGUCHA_SCOPE(PathingUpdate);
+
+  // A new player tile queues the next search behind any rebuild that did
+  // not fit in earlier frames, so that rebuild still publishes. The graph
+  // only builds trees when the player enters a corridor none of the cached
+  // ones cover, and the clusters search lazily as enemies prepare theirs.
+  if (APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0)) {
+    const FIntPoint Tile = WorldToTile(PlayerPawn->GetActorLocation());
+    const BangGuChaSim::FTile Goal{Tile.X, Tile.Y};
+    switch (Pathing) {
+    case EBangGuChaPathing::FlowField:
+      FlowField.SetGoal(Goal);
+      break;
+    case EBangGuChaPathing::JunctionGraph:
+      JunctionGraph.SetGoal(Goal);
+      break;
+    case EBangGuChaPathing::Hierarchical:
+      HierarchicalPath.SetGoal(Goal);
+      break;
+    }
+  }
+  if (Pathing == EBangGuChaPathing::FlowField) {
+    FlowField.Update(FlowFieldTilesPerTick);
+  }
 }
 
 void ABangGuChaMapGenerator::GenerateMap() {
-  if (!WallClass || !ItemClass)
+  BANGGUCHA_SCOPE(GenerateMap);
+
+  const bool bInstancedWalls = WallMode == EBangGuChaWallMode::Instanced;
+  if ((!bInstancedWalls && WallClass.IsNull()) || ItemClass.IsNull())
+    return;
+
+  if (ChunkedLayout.IsValid()) {
+    UE_LOG(LogTemp, Warning, TEXT("GenerateMap: previous map still streaming"));
+    return;
+  }
+  if (!CanReplicateMapSize(MapWidth, MapHeight)) {
+    UE_LOG(LogTemp, Warning,
+           TEXT("GenerateMap: %dx%d is too large to replicate"), MapWidth,
+           MapHeight);
+    return;
+  }
+
+  GenerateStartTime = FPlatformTime::Seconds();
+  ReleaseMapActors();
+  ActorsBeforeGenerate = GetWorld()->GetActorCount();
+
+  if (ABangGuChaGameModeBase *GM =
+          Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode())) {
+    GM->MapGenerator = this;
+  }
+  if (ABangGuChaGameState *State =
+          GetWorld()->GetGameState<ABangGuChaGameState>()) {
+    State->MapGenerator = this;
+  }
+
+  // Layout rules live in the headless sim so batch runs see the same maps
+  if (HasAuthority()) {
+    if (Seed == 0) {
+      GeneratedSeed = FMath::Max(FMath::Rand(), 1);
+    } else if (NewLayoutCount == 0) {
+      GeneratedSeed = Seed;
+    } else {
+      const uint64 Mixed = BangGuChaSim::FRandom::MixSeed(
+          uint64(uint32(Seed)), uint64(NewLayoutCount));
+      GeneratedSeed = FMath::Max(int32(uint32(Mixed) & 0x7fffffff), 1);
+    }
+    ForceNetUpdate();
+  }
+  BangGuChaSim::FMapParams Params;
+  Params.Width = MapWidth;
+  Params.Height = MapHeight;
+  Params.WallChance = WallChance;
+  Params.ItemChance = ItemChance;
+  Params.ExtraEnemies = SwarmEnemyCount;
+  Params.Style = static_cast<BangGuChaSim::EMapStyle>(MapStyle);
+  Params.BraidChance = BraidChance;
+  Params.bEnsureReachable = bEnsureReachable;
+
+  // A hand-made level or a cached one replaces generation. The whole
+  // layout is ready at once, but a chunked map still streams its actors.
+  const uint64 LayoutSeed = uint64(uint32(GeneratedSeed));
+  const uint64 CacheKey = BangGuChaSim::MakeLevelCacheKey(
+      Params, LayoutSeed, bChunkedGeneration ? ChunkSize : 0);
+  const FString CachePath = GetLevelCachePath(CacheKey);
+  // A random seed never comes round again, so only the fixed seed's own
+  // layout is cached; restarts with a new layout skip the write too
+  const bool bCacheLayout =
+      bUseLevelCache && Seed != 0 && GeneratedSeed == Seed;
+  const TCHAR *LoadedFrom = nullptr;
+  if (!LevelFile.FilePath.IsEmpty()) {
+    if (LoadLevelFile(LevelFile.FilePath, 0)) {
+      LoadedFrom = *LevelFile.FilePath;
+    }
+  } else if (bCacheLayout && LoadLevelFile(CachePath, CacheKey)) {
+    LoadedFrom = *CachePath;
+  }
+
+  LastGenerateSource = LoadedFrom ? LoadedFrom : TEXT("generated");
+  if (LoadedFrom && bChunkedGeneration) {
+    // Split here rather than on a worker, so Layout is never a new grid
+    // that PrepareLayout has not seen yet
+    ChunkedLayout =
+        MakeShared<BangGuChaSim::FChunkedMapLayout, ESPMode::ThreadSafe>();
+    ChunkedLayout->Layout = MoveTemp(Layout);
+    BangGuChaSim::SplitLayoutIntoChunks(ChunkSize, *ChunkedLayout);
+    OnChunkedLayoutReady();
     return;
+  }
 
-  ABangGuChaGameModeBase *GM =
-      Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode());
-  int32 FlagCount = 0;
+  if (!LoadedFrom && bChunkedGeneration) {
+    // Chunks only share the read-only params, so the worker task can fan
+    // them out over the task graph
+    ChunkedLayout =
+        MakeShared<BangGuChaSim::FChunkedMapLayout, ESPMode::ThreadSafe>();
+    ChunkedLayoutTask = Async(
+        EAsyncExecution::ThreadPool,
+        [Result = ChunkedLayout, Params, LayoutSeed, CacheKey,
+         CachePath = bCacheLayout ? CachePath : FString(),
+         TilesPerChunk = ChunkSize, MaxFiles = MaxLevelCacheFiles]() {
+          BangGuChaSim::GenerateLayoutChunked(
+              Params, LayoutSeed, TilesPerChunk, *Result,
+              [](int32 Num, const auto &Body) {
+                ParallelFor(Num, [&Body](int32 Index) { Body(Index); });
+              });
+          if (!CachePath.IsEmpty()) {
+            WriteLevelCacheFile(CachePath, Result->Layout, LayoutSeed,
+                                CacheKey, MaxFiles);
+          }
+        });
+    return;
+  }
+
+  if (!LoadedFrom) {
+    BangGuChaSim::FRandom Rng(LayoutSeed);
+    BangGuChaSim::GenerateLayout(Params, Rng, Layout);
+    if (bCacheLayout) {
+      // The copy is cheap next to the file write it keeps off this thread
+      Async(EAsyncExecution::ThreadPool,
+            [CachePath, Cached = Layout, LayoutSeed, CacheKey,
+             MaxFiles = MaxLevelCacheFiles]() {
+              WriteLevelCacheFile(CachePath, Cached, LayoutSeed, CacheKey,
+                                  MaxFiles);
+            });
+    }
+  }
+  PrepareLayout();
 
+  // Each kind of actor spawns now if its class is in, or when it loads.
+  // Called again before then, this map's pending actors replace them.
+  bWallsPending = true;
+  bFlagsPending = true;
+  bEnemiesPending = true;
+  SpawnPendingActors();
+}
+
+void ABangGuChaMapGenerator::FinishGenerateMap() {
+  const int32 ActorsAfter = GetWorld()->GetActorCount();
+  LastGenerateMs =
+      float((FPlatformTime::Seconds() - GenerateStartTime) * 1000.0);
+  LastSpawnedActors = ActorsAfter - ActorsBeforeGenerate;
+  UE_LOG(LogTemp, Log,
+         TEXT("GenerateMap %dx%d (%s walls, %s): %d walls in %.2f ms, "
+              "actors %d -> %d"),
+         MapWidth, MapHeight,
+         WallMode == EBangGuChaWallMode::Instanced ? TEXT("instanced")
+                                                   : TEXT("actor"),
+         *LastGenerateSource, LastWallCount, LastGenerateMs,
+         ActorsBeforeGenerate, ActorsAfter);
+}
+
+bool ABangGuChaMapGenerator::RestartMap(bool bNewLayout) {
+  if (!HasAuthority() || IsGenerating() || !Layout.Walls.IsValid())
+    return false;
+
+  // A streamed map would keep the players waiting on its chunks, so it
+  // restarts on the layout it has
+  if (bNewLayout && !bChunkedGeneration) {
+    NewLayoutCount++;
+    GenerateMap();
+    return true;
+  }
+
+  ReleaseMapActors();
+  PrepareMatch();
+  SpawnFlags();
+  SpawnEnemies();
+  return true;
+}
+
+bool ABangGuChaMapGenerator::SaveLevel(const FString &Path) const {
+  if (!Layout.Walls.IsValid())
+    return false;
+  return WriteLevelFile(Path, Layout, uint64(uint32(GeneratedSeed)), 0);
+}
+
+FString ABangGuChaMapGenerator::GetLevelCachePath(uint64 CacheKey) {
+  return FPaths::Combine(
+      FPaths::ProjectSavedDir(), TEXT("LevelCache"),
+      UTF8_TO_TCHAR(BangGuChaSim::GetLevelCacheFileName(CacheKey).c_str()));
+}
+
+bool ABangGuChaMapGenerator::LoadLevelFile(const FString &Path,
+                                           uint64 ExpectedKey) {
+  IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+  if (!PlatformFile.FileExists(*Path))
+    return false;
+
+  // The region unmaps before the handle closes; only the final copy into
+  // Layout touches the bytes
+  TUniquePtr<IMappedFileHandle> Handle(PlatformFile.OpenMapped(*Path));
+  TUniquePtr<IMappedFileRegion> Region(Handle ? Handle->MapRegion()
+                                              : nullptr);
+  BangGuChaSim::FLevelView View;
+  if (!Region ||
+      !View.Parse(Region->GetMappedPtr(), size_t(Region->GetMappedSize())) ||
+      (ExpectedKey != 0 && View.GetHeader().CacheKey != ExpectedKey)) {
+    UE_LOG(LogTemp, Warning, TEXT("Ignoring unreadable level file %s"),
+           *Path);
+    return false;
+  }
+  if (!CanReplicateMapSize(View.GetHeader().Width,
+                           View.GetHeader().Height)) {
+    UE_LOG(LogTemp, Warning, TEXT("Level file %s is too large to replicate"),
+           *Path);
+    return false;
+  }
+  if (!BangGuChaSim::LoadLevel(View, Layout)) {
+    UE_LOG(LogTemp, Warning, TEXT("Ignoring unreadable level file %s"),
+           *Path);
+    return false;
+  }
+
+  MapWidth = Layout.Walls.GetWidth();
+  MapHeight = Layout.Walls.GetHeight();
+  return true;
+}
+
+bool ABangGuChaMapGenerator::CanReplicateMapSize(int32 Width,
+                                                 int32 Height) const {
+  // Standalone games never pack tiles for the network
+  return GetNetMode() == NM_Standalone ||
+         (Width <= BangGuChaSim::NetMaxMapSize &&
+          Height <= BangGuChaSim::NetMaxMapSize);
+}
+
+bool ABangGuChaMapGenerator::IsGenerating() const {
+  return ChunkedLayout.IsValid() || bWallsPending || bFlagsPending ||
+         bEnemiesPending;
+}
+
+void ABangGuChaMapGenerator::RequestClassLoads() {
+  if (NeedsWallClass()) {
+    WallClassLoad = RequestClassLoad(WallClass.ToSoftObjectPath());
+  }
+  // Clients are sent flags and enemies by the server
+  if (HasAuthority()) {
+    ItemClassLoad = RequestClassLoad(ItemClass.ToSoftObjectPath());
+    EnemyClassLoad = RequestClassLoad(EnemyClass.ToSoftObjectPath());
+  }
+  // Stamps the time right away when everything was already in memory
+  OnClassLoaded();
+}
+
+TSharedPtr<FStreamableHandle>
+ABangGuChaMapGenerator::RequestClassLoad(const FSoftObjectPath &Path) {
+  if (Path.IsNull() || Path.ResolveObject())
+    return nullptr;
+  // The handle keeps the class loaded for as long as the map holds it
+  return UAssetManager::GetStreamableManager().RequestAsyncLoad(
+      Path, FStreamableDelegate::CreateUObject(
+                this, &ABangGuChaMapGenerator::OnClassLoaded));
+}
+
+void ABangGuChaMapGenerator::OnClassLoaded() {
+  if (ClassesLoadedTime == 0.0 && AreMapClassesReady()) {
+    ClassesLoadedTime = FPlatformTime::Seconds();
+  }
+  SpawnPendingActors();
+}
+
+bool ABangGuChaMapGenerator::IsClassReady(
+    const TSharedPtr<FStreamableHandle> &Load) {
+  // A failed load counts as done; spawning then skips the missing class
+  return !Load.IsValid() || !Load->IsLoadingInProgress();
+}
+
+bool ABangGuChaMapGenerator::NeedsWallClass() const {
+  return WallMode == EBangGuChaWallMode::Actors || !WallMesh;
+}
+
+bool ABangGuChaMapGenerator::AreMapClassesReady() const {
+  return IsClassReady(WallClassLoad) && IsClassReady(ItemClassLoad) &&
+         IsClassReady(EnemyClassLoad);
+}
+
+void ABangGuChaMapGenerator::SpawnPendingActors() {
+  if (!bWallsPending && !bFlagsPending && !bEnemiesPending)
+    return;
+
+  if (bWallsPending && IsClassReady(WallClassLoad)) {
+    bWallsPending = false;
+    LastWallCount = SpawnWalls();
+  }
+  if (bFlagsPending && IsClassReady(ItemClassLoad)) {
+    bFlagsPending = false;
+    SpawnFlags();
+  }
+  if (bEnemiesPending && IsClassReady(EnemyClassLoad)) {
+    bEnemiesPending = false;
+    SpawnEnemies();
+  }
+
+  if (!bWallsPending && !bFlagsPending && !bEnemiesPending) {
+    FinishGenerateMap();
+  }
+}
+
+void ABangGuChaMapGenerator::ReportTimeToPlayable() {
+  // Once per process; later maps and PIE sessions are not a startup
+  static bool bReported = false;
+  if (bReported || !Layout.Walls.IsValid() || IsGenerating() ||
+      !UGameplayStatics::GetPlayerPawn(this, 0))
+    return;
+  bReported = true;
+
+  const double Now = FPlatformTime::Seconds();
+  TimeToPlayableSeconds = float(Now - GStartTime);
+  UE_LOG(LogTemp, Log,
+         TEXT("First playable frame %.2f s after process start: %.2f ms "
+              "after the map's BeginPlay, classes loaded after %.2f ms"),
+         TimeToPlayableSeconds, (Now - BeginPlayTime) * 1000.0,
+         (FMath::Max(ClassesLoadedTime, BeginPlayTime) - BeginPlayTime) *
+             1000.0);
+  CSV_EVENT(BangGuCha, TEXT("FirstPlayableFrame"));
+}
+
+void ABangGuChaMapGenerator::PrepareLayout() {
+  FlowField.Init(&Layout.Walls);
+  JunctionGraph.Reset();
+  HierarchicalPath.Reset();
+
+  // Flags, enemies and smoke are the server's to spawn and simulate
+  if (!HasAuthority())
+    return;
+
+  if (bSmokeField) {
+    SmokeField.Init(Layout.Walls);
+  } else {
+    SmokeField.Reset();
+  }
+
+  // Walls never change after generation, so cached paths live as long as
+  // the map
+  if (Pathing == EBangGuChaPathing::JunctionGraph) {
+    JunctionGraph.Build(Layout.Walls);
+  } else if (Pathing == EBangGuChaPathing::Hierarchical) {
+    HierarchicalPath.Build(&Layout.Walls, PathClusterSize);
+  }
+
+  PrepareMatch();
+}
+
+void ABangGuChaMapGenerator::PrepareMatch() {
+  SmokeField.Clear();
+  NewSmokeTiles.Reset();
+
+  if (ABangGuChaGameModeBase *GM =
+          Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode())) {
+    GM->SetTotalFlags(int32(Layout.Flags.size()));
+  }
+}
+
+void ABangGuChaMapGenerator::PrepareFlags() {
+  if (!HasAuthority())
+    return;
+
+  // Park every flag up front; spawning then only pulls actors off the free
+  // list
+  if (UBangGuChaActorPoolSubsystem *Pool =
+          GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>()) {
+    Pool->Prewarm(ItemClass.Get(), int32(Layout.Flags.size()));
+  }
+}
+
+void ABangGuChaMapGenerator::PrepareEnemies() {
+  if (!HasAuthority())
+    return;
+
+  UBangGuChaActorPoolSubsystem *Pool =
+      GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>();
+  if (Pool && SpawnsEnemyActors()) {
+    Pool->Prewarm(EnemyClass.Get(), int32(Layout.EnemySpawns.size()));
+  }
+
+  if (UBangGuChaEnemySubsystem *EnemyManager =
+          bUseEnemyManager
+              ? GetWorld()->GetSubsystem<UBangGuChaEnemySubsystem>()
+              : nullptr) {
+    const UClass *Class = EnemyClass.Get();
+    const ABangGuChaEnemy *EnemyDefaults =
+        Class ? Cast<ABangGuChaEnemy>(Class->GetDefaultObject()) : nullptr;
+    EnemyManager->Reset();
+    EnemyManager->Configure(EnemyDefaults ? EnemyDefaults->MoveSpeed : 200.f,
+                            EnemyDefaults ? EnemyDefaults->StunDuration : 3.f,
+                            GridSize);
+
+    UStaticMesh *Mesh = nullptr;
+    FTransform MeshTransform;
+    if (bInstancedEnemies && !UsesInstancedEnemies()) {
+      UE_LOG(LogTemp, Warning,
+             TEXT("Instanced enemies are standalone only; clients would see "
+                  "none, so proxies are spawned instead"));
+    } else if (bInstancedEnemies &&
+               ResolveInstancedEnemyMesh(Mesh, MeshTransform)) {
+      EnemyInstances->SetStaticMesh(Mesh);
+      EnemyManager->SetInstancedVisuals(EnemyInstances, MeshTransform, 50.f);
+    } else if (bInstancedEnemies) {
+      UE_LOG(LogTemp, Warning,
+             TEXT("Instanced enemies need EnemyMesh or an EnemyClass with a "
+                  "mesh"));
+    }
+  }
+}
+
+void ABangGuChaMapGenerator::SpawnFlags() {
+  PrepareFlags();
+  for (const BangGuChaSim::FTile &Flag : Layout.Flags) {
+    SpawnItem(Flag.X, Flag.Y);
+  }
+}
+
+void ABangGuChaMapGenerator::SpawnEnemies() {
+  PrepareEnemies();
+  for (const BangGuChaSim::FTile &Spawn : Layout.EnemySpawns) {
+    SpawnEnemy(Spawn.X, Spawn.Y);
+  }
+}
+
+void ABangGuChaMapGenerator::ReleaseMapActors() {
+  UBangGuChaActorPoolSubsystem *Pool =
+      GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>();
+  if (!Pool)
+    return;
+
+  // Walls are spawned on every machine, flags and enemies by the server
+  if (WallMode == EBangGuChaWallMode::Actors) {
+    Pool->ReleaseAll(WallClass.Get());
+  }
+  if (HasAuthority()) {
+    Pool->ReleaseAll(ItemClass.Get());
+    Pool->ReleaseAll(EnemyClass.Get());
+  }
+}
+
+void ABangGuChaMapGenerator::OnChunkedLayoutReady() {
+  ChunkedLayoutTask.Reset();
+  LayoutReadyTime = FPlatformTime::Seconds();
+
+  // Movement, the flow field and the win check all work from the bitmap,
+  // so play can start while actors are still streaming in
+  Layout = MoveTemp(ChunkedLayout->Layout);
+  PrepareLayout();
+
+  FIntPoint Origin(Layout.PlayerStart.X, Layout.PlayerStart.Y);
+  if (const APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0)) {
+    Origin = WorldToTile(PlayerPawn->GetActorLocation());
+  }
+
+  const int32 TilesPerChunk = ChunkedLayout->ChunkSize;
+  const int32 ChunksX = ChunkedLayout->ChunksX;
+  ChunkOrder.Reset(int32(ChunkedLayout->Chunks.size()));
+  for (int32 Index = 0; Index < int32(ChunkedLayout->Chunks.size());
+       Index++) {
+    ChunkOrder.Add(Index);
+  }
+  ChunkOrder.Sort([TilesPerChunk, ChunksX, Origin](int32 A, int32 B) {
+    auto DistSq = [&](int32 Index) {
+      const int32 DX = (Index % ChunksX) * TilesPerChunk +
+                       TilesPerChunk / 2 - Origin.X;
+      const int32 DY = (Index / ChunksX) * TilesPerChunk +
+                       TilesPerChunk / 2 - Origin.Y;
+      return int64(DX) * DX + int64(DY) * DY;
+    };
+    return DistSq(A) < DistSq(B);
+  });
+
+  NextChunk = 0;
+  NextInChunk = 0;
+  StreamFrames = 0;
+  PendingChunks = ChunkOrder.Num();
+}
+
+void ABangGuChaMapGenerator::StreamChunks() {
+  BANGGUCHA_SCOPE(MapStreamChunks);
+
+  const double Deadline = FPlatformTime::Seconds() + SpawnBudgetMs / 1000.0;
+  // Waits in Tick until the classes are in, so it is set up here
+  if (StreamFrames == 0) {
+    bInstancedWallsReady = WallMode == EBangGuChaWallMode::Instanced &&
+                           BeginInstancedWalls();
+    PrepareFlags();
+    PrepareEnemies();
+  }
+  StreamFrames++;
+
+  // Each chunk spawns walls, then flags, then enemies. Stepping one actor at
+  // a time keeps a dense chunk from blowing the budget.
+  while (NextChunk < ChunkOrder.Num()) {
+    const BangGuChaSim::FMapChunk &Chunk =
+        ChunkedLayout->Chunks[ChunkOrder[NextChunk]];
+    const int32 NumWalls = int32(Chunk.Walls.size());
+    const int32 NumFlags = int32(Chunk.Flags.size());
+    const int32 NumSteps =
+        NumWalls + NumFlags + int32(Chunk.EnemySpawns.size());
+
+    if (WallMode == EBangGuChaWallMode::Instanced && NextInChunk < NumWalls) {
+      if (bInstancedWallsReady) {
+        AddChunkWallInstances(Chunk);
+      }
+      NextInChunk = NumWalls;
+    }
+
+    while (NextInChunk < NumSteps && FPlatformTime::Seconds() < Deadline) {
+      const int32 Step = NextInChunk++;
+      if (Step < NumWalls) {
+        SpawnWall(Chunk.Walls[Step].X, Chunk.Walls[Step].Y);
+      } else if (Step < NumWalls + NumFlags) {
+        const BangGuChaSim::FTile &Flag = Chunk.Flags[Step - NumWalls];
+        SpawnItem(Flag.X, Flag.Y);
+      } else {
+        const BangGuChaSim::FTile &Spawn =
+            Chunk.EnemySpawns[Step - NumWalls - NumFlags];
+        SpawnEnemy(Spawn.X, Spawn.Y);
+      }
+    }
+
+    if (NextInChunk < NumSteps)
+      return;
+
+    NextChunk++;
+    NextInChunk = 0;
+    PendingChunks = ChunkOrder.Num() - NextChunk;
+    if (FPlatformTime::Seconds() >= Deadline)
+      break;
+  }
+
+  if (NextChunk >= ChunkOrder.Num()) {
+    FinishChunkedGeneration();
+  }
+}
+
+void ABangGuChaMapGenerator::FinishChunkedGeneration() {
+  const double Now = FPlatformTime::Seconds();
+  const int32 ActorsAfter = GetWorld()->GetActorCount();
+  LastGenerateMs = float((Now - GenerateStartTime) * 1000.0);
+  LastSpawnedActors = ActorsAfter - ActorsBeforeGenerate;
+  UE_LOG(LogTemp, Log,
+         TEXT("GenerateMap %dx%d chunked (%d chunks of %d, %s): layout "
+              "ready in %.2f ms, streamed over %d frames, %.2f ms total, "
+              "actors %d -> %d"),
+         MapWidth, MapHeight, ChunkOrder.Num(), ChunkedLayout->ChunkSize,
+         *LastGenerateSource,
+         (LayoutReadyTime - GenerateStartTime) * 1000.0, StreamFrames,
+         LastGenerateMs, ActorsBeforeGenerate, ActorsAfter);
+
+  ChunkedLayout.Reset();
+  ChunkOrder.Reset();
+  PendingChunks = 0;
+}
+
+int32 ABangGuChaMapGenerator::SpawnWalls() {
+  if (WallMode == EBangGuChaWallMode::Instanced)
+    return SpawnInstancedWalls();
+
+  int32 WallCount = 0;
   for (int32 x = 0; x < MapWidth; x++) {
     for (int32 y = 0; y < MapHeight; y++) {
-      // Border Walls
-      if (x == 0 || x == MapWidth - 1 || y == 0 || y == MapHeight - 1) {
+      if (!Layout.Walls.IsWalkable(x, y)) {
         SpawnWall(x, y);
-        continue;
+        WallCount++;
       }
+    }
+  }
+  return WallCount;
+}
 
-      // Safe Zone (Top-Left for Player)
-      if (x < 3 && y < 3)
-        continue;
+bool ABangGuChaMapGenerator::BeginInstancedWalls() {
+  WallInstances->ClearInstances();
 
-      // Random Inner Walls (10% chance)
-      if (FMath::RandRange(0.f, 1.f) < 0.1f) {
-        SpawnWall(x, y);
-        continue;
+  UStaticMesh *Mesh = nullptr;
+  if (!ResolveInstancedWallMesh(Mesh, WallInstanceTransform)) {
+    UE_LOG(LogTemp, Warning,
+           TEXT("Instanced walls need WallMesh or a WallClass with a mesh"));
+    return false;
+  }
+
+  WallInstances->SetStaticMesh(Mesh);
+  if (bInstancedWallCollision) {
+    WallInstances->SetCollisionProfileName(TEXT("BlockAll"));
+    WallInstances->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+  } else {
+    WallInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+  }
+  return true;
+}
+
+int32 ABangGuChaMapGenerator::SpawnInstancedWalls() {
+  if (!BeginInstancedWalls())
+    return 0;
+
+  // Kept between maps, so a new layout of a similar size reuses it
+  WallTransforms.Reset();
+  WallTransforms.Reserve(2 * (MapWidth + MapHeight) +
+                         int32(MapWidth * MapHeight * WallChance));
+  for (int32 x = 0; x < MapWidth; x++) {
+    for (int32 y = 0; y < MapHeight; y++) {
+      if (!Layout.Walls.IsWalkable(x, y)) {
+        WallTransforms.Add(WallInstanceTransform *
+                           FTransform(TileToWorld(x, y)));
       }
+    }
+  }
+
+  // One batched add builds the cluster tree once instead of per wall
+  WallInstances->AddInstances(WallTransforms, false);
+  return WallTransforms.Num();
+}
 
-      // Random Items (5% chance)
-      if (FMath::RandRange(0.f, 1.f) < 0.05f) {
-        SpawnItem(x, y);
-        FlagCount++;
+void ABangGuChaMapGenerator::AddChunkWallInstances(
+    const BangGuChaSim::FMapChunk &Chunk) {
+  TArray<FTransform> Transforms;
+  Transforms.Reserve(int32(Chunk.Walls.size()));
+  for (const BangGuChaSim::FTile &Wall : Chunk.Walls) {
+    Transforms.Add(WallInstanceTransform *
+                   FTransform(TileToWorld(Wall.X, Wall.Y)));
+  }
+  WallInstances->AddInstances(Transforms, false);
+}
+
+bool ABangGuChaMapGenerator::ResolveInstancedWallMesh(
+    UStaticMesh *&OutMesh, FTransform &OutMeshTransform) const {
+  OutMesh = WallMesh;
+  OutMeshTransform = FTransform::Identity;
+  if (OutMesh)
+    return true;
+
+  // Reuse the mesh and its relative transform from the wall actor class
+  if (const UClass *Class = WallClass.Get()) {
+    if (const ABangGuChaWall *WallDefaults =
+            Cast<ABangGuChaWall>(Class->GetDefaultObject())) {
+      if (WallDefaults->MeshComp) {
+        OutMesh = WallDefaults->MeshComp->GetStaticMesh();
+        OutMeshTransform = WallDefaults->MeshComp->GetRelativeTransform();
       }
     }
   }
+  return OutMesh != nullptr;
+}
+
+ABangGuChaMapGenerator *
+ABangGuChaMapGenerator::Get(const UObject *WorldContextObject) {
+  const UWorld *World = WorldContextObject ? WorldContextObject->GetWorld()
+                                           : nullptr;
+  if (!World)
+    return nullptr;
 
-  // Spawn Enemies at opposite corners
-  if (EnemyClass) {
-    SpawnEnemy(MapWidth - 2, MapHeight - 2);
-    SpawnEnemy(MapWidth - 2, 1);
+  if (ABangGuChaGameModeBase *GM =
+          Cast<ABangGuChaGameModeBase>(World->GetAuthGameMode())) {
+    return GM->MapGenerator;
   }
+  // Clients have no game mode
+  if (const ABangGuChaGameState *State =
+          World->GetGameState<ABangGuChaGameState>()) {
+    return State->MapGenerator;
+  }
+  return nullptr;
+}
+
+TArrayView<const FIntPoint> ABangGuChaMapGenerator::GetNewSmokeTiles() const {
+  return NewSmokeFrame == GFrameCounter
+             ? TArrayView<const FIntPoint>(NewSmokeTiles)
+             : TArrayView<const FIntPoint>();
+}
+
+void ABangGuChaMapGenerator::AddSmoke(const FVector &Location) {
+  if (!GetSmokeField())
+    return;
+  // Remembered for one frame, so an enemy already standing in smoke is
+  // stunned again when a fresh fart lands on it
+  if (NewSmokeFrame != GFrameCounter) {
+    NewSmokeTiles.Reset();
+    NewSmokeFrame = GFrameCounter;
+  }
+  const FIntPoint Tile = WorldToTile(Location);
+  SmokeField.Deposit(Tile.X, Tile.Y, SmokeAmount);
+  NewSmokeTiles.AddUnique(Tile);
+}
+
+FIntPoint ABangGuChaMapGenerator::WorldToTile(const FVector &Location) const {
+  const BangGuChaSim::FTile Tile = BangGuChaSim::WorldToTile(
+      float(Location.X), float(Location.Y), GridSize);
+  return FIntPoint(Tile.X, Tile.Y);
+}
+
+FVector ABangGuChaMapGenerator::TileToWorld(int32 X, int32 Y) const {
+  return FVector(X * GridSize, Y * GridSize, 50.f);
+}
+
+bool ABangGuChaMapGenerator::CanActorMoveTo(const AActor *Mover,
+                                            const FVector &NewLocation) const {
+  if (!Layout.Walls.IsValid())
+    return SweepCanMoveTo(Mover, NewLocation);
 
-  if (GM) {
-    GM->TotalFlags = FlagCount;
+  const FIntPoint Tile = WorldToTile(NewLocation);
+  const bool bWalkable = Layout.Walls.IsWalkable(Tile.X, Tile.Y);
+
+#if !UE_BUILD_SHIPPING
+  if (CVarBangGuChaSweepCrossCheck.GetValueOnGameThread() != 0) {
+    const bool bSweepClear = SweepCanMoveTo(Mover, NewLocation);
+    if (bSweepClear != bWalkable) {
+      UE_LOG(LogTemp, Warning,
+             TEXT("Occupancy mismatch for %s at tile (%d, %d): bitmap=%d "
+                  "sweep=%d"),
+             *GetNameSafe(Mover), Tile.X, Tile.Y, bWalkable, bSweepClear);
+    }
   }
+#endif
+
+  return bWalkable;
+}
+
+bool ABangGuChaMapGenerator::SweepCanMoveTo(const AActor *Mover,
+                                            const FVector &NewLocation) {
+  // The ignore list is an inline array and the shape a plain value, so a
+  // sweep costs no heap allocation
+  static const FCollisionShape Box = FCollisionShape::MakeBox(FVector(40.f));
+  const FCollisionQueryParams Params(SCENE_QUERY_STAT(BangGuChaSweepCanMoveTo),
+                                     false, Mover);
+
+  FHitResult Hit;
+  bool bHit = Mover->GetWorld()->SweepSingleByChannel(
+      Hit, Mover->GetActorLocation(), NewLocation, FQuat::Identity,
+      ECC_WorldStatic, Box, Params);
+
+  return !bHit;
 }
 
 void ABangGuChaMapGenerator::SpawnWall(int32 X, int32 Y) {
+  // Pooled so that a new layout moves the walls it has
   FVector Location(X * GridSize, Y * GridSize, 50.f);
-  GetWorld()->SpawnActor<AActor>(WallClass, Location, FRotator::ZeroRotator);
+  UBangGuChaActorPoolSubsystem::AcquireOrSpawn(this, WallClass.Get(),
+                                               Location, FRotator::ZeroRotator);
 }
 
 void ABangGuChaMapGenerator::SpawnItem(int32 X, int32 Y) {
+  // Replicated from the server on clients
+  if (!HasAuthority())
+    return;
+
   FVector Location(X * GridSize, Y * GridSize, 50.f);
-  GetWorld()->SpawnActor<AActor>(ItemClass, Location, FRotator::ZeroRotator);
+  UBangGuChaActorPoolSubsystem::AcquireOrSpawn(this, ItemClass.Get(),
+                                               Location, FRotator::ZeroRotator);
 }
 
 void ABangGuChaMapGenerator::SpawnEnemy(int32 X, int32 Y) {
-  FVector Location(X * GridSize, Y * GridSize, 50.f);
-  GetWorld()->SpawnActor<AActor>(EnemyClass, Location, FRotator::ZeroRotator);
+  if (!HasAuthority())
+    return;
+
+  UBangGuChaEnemySubsystem *EnemyManager =
+      bUseEnemyManager ? GetWorld()->GetSubsystem<UBangGuChaEnemySubsystem>()
+                       : nullptr;
+
+  AActor *Enemy = nullptr;
+  if (EnemyClass.Get() && SpawnsEnemyActors()) {
+    FVector Location(X * GridSize, Y * GridSize, 50.f);
+    Enemy = UBangGuChaActorPoolSubsystem::AcquireOrSpawn(
+        this, EnemyClass.Get(), Location, FRotator::ZeroRotator);
+  }
+
+  if (EnemyManager) {
+    EnemyManager->AddEnemy(FIntPoint(X, Y), Cast<ABangGuChaEnemy>(Enemy));
+  }
+}
+
+bool ABangGuChaMapGenerator::SpawnsEnemyActors() const {
+  return !bUseEnemyManager ||
+         (bInstancedEnemies ? !UsesInstancedEnemies() : bSpawnEnemyProxies);
+}
+
+bool ABangGuChaMapGenerator::UsesInstancedEnemies() const {
+  return bUseEnemyManager && bInstancedEnemies &&
+         GetNetMode() == NM_Standalone;
+}
+
+bool ABangGuChaMapGenerator::ResolveInstancedEnemyMesh(
+    UStaticMesh *&OutMesh, FTransform &OutMeshTransform) const {
+  OutMesh = EnemyMesh;
+  OutMeshTransform = FTransform::Identity;
+  if (OutMesh)
+    return true;
+
+  // Same fallback as the walls: the proxy's mesh and where it sits
+  if (const UClass *Class = EnemyClass.Get()) {
+    if (const ABangGuChaEnemy *EnemyDefaults =
+            Cast<ABangGuChaEnemy>(Class->GetDefaultObject())) {
+      if (EnemyDefaults->MeshComp) {
+        OutMesh = EnemyDefaults->MeshComp->GetStaticMesh();
+        OutMeshTransform = EnemyDefaults->MeshComp->GetRelativeTransform();
+      }
+    }
+  }
+  return OutMesh != nullptr;
 }
@@ -1,8 +1,49 @@
 #pragma once
 
+#include "Async/Future.h"
 #include "BangGuChaMapGenerator.generated.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Sim/BangGuChaSimFlowField.h"
+#include "Sim/BangGuChaSimHierarchicalPath.h"
+#include "Sim/BangGuChaSimJunctionGraph.h"
+#include "Sim/BangGuChaSimMapGen.h"
+#include "Sim/BangGuChaSimSmokeField.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+struct FStreamableHandle;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+UENUM(BlueprintType)
+enum class EBangGuChaWallMode : uint8 {
+  // One WallClass actor per wall tile
+  Actors,
+  // Every wall is an instance of a single HISM component
+  Instanced
+};
+
+// Mirrors BangGuChaSim::EMapStyle
+UENUM(BlueprintType)
+enum class EBangGuChaMapStyle : uint8 {
+  // Independent random inner walls
+  Scatter,
+  // Perfect maze, one path between any two tiles
+  Backtracker,
+  // Maze with some dead ends opened into loops
+  Braided
+};
+
+// Mirrors BangGuChaSim::EPathing
+UENUM(BlueprintType)
+enum class EBangGuChaPathing : uint8 {
+  // Breadth-first field over every tile, rebuilt when the player moves
+  FlowField,
+  // Junctions and corridors, with cached shortest-path trees
+  JunctionGraph,
+  // Clusters and their entrances (HPA*), for very large maps
+  Hierarchical
+};
 
 UCLASS()
 class BANGGUCHA_API ABangGuChaMapGenerator : public AActor {
@@ -15,29 +56,384 @@ protected:
   virtual void BeginPlay() override;
 
 public:
-  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map Generation")
+  virtual void Tick(float DeltaTime) override;
+
+  // Clients rebuild the layout from the replicated seed and params; only
+  // flags and enemies come over the network as actors.
+  virtual void GetLifetimeReplicatedProps(
+      TArray<FLifetimeProperty> &OutLifetimeProps) const override;
+
+  // At most 4096 tiles a side, the most a replicated enemy tile can address
+  // (BangGuChaSim::NetMaxMapSize); GenerateMap refuses larger networked maps
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation", meta = (ClampMax = "4096"))
   int32 MapWidth;
 
-  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map Generation")
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation", meta = (ClampMax = "4096"))
   int32 MapHeight;
 
-  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map Generation")
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation")
   float GridSize;
 
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation",
+            meta = (ClampMin = "0.0", ClampMax = "1.0"))
+  float WallChance;
+
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation",
+            meta = (ClampMin = "0.0", ClampMax = "1.0"))
+  float ItemChance;
+
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation")
+  EBangGuChaMapStyle MapStyle;
+
+  // Share of maze dead ends opened into loops (Braided only)
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation",
+            meta = (ClampMin = "0.0", ClampMax = "1.0",
+                    EditCondition = "MapStyle == EBangGuChaMapStyle::Braided"))
+  float BraidChance;
+
+  // Carve corridors so no flag or enemy spawn is sealed off from the player
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation")
+  bool bEnsureReachable;
+
+  // Fixed layout seed; 0 picks a new one every play
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map Generation")
+  int32 Seed;
+
+  // Seed the current layout was generated from; picked by the server
+  UPROPERTY(ReplicatedUsing = OnRep_GeneratedSeed, VisibleAnywhere,
+            BlueprintReadOnly, Category = "Map Generation")
+  int32 GeneratedSeed;
+
+  // Hand-made level to load instead of generating one. Every client needs
+  // the same file.
+  UPROPERTY(EditAnywhere, Category = "Map Generation|Level Files",
+            meta = (FilePathFilter = "bgcl"))
+  FFilePath LevelFile;
+
+  // Keep generated levels under Saved/LevelCache, keyed by seed and
+  // params, and map them back in instead of regenerating. Only layouts
+  // from a fixed Seed are cached.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation|Level Files")
+  bool bUseLevelCache;
+
+  // Oldest cached levels are deleted beyond this many
+  UPROPERTY(EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation|Level Files",
+            meta = (ClampMin = "1", EditCondition = "bUseLevelCache"))
+  int32 MaxLevelCacheFiles;
+
+  // Stats from the last GenerateMap call
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Map Generation")
+  float LastGenerateMs;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Map Generation")
+  int32 LastSpawnedActors;
+
+  // Seconds from process start to the first frame with the map spawned and
+  // a player on it; logged once per process
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Map Generation")
+  float TimeToPlayableSeconds;
+
+  // Build the layout chunk by chunk on worker threads, then spawn it over
+  // several frames starting with the chunks nearest the player
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation|Streaming")
+  bool bChunkedGeneration;
+
+  // Tiles per chunk side
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation|Streaming",
+            meta = (ClampMin = "8", EditCondition = "bChunkedGeneration"))
+  int32 ChunkSize;
+
+  // Game-thread time spent spawning streamed chunks per frame
+  UPROPERTY(EditAnywhere, BlueprintReadWrite,
+            Category = "Map Generation|Streaming",
+            meta = (ClampMin = "0.1", EditCondition = "bChunkedGeneration"))
+  float SpawnBudgetMs;
+
+  // Chunks whose actors have not been spawned yet
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly,
+            Category = "Map Generation|Streaming")
+  int32 PendingChunks;
+
+  // The actor classes are soft references, loaded in the background from
+  // BeginPlay while the layout is built. Each kind of actor spawns once
+  // its own class is in.
   UPROPERTY(EditDefaultsOnly, Category = "Map Generation")
-  TSubclassOf<class AActor> WallClass;
+  TSoftClassPtr<AActor> WallClass;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map Generation")
+  EBangGuChaWallMode WallMode;
+
+  // Mesh for instanced walls; defaults to the mesh on WallClass
+  UPROPERTY(EditAnywhere, Category = "Map Generation|Instanced Walls")
+  UStaticMesh *WallMesh;
+
+  // Per-instance blocking collision, only needed for the sweep fallback
+  UPROPERTY(EditAnywhere, Category = "Map Generation|Instanced Walls")
+  bool bInstancedWallCollision;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+  UHierarchicalInstancedStaticMeshComponent *WallInstances;
 
   UPROPERTY(EditDefaultsOnly, Category = "Map Generation")
-  TSubclassOf<class AActor> ItemClass;
+  TSoftClassPtr<AActor> ItemClass;
 
   UPROPERTY(EditDefaultsOnly, Category = "Map Generation")
-  TSubclassOf<class APawn> EnemyClass;
+  TSoftClassPtr<APawn> EnemyClass;
+
+  // Simulate enemies in UBangGuChaEnemySubsystem instead of per-actor ticks
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Enemies")
+  bool bUseEnemyManager;
+
+  // Spawn EnemyClass actors as visual proxies for managed enemies
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Enemies",
+            meta = (EditCondition = "bUseEnemyManager"))
+  bool bSpawnEnemyProxies;
+
+  // Draw managed enemies as instances of EnemyInstances instead of proxy
+  // actors, for swarms of thousands. The instances are only filled where
+  // the manager runs, so networked games fall back to proxies.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Enemies",
+            meta = (EditCondition = "bUseEnemyManager"))
+  bool bInstancedEnemies;
 
+  // Mesh for instanced enemies; defaults to the mesh on EnemyClass. Its
+  // material reads per-instance custom data 0 as the stun flag.
+  UPROPERTY(EditAnywhere, Category = "Enemies",
+            meta = (EditCondition = "bInstancedEnemies"))
+  UStaticMesh *EnemyMesh;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+  UInstancedStaticMeshComponent *EnemyInstances;
+
+  // Extra chasers on random open tiles, for swarm stages
+  UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite, Category = "Enemies",
+            meta = (ClampMin = "0"))
+  int32 SwarmEnemyCount;
+
+  // Resolve flag pickups, smoke stuns and catches on the grid in
+  // UBangGuChaOverlapSubsystem instead of with physics overlap events
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collision")
+  bool bGridOverlaps;
+
+  // Farts add to a smoke density per tile that spreads through open tiles
+  // and fades, instead of spawning smoke actors. Enemies stun on reaching
+  // StunDensity at their tile. Simulated on the server, and resolved with
+  // the grid overlaps.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Smoke",
+            meta = (EditCondition = "bGridOverlaps"))
+  bool bSmokeField;
+
+  // Density one fart adds to the pawn's tile
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Smoke",
+            meta = (ClampMin = "0.0", EditCondition = "bSmokeField"))
+  float SmokeAmount;
+
+  // Share of a tile's smoke each open neighbour receives per second
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Smoke",
+            meta = (ClampMin = "0.0", EditCondition = "bSmokeField"))
+  float SmokeSpreadRate;
+
+  // Exponential fade per second
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Smoke",
+            meta = (ClampMin = "0.0", EditCondition = "bSmokeField"))
+  float SmokeFadeRate;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Smoke",
+            meta = (ClampMin = "0.0", EditCondition = "bSmokeField"))
+  float SmokeStunDensity;
+
+  // Where enemies get their chase directions from. The graph and the
+  // clusters are built once per map; the flow field is rebuilt whenever
+  // the player changes tile.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+  EBangGuChaPathing Pathing;
+
+  // Upper bound on tiles expanded per frame while rebuilding the flow field
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding",
+            meta = (EditCondition =
+                        "Pathing == EBangGuChaPathing::FlowField"))
+  int32 FlowFieldTilesPerTick;
+
+  // Cluster edge in tiles for hierarchical pathing
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding",
+            meta = (ClampMin = "4", EditCondition =
+                        "Pathing == EBangGuChaPathing::Hierarchical"))
+  int32 PathClusterSize;
+
+  // Returns any walls, flags and enemies from an earlier call to the actor
+  // pool first, so calling it again replaces the map
   UFUNCTION(BlueprintCallable, Category = "Map Generation")
   void GenerateMap();
 
+  // Puts every flag and enemy back for a new match without reloading the
+  // level. The walls, paths and pooled actors are kept; with bNewLayout
+  // the next seed's map is generated into them instead. A fixed Seed then
+  // moves on to a seed mixed from it and a layout count, and those maps
+  // are not written to the level cache. Server only. Returns false while a
+  // map is still streaming in.
+  bool RestartMap(bool bNewLayout);
+
+  // Writes the current layout as a level file that LevelFile can load
+  UFUNCTION(BlueprintCallable, Category = "Map Generation")
+  bool SaveLevel(const FString &Path) const;
+
+  // True while a chunked layout is being built or streamed in, or actors
+  // wait on their class to load
+  UFUNCTION(BlueprintPure, Category = "Map Generation")
+  bool IsGenerating() const;
+
+  // Grid queries
+  static ABangGuChaMapGenerator *Get(const UObject *WorldContextObject);
+
+  FORCEINLINE bool IsTileWalkable(int32 X, int32 Y) const {
+    return Layout.Walls.IsWalkable(X, Y);
+  }
+
+  FIntPoint WorldToTile(const FVector &Location) const;
+  FVector TileToWorld(int32 X, int32 Y) const;
+
+  const BangGuChaSim::FOccupancyGrid &GetOccupancy() const {
+    return Layout.Walls;
+  }
+  const BangGuChaSim::FMapLayout &GetLayout() const { return Layout; }
+
+  // Shared field toward the player's tile, read by every enemy
+  const BangGuChaSim::FFlowField &GetFlowField() const { return FlowField; }
+
+  // Graph toward the player's tile, or null when enemies use the flow field
+  const BangGuChaSim::FJunctionGraph *GetJunctionGraph() const {
+    return Pathing == EBangGuChaPathing::JunctionGraph &&
+                   JunctionGraph.IsBuilt()
+               ? &JunctionGraph
+               : nullptr;
+  }
+
+  // Clusters toward the player's tile, or null for the other modes.
+  // Prepare the mover's cluster on the game thread before reading steps.
+  BangGuChaSim::FHierarchicalPath *GetHierarchicalPath() {
+    return Pathing == EBangGuChaPathing::Hierarchical &&
+                   HierarchicalPath.IsBuilt()
+               ? &HierarchicalPath
+               : nullptr;
+  }
+
+  // Smoke density per tile, or null when farts spawn smoke actors
+  const BangGuChaSim::FSmokeField *GetSmokeField() const {
+    return bSmokeField && SmokeField.GetWidth() > 0 ? &SmokeField : nullptr;
+  }
+
+  // Tiles that took a fart this frame
+  TArrayView<const FIntPoint> GetNewSmokeTiles() const;
+
+  // Puts one fart's smoke on the tile under Location; server only
+  void AddSmoke(const FVector &Location);
+
+  // Grid lookup for a one-tile move; falls back to a sweep before the map
+  // has been generated. bgc.DebugSweepCrossCheck compares both.
+  bool CanActorMoveTo(const AActor *Mover, const FVector &NewLocation) const;
+
+  static bool SweepCanMoveTo(const AActor *Mover, const FVector &NewLocation);
+
 private:
+  UFUNCTION()
+  void OnRep_GeneratedSeed();
+
+  BangGuChaSim::FMapLayout Layout;
+  BangGuChaSim::FFlowField FlowField;
+  BangGuChaSim::FJunctionGraph JunctionGraph;
+  BangGuChaSim::FHierarchicalPath HierarchicalPath;
+  BangGuChaSim::FSmokeField SmokeField;
+  TArray<FIntPoint> NewSmokeTiles;
+  uint64 NewSmokeFrame;
+
+  // Chunked generation; shared with the worker task that fills it
+  TSharedPtr<BangGuChaSim::FChunkedMapLayout, ESPMode::ThreadSafe>
+      ChunkedLayout;
+  TFuture<void> ChunkedLayoutTask;
+  TArray<int32> ChunkOrder;
+  int32 NextChunk;
+  int32 NextInChunk;
+  double GenerateStartTime;
+  double LayoutReadyTime;
+  int32 ActorsBeforeGenerate;
+  int32 StreamFrames;
+
+  // Maps a level file into Layout; ExpectedKey 0 accepts any level
+  bool LoadLevelFile(const FString &Path, uint64 ExpectedKey);
+  // False when a networked game could not replicate tiles of this map
+  bool CanReplicateMapSize(int32 Width, int32 Height) const;
+  static FString GetLevelCachePath(uint64 CacheKey);
+
+  void PrepareLayout();
+  // Per-match state on top of a prepared layout: smoke, the enemy manager
+  // and the flag count
+  void PrepareMatch();
+  void ReleaseMapActors();
+
+  // Soft class loads, started at BeginPlay. A null handle means there is
+  // nothing to wait for.
+  TSharedPtr<FStreamableHandle> WallClassLoad;
+  TSharedPtr<FStreamableHandle> ItemClassLoad;
+  TSharedPtr<FStreamableHandle> EnemyClassLoad;
+  double BeginPlayTime;
+  double ClassesLoadedTime;
+
+  // Layouts RestartMap has moved past a fixed Seed; 0 plays Seed itself
+  int32 NewLayoutCount;
+
+  // Kinds of actors GenerateMap still has to spawn
+  bool bWallsPending;
+  bool bFlagsPending;
+  bool bEnemiesPending;
+  int32 LastWallCount;
+  FString LastGenerateSource;
+
+  void RequestClassLoads();
+  TSharedPtr<FStreamableHandle> RequestClassLoad(const FSoftObjectPath &Path);
+  void OnClassLoaded();
+  static bool IsClassReady(const TSharedPtr<FStreamableHandle> &Load);
+  bool NeedsWallClass() const;
+  bool AreMapClassesReady() const;
+  void SpawnPendingActors();
+  void FinishGenerateMap();
+  void ReportTimeToPlayable();
+  void OnChunkedLayoutReady();
+  void StreamChunks();
+  void FinishChunkedGeneration();
+
+  // Wall mesh placement relative to each instanced wall's tile
+  FTransform WallInstanceTransform;
+  TArray<FTransform> WallTransforms;
+  bool bInstancedWallsReady;
+
+  int32 SpawnWalls();
   void SpawnWall(int32 X, int32 Y);
+  bool BeginInstancedWalls();
+  int32 SpawnInstancedWalls();
+  void AddChunkWallInstances(const BangGuChaSim::FMapChunk &Chunk);
+  bool ResolveInstancedWallMesh(UStaticMesh *&OutMesh,
+                                FTransform &OutMeshTransform) const;
+  // Pools and the enemy manager are set up before the first spawn
+  void PrepareFlags();
+  void PrepareEnemies();
+  void SpawnFlags();
+  void SpawnEnemies();
   void SpawnItem(int32 X, int32 Y);
   void SpawnEnemy(int32 X, int32 Y);
+  bool SpawnsEnemyActors() const;
+  bool UsesInstancedEnemies() const;
+  bool ResolveInstancedEnemyMesh(UStaticMesh *&OutMesh,
+                                 FTransform &OutMeshTransform) const;
 };
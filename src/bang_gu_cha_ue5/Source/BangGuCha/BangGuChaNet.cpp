@@ -0,0 +1,23 @@
+#include "BangGuChaNet.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarBangGuChaNetRelevantTiles(
+    TEXT("bgc.Net.RelevantTiles"), 12,
+    TEXT("Tiles, along either axis, beyond which enemies and smoke stop ")
+        TEXT("replicating to a client. 0 disables the grid check."),
+    ECVF_Default);
+
+bool BangGuChaIsWithinNetRelevantTiles(const AActor *Actor,
+                                       const FVector &ViewLocation,
+                                       float GridSize) {
+  const int32 Tiles = CVarBangGuChaNetRelevantTiles.GetValueOnAnyThread();
+  if (Tiles <= 0 || GridSize <= 0.f)
+    return true;
+
+  // Chebyshev distance: a square window of tiles around the viewer, the
+  // same shape the top-down camera sees
+  const FVector Delta = Actor->GetActorLocation() - ViewLocation;
+  const float Reach = (Tiles + 0.5f) * GridSize;
+  return FMath::Abs(Delta.X) <= Reach && FMath::Abs(Delta.Y) <= Reach;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+/**
+ * Grid-distance relevancy: an actor is only replicated to a viewer within
+ * bgc.Net.RelevantTiles tiles of it along both axes. Meant to be ANDed
+ * with AActor::IsNetRelevantFor, which still handles owners, hidden actors
+ * and bAlwaysRelevant.
+ */
+BANGGUCHA_API bool
+BangGuChaIsWithinNetRelevantTiles(const AActor *Actor,
+                                  const FVector &ViewLocation, float GridSize);
@@ -0,0 +1,254 @@
+#include "BangGuChaOverlapSubsystem.h"
+#include "BangGuChaEnemy.h"
+#include "BangGuChaEnemySubsystem.h"
+#include "BangGuChaGameModeBase.h"
+#include "BangGuChaItem.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaPawn.h"
+#include "BangGuChaSmoke.h"
+#include "BangGuChaStats.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+namespace {
+
+uint8 PlayerBit(int32 Index) {
+  // Players past the eighth share the last bit
+  return uint8(1u << FMath::Min(Index, 7));
+}
+
+} // namespace
+
+void UBangGuChaOverlapSubsystem::Tick(float DeltaTime) {
+  BANGGUCHA_SCOPE(GridOverlaps);
+
+  Super::Tick(DeltaTime);
+
+  // Clients have no game mode; the server decides every overlap
+  ABangGuChaGameModeBase *GameMode =
+      Cast<ABangGuChaGameModeBase>(GetWorld()->GetAuthGameMode());
+  const ABangGuChaMapGenerator *Map =
+      GameMode ? GameMode->MapGenerator : nullptr;
+  if (!Map || !Map->bGridOverlaps)
+    return;
+
+  GatherPlayers();
+  if (Players.Num() > 0) {
+    ResolveFlags(Map->GridSize);
+
+    // Managed enemies may have no actor to read their box from
+    const UClass *EnemyClass = Map->EnemyClass.Get();
+    const ABangGuChaEnemy *Default =
+        EnemyClass ? Cast<ABangGuChaEnemy>(EnemyClass->GetDefaultObject())
+                   : nullptr;
+    const float ManagedEnemyExtent =
+        Default ? float(Default->CollisionComp->GetScaledBoxExtent().X)
+                : 40.f;
+    ResolveEnemies(GameMode, Map, ManagedEnemyExtent);
+  }
+
+  for (auto &Entry : Smokes.Entries) {
+    Entry.State.bNew = false;
+  }
+}
+
+TStatId UBangGuChaOverlapSubsystem::GetStatId() const {
+  RETURN_QUICK_DECLARE_CYCLE_STAT(UBangGuChaOverlapSubsystem,
+                                  STATGROUP_Tickables);
+}
+
+bool UBangGuChaOverlapSubsystem::DoesSupportWorldType(
+    EWorldType::Type WorldType) const {
+  return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBangGuChaOverlapSubsystem::Register(AActor *Actor) {
+  UWorld *World = Actor ? Actor->GetWorld() : nullptr;
+  UBangGuChaOverlapSubsystem *Overlaps =
+      World ? World->GetSubsystem<UBangGuChaOverlapSubsystem>() : nullptr;
+  const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(Actor);
+  if (!Overlaps || !Map || !Map->bGridOverlaps)
+    return;
+
+  // Clients stop generating events as well, but only the server resolves
+  if (UPrimitiveComponent *Root =
+          Cast<UPrimitiveComponent>(Actor->GetRootComponent())) {
+    Root->SetGenerateOverlapEvents(false);
+  }
+  if (World->GetNetMode() == NM_Client)
+    return;
+
+  if (ABangGuChaItem *Item = Cast<ABangGuChaItem>(Actor)) {
+    Overlaps->bFlagsDirty |= Overlaps->Flags.Add(Item);
+  } else if (ABangGuChaSmoke *Smoke = Cast<ABangGuChaSmoke>(Actor)) {
+    Overlaps->Smokes.Add(Smoke);
+  } else if (ABangGuChaEnemy *Enemy = Cast<ABangGuChaEnemy>(Actor)) {
+    Overlaps->Enemies.Add(Enemy);
+  }
+}
+
+void UBangGuChaOverlapSubsystem::Unregister(AActor *Actor) {
+  UWorld *World = Actor ? Actor->GetWorld() : nullptr;
+  UBangGuChaOverlapSubsystem *Overlaps =
+      World ? World->GetSubsystem<UBangGuChaOverlapSubsystem>() : nullptr;
+  if (!Overlaps)
+    return;
+
+  Overlaps->bFlagsDirty |= Overlaps->Flags.Remove(Actor);
+  Overlaps->Smokes.Remove(Actor);
+  Overlaps->Enemies.Remove(Actor);
+}
+
+void UBangGuChaOverlapSubsystem::GatherPlayers() {
+  Players.Reset();
+  for (FConstPlayerControllerIterator It =
+           GetWorld()->GetPlayerControllerIterator();
+       It; ++It) {
+    const ABangGuChaPawn *Pawn =
+        It->IsValid() ? Cast<ABangGuChaPawn>((*It)->GetPawn()) : nullptr;
+    if (Pawn) {
+      const FVector Location = Pawn->GetActorLocation();
+      Players.Add(FPoint{float(Location.X), float(Location.Y),
+                         float(Pawn->CollisionComp->GetScaledBoxExtent().X),
+                         false});
+    }
+  }
+}
+
+void UBangGuChaOverlapSubsystem::ResolveFlags(float GridSize) {
+  if (bFlagsDirty) {
+    FlagHash.Reset(GridSize);
+    FlagPoints.Reset();
+    MaxFlagRadius = 0.f;
+    for (const auto &Entry : Flags.Entries) {
+      // Released flags are unregistered, so every entry is still in play
+      const ABangGuChaItem *Item = Entry.Actor.Get();
+      const FVector Location =
+          Item ? Item->GetActorLocation() : FVector(0.f, 0.f, -1e9f);
+      const float Radius =
+          Item ? Item->CollisionComp->GetScaledSphereRadius() : 0.f;
+      FlagHash.Add(float(Location.X), float(Location.Y));
+      FlagPoints.Add(FPoint{float(Location.X), float(Location.Y), Radius,
+                            false});
+      MaxFlagRadius = FMath::Max(MaxFlagRadius, Radius);
+    }
+    FlagHash.Build();
+    bFlagsDirty = false;
+  }
+
+  FlagHits.Reset();
+  for (const FPoint &Player : Players) {
+    FlagHash.ForEachNear(
+        Player.X, Player.Y, Player.Extent + MaxFlagRadius, [&](uint32 i) {
+          const FPoint &Flag = FlagPoints[i];
+          if (BangGuChaSim::Overlaps(Player.X, Player.Y, Flag.X, Flag.Y,
+                                     Player.Extent + Flag.Extent)) {
+            FlagHits.AddUnique(Flags.Entries[i].Actor.Get());
+          }
+        });
+  }
+
+  // Collecting releases the flag, which unregisters it, so the list is
+  // only changed once the lookups are done
+  for (ABangGuChaItem *Item : FlagHits) {
+    if (IsValid(Item)) {
+      Item->Collect();
+    }
+  }
+}
+
+void UBangGuChaOverlapSubsystem::ResolveEnemies(
+    ABangGuChaGameModeBase *GameMode, const ABangGuChaMapGenerator *Map,
+    float ManagedEnemyExtent) {
+  SmokePoints.Reset();
+  for (const auto &Entry : Smokes.Entries) {
+    if (const ABangGuChaSmoke *Smoke = Entry.Actor.Get()) {
+      const FVector Location = Smoke->GetActorLocation();
+      SmokePoints.Add(
+          FPoint{float(Location.X), float(Location.Y),
+                 float(Smoke->CollisionComp->GetScaledBoxExtent().X),
+                 Entry.State.bNew});
+    }
+  }
+
+  // A smoke field is read at the enemy's tile only
+  const BangGuChaSim::FSmokeField *SmokeField = Map->GetSmokeField();
+  if (SmokeField && SmokeField->IsEmpty()) {
+    SmokeField = nullptr;
+  }
+  const TArrayView<const FIntPoint> NewSmokeTiles = Map->GetNewSmokeTiles();
+  const float StunDensity = Map->SmokeStunDensity;
+
+  // Smoke first, so an enemy stunned by a cloud this frame is harmless,
+  // then the players
+  auto Resolve = [&](float X, float Y, float Extent, bool bStunned,
+                     uint8 &bInSmoke, uint8 &TouchingPlayers, auto &&Stun) {
+    bool bNowInSmoke = false;
+    bool bHitByNewSmoke = false;
+    if (SmokeField) {
+      const FIntPoint Tile = Map->WorldToTile(FVector(X, Y, 0.f));
+      bNowInSmoke = SmokeField->GetDensity(Tile.X, Tile.Y) >= StunDensity;
+      bHitByNewSmoke = NewSmokeTiles.Contains(Tile);
+    }
+    for (const FPoint &Smoke : SmokePoints) {
+      if (BangGuChaSim::Overlaps(X, Y, Smoke.X, Smoke.Y,
+                                 Extent + Smoke.Extent)) {
+        bNowInSmoke = true;
+        bHitByNewSmoke |= Smoke.bNew;
+      }
+    }
+    if ((bNowInSmoke && !bInSmoke) || bHitByNewSmoke) {
+      bStunned = Stun();
+    }
+    bInSmoke = bNowInSmoke;
+
+    uint8 Touching = 0;
+    for (int32 i = 0; i < Players.Num(); i++) {
+      const FPoint &Player = Players[i];
+      if (BangGuChaSim::Overlaps(X, Y, Player.X, Player.Y,
+                                 Extent + Player.Extent)) {
+        Touching |= PlayerBit(i);
+      }
+    }
+    const bool bBeginOverlap = (Touching & ~TouchingPlayers) != 0;
+    TouchingPlayers = Touching;
+    return bBeginOverlap && !bStunned;
+  };
+
+  if (UBangGuChaEnemySubsystem *Managed =
+          GetWorld()->GetSubsystem<UBangGuChaEnemySubsystem>()) {
+    BangGuChaSim::FEnemySwarm &Swarm = Managed->GetMutableSwarm();
+    for (int32 i = 0; i < Managed->GetNumEnemies(); i++) {
+      const bool bCaught =
+          Resolve(Swarm.X[i], Swarm.Y[i], ManagedEnemyExtent,
+                  Swarm.bIsStunned[i] != 0, Swarm.bInSmoke[i],
+                  Swarm.TouchingPlayers[i], [Managed, i]() {
+                    Managed->StunEnemy(i);
+                    return Managed->IsEnemyStunned(i);
+                  });
+      if (bCaught) {
+        GameMode->GameOver();
+      }
+    }
+  }
+
+  for (auto &Entry : Enemies.Entries) {
+    ABangGuChaEnemy *Enemy = Entry.Actor.Get();
+    if (!Enemy || Enemy->IsManaged())
+      continue;
+    const FVector Location = Enemy->GetActorLocation();
+    const bool bCaught = Resolve(
+        float(Location.X), float(Location.Y),
+        float(Enemy->CollisionComp->GetScaledBoxExtent().X),
+        Enemy->bIsStunned, Entry.State.bInSmoke, Entry.State.TouchingPlayers,
+        [Enemy]() {
+          Enemy->Stun();
+          return Enemy->bIsStunned;
+        });
+    if (bCaught) {
+      GameMode->GameOver();
+    }
+  }
+}
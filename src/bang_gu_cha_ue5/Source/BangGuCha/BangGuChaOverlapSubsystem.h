@@ -0,0 +1,120 @@
+#pragma once
+
+#include "BangGuChaOverlapSubsystem.generated.h"
+#include "CoreMinimal.h"
+#include "Sim/BangGuChaSimTileHash.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+class ABangGuChaEnemy;
+class ABangGuChaGameModeBase;
+class ABangGuChaItem;
+class ABangGuChaMapGenerator;
+class ABangGuChaSmoke;
+
+// Begin-overlap bookkeeping for one registered actor
+struct FBangGuChaOverlapState {
+  // Smoke: placed since the last pass
+  bool bNew = true;
+  // Enemy: inside smoke at the last pass
+  uint8 bInSmoke = 0;
+  // Enemy: a bit per player touched at the last pass
+  uint8 TouchingPlayers = 0;
+};
+
+// Registered actors of one kind. Adds and removes are O(1), so a map's
+// worth of flags stays cheap to register and release.
+template <typename ActorType> class TBangGuChaOverlapList {
+public:
+  struct FEntry {
+    TWeakObjectPtr<ActorType> Actor;
+    FObjectKey Key;
+    FBangGuChaOverlapState State;
+  };
+
+  bool Add(ActorType *Actor) {
+    if (Indices.Contains(FObjectKey(Actor)))
+      return false;
+    Indices.Add(FObjectKey(Actor), Entries.Num());
+    Entries.Add(FEntry{Actor, FObjectKey(Actor), FBangGuChaOverlapState()});
+    return true;
+  }
+
+  bool Remove(const AActor *Actor) {
+    int32 Index = INDEX_NONE;
+    if (!Indices.RemoveAndCopyValue(FObjectKey(Actor), Index))
+      return false;
+    const int32 Last = Entries.Num() - 1;
+    if (Index != Last) {
+      Entries[Index] = MoveTemp(Entries[Last]);
+      Indices.Add(Entries[Index].Key, Index);
+    }
+    Entries.RemoveAt(Last, 1, false);
+    return true;
+  }
+
+  TArray<FEntry> Entries;
+
+private:
+  TMap<FObjectKey, int32> Indices;
+};
+
+/**
+ * Grid replacement for the trigger overlaps of flags, smoke clouds and
+ * enemies, used when ABangGuChaMapGenerator::bGridOverlaps is set. Those
+ * actors register here and generate no overlap events. Once per frame the
+ * server looks up flags around each player in a tile hash, then makes one
+ * pass over the enemies for smoke stuns and catches. With a smoke field,
+ * stuns also read the density at each enemy's tile. Begin-overlap state
+ * is kept per enemy, so the trigger rules carry over: a stun on entering
+ * smoke or when a new cloud lands, and a catch only when an unstunned
+ * enemy starts touching a player.
+ */
+UCLASS()
+class BANGGUCHA_API UBangGuChaOverlapSubsystem
+    : public UTickableWorldSubsystem {
+  GENERATED_BODY()
+
+public:
+  virtual void Tick(float DeltaTime) override;
+  virtual TStatId GetStatId() const override;
+
+  // Turns the actor's overlap events off and tracks it when its map uses
+  // grid overlaps; does nothing otherwise
+  static void Register(AActor *Actor);
+  static void Unregister(AActor *Actor);
+
+protected:
+  virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+  // A trigger shape reduced to its XY center and half-extent
+  struct FPoint {
+    float X;
+    float Y;
+    float Extent;
+    bool bNew;
+  };
+
+  void GatherPlayers();
+  void ResolveFlags(float GridSize);
+  void ResolveEnemies(ABangGuChaGameModeBase *GameMode,
+                      const ABangGuChaMapGenerator *Map,
+                      float ManagedEnemyExtent);
+
+  TBangGuChaOverlapList<ABangGuChaItem> Flags;
+  TBangGuChaOverlapList<ABangGuChaSmoke> Smokes;
+  // Managed enemies are read from UBangGuChaEnemySubsystem instead
+  TBangGuChaOverlapList<ABangGuChaEnemy> Enemies;
+
+  // Flags by tile, rebuilt only after one is added or removed
+  BangGuChaSim::FTileHash FlagHash;
+  TArray<FPoint> FlagPoints;
+  float MaxFlagRadius = 0.f;
+  bool bFlagsDirty = true;
+
+  // Per-frame scratch
+  TArray<FPoint> Players;
+  TArray<FPoint> SmokePoints;
+  TArray<ABangGuChaItem *> FlagHits;
+};
@@ -1,13 +1,30 @@
 #include "BangGuChaPawn.h"
+#include "BangGuCha.h"
+#include "BangGuChaActorPoolSubsystem.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaOverlapSubsystem.h"
+#include "BangGuChaStats.h"
 #include "Camera/CameraComponent.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Sim/BangGuChaSimNet.h"
 
 ABangGuChaPawn::ABangGuChaPawn() {
   PrimaryActorTick.bCanEverTick = true;
 
+  // Position goes out as NetGridState instead of replicated movement
+  SetReplicateMovement(false);
+  NetUpdateFrequency = 10.f;
+  MinNetUpdateFrequency = 2.f;
+  // Co-op players all start on the same tile
+  SpawnCollisionHandlingMethod =
+      ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
   // Setup Components
   CollisionComp = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionComp"));
   RootComponent = CollisionComp;
@@ -34,28 +51,94 @@ ABangGuChaPawn::ABangGuChaPawn() {
   MaxFuel = 100.f;
   CurrentFuel = MaxFuel;
   FuelConsumptionRate = 5.f; // Per second
+  NetGridState = 0;
 
-  CurrentDirection = FVector::ZeroVector;
-  NextDirection = FVector::ZeroVector;
+  // One cloud per fart a full tank can pay for
+  SmokePoolSize = int32(MaxFuel / BangGuChaSim::FartFuelCost);
 }
 
 void ABangGuChaPawn::BeginPlay() {
   Super::BeginPlay();
-  TargetLocation = GetActorLocation();
+  const FVector Location = GetActorLocation();
+  BangGuChaSim::InitMover(Mover, float(Location.X), float(Location.Y),
+                          GridSize);
+  // Players are found through their controllers; this only turns the
+  // pawn's overlap queries off under grid overlaps
+  UBangGuChaOverlapSubsystem::Register(this);
+
+  if (!HasAuthority()) {
+    if (NetGridState != 0) {
+      OnRep_NetGridState();
+    }
+    // Smoke is spawned by the server and replicated
+    return;
+  }
+
+  NetGridState = BangGuChaSim::PackNetGridState(Mover);
+  const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  if (Map && Map->bSmokeField)
+    return;
+  if (SmokeClass.Get()) {
+    OnSmokeClassLoaded();
+  } else if (!SmokeClass.IsNull()) {
+    SmokeClassLoad = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+        SmokeClass.ToSoftObjectPath(),
+        FStreamableDelegate::CreateUObject(
+            this, &ABangGuChaPawn::OnSmokeClassLoaded));
+  }
+}
+
+void ABangGuChaPawn::OnSmokeClassLoaded() {
+  if (UBangGuChaActorPoolSubsystem *Pool =
+          GetWorld()->GetSubsystem<UBangGuChaActorPoolSubsystem>()) {
+    Pool->Prewarm(SmokeClass.Get(), SmokePoolSize);
+  }
+}
+
+void ABangGuChaPawn::GetLifetimeReplicatedProps(
+    TArray<FLifetimeProperty> &OutLifetimeProps) const {
+  Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+  DOREPLIFETIME(ABangGuChaPawn, NetGridState);
+  DOREPLIFETIME_CONDITION(ABangGuChaPawn, CurrentFuel, COND_OwnerOnly);
+}
+
+void ABangGuChaPawn::OnRep_NetGridState() {
+  BangGuChaSim::FMover Server = Mover;
+  BangGuChaSim::UnpackNetGridState(NetGridState, GridSize, Server);
+
+  if (IsLocallyControlled()) {
+    // The server state is a round trip behind the prediction; only take it
+    // once the two have drifted a whole tile apart
+    const float DX = Server.X - Mover.X;
+    const float DY = Server.Y - Mover.Y;
+    if (DX * DX + DY * DY <= GridSize * GridSize)
+      return;
+  } else {
+    // Nobody else's queued turns are known here
+    Server.NextDirection = BangGuChaSim::EDirection::None;
+  }
+
+  Mover = Server;
+  SetActorLocation(FVector(Mover.X, Mover.Y, GetActorLocation().Z));
+  if (Mover.Direction != BangGuChaSim::EDirection::None) {
+    MeshComp->SetWorldRotation(
+        BangGuChaDirectionToVector(Mover.Direction).Rotation());
+  }
 }
 
 void ABangGuChaPawn::Tick(float DeltaTime) {
+  BANGGUCHA_SCOPE(PawnTick);
+
   Super::Tick(DeltaTime);
 
   UpdateMovement(DeltaTime);
 
-  // Consume Fuel
-  if (!CurrentDirection.IsZero()) {
-    CurrentFuel -= FuelConsumptionRate * DeltaTime;
-    if (CurrentFuel <= 0) {
-      CurrentFuel = 0;
-      // Handle out of fuel logic if needed
-    }
+  // Consume Fuel; clients only predict their own
+  if (Mover.Direction != BangGuChaSim::EDirection::None &&
+      (HasAuthority() || IsLocallyControlled())) {
+    BangGuChaSim::ConsumeFuel(CurrentFuel, FuelConsumptionRate, DeltaTime);
+    // Handle out of fuel logic if needed
   }
 }
 
@@ -78,61 +161,84 @@ void ABangGuChaPawn::SetupPlayerInputComponent(
                                    &ABangGuChaPawn::MoveRight);
 }
 
-void ABangGuChaPawn::MoveUp() { NextDirection = FVector(1, 0, 0); }
-void ABangGuChaPawn::MoveDown() { NextDirection = FVector(-1, 0, 0); }
-void ABangGuChaPawn::MoveLeft() { NextDirection = FVector(0, -1, 0); }
-void ABangGuChaPawn::MoveRight() { NextDirection = FVector(0, 1, 0); }
+void ABangGuChaPawn::MoveUp() { QueueTurn(BangGuChaSim::EDirection::PosX); }
+void ABangGuChaPawn::MoveDown() { QueueTurn(BangGuChaSim::EDirection::NegX); }
+void ABangGuChaPawn::MoveLeft() { QueueTurn(BangGuChaSim::EDirection::NegY); }
+void ABangGuChaPawn::MoveRight() {
+  QueueTurn(BangGuChaSim::EDirection::PosY);
+}
+
+void ABangGuChaPawn::QueueTurn(BangGuChaSim::EDirection Direction) {
+  Mover.NextDirection = Direction;
+  if (!HasAuthority()) {
+    ServerQueueTurn(static_cast<uint8>(Direction));
+  }
+}
+
+void ABangGuChaPawn::Respawn(const FVector &Location) {
+  SetActorLocation(Location);
+  BangGuChaSim::InitMover(Mover, float(Location.X), float(Location.Y),
+                          GridSize);
+  CurrentFuel = MaxFuel;
+  NetGridState = BangGuChaSim::PackNetGridState(Mover);
+  ForceNetUpdate();
+}
+
+void ABangGuChaPawn::ServerQueueTurn_Implementation(uint8 Direction) {
+  if (Direction <= static_cast<uint8>(BangGuChaSim::EDirection::NegY)) {
+    QueueTurn(static_cast<BangGuChaSim::EDirection>(Direction));
+  }
+}
 
 void ABangGuChaPawn::UpdateMovement(float DeltaTime) {
-  FVector CurrentLoc = GetActorLocation();
+  BANGGUCHA_SCOPE(PawnUpdateMovement);
 
-  // If we are close to the target location, snap and pick new target
-  if (FVector::DistSquared(CurrentLoc, TargetLocation) < 10.f) {
-    SetActorLocation(TargetLocation);
+  const float Z = float(GetActorLocation().Z);
+  const BangGuChaSim::EDirection Before = Mover.Direction;
+  const bool bNewTarget = BangGuChaSim::StepPlayerMover(
+      Mover, DeltaTime, MoveSpeed, GridSize, [this, Z](int32 X, int32 Y) {
+        return CanMoveTo(FVector(X * GridSize, Y * GridSize, Z));
+      });
 
-    // Try to change direction if queued
-    if (!NextDirection.IsZero() &&
-        CanMoveTo(TargetLocation + NextDirection * GridSize)) {
-      CurrentDirection = NextDirection;
-    }
+  SetActorLocation(FVector(Mover.X, Mover.Y, Z));
 
-    // Continue moving in current direction if possible
-    if (!CurrentDirection.IsZero()) {
-      FVector NewTarget = TargetLocation + CurrentDirection * GridSize;
-      if (CanMoveTo(NewTarget)) {
-        TargetLocation = NewTarget;
-        // Rotate mesh to face direction
-        MeshComp->SetWorldRotation(CurrentDirection.Rotation());
-      } else {
-        // Stop if hit wall
-        CurrentDirection = FVector::ZeroVector;
-      }
-    }
-  } else {
-    // Interpolate to target
-    FVector NewLoc = FMath::VInterpConstantTo(CurrentLoc, TargetLocation,
-                                              DeltaTime, MoveSpeed);
-    SetActorLocation(NewLoc);
+  if (HasAuthority() && Mover.Direction != Before) {
+    NetGridState = BangGuChaSim::PackNetGridState(Mover);
+  }
+
+  if (bNewTarget) {
+    // Rotate mesh to face direction
+    MeshComp->SetWorldRotation(
+        BangGuChaDirectionToVector(Mover.Direction).Rotation());
   }
 }
 
 bool ABangGuChaPawn::CanMoveTo(FVector NewLocation) {
-  FHitResult Hit;
-  FCollisionQueryParams Params;
-  Params.AddIgnoredActor(this);
-
-  // Simple line trace or box sweep to check for walls
-  bool bHit = GetWorld()->SweepSingleByChannel(
-      Hit, GetActorLocation(), NewLocation, FQuat::Identity, ECC_WorldStatic,
-      FCollisionShape::MakeBox(FVector(40.f)), Params);
+  BANGGUCHA_SCOPE(PawnCanMoveTo);
 
-  return !bHit;
+  if (const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this)) {
+    return Map->CanActorMoveTo(this, NewLocation);
+  }
+  return ABangGuChaMapGenerator::SweepCanMoveTo(this, NewLocation);
 }
 
 void ABangGuChaPawn::UseFart() {
-  if (CurrentFuel >= 10.f && SmokeClass) {
-    CurrentFuel -= 10.f;
-    GetWorld()->SpawnActor<AActor>(SmokeClass, GetActorLocation(),
-                                   FRotator::ZeroRotator);
+  if (!HasAuthority()) {
+    ServerUseFart();
+    return;
+  }
+  ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  const bool bSmokeField = Map && Map->GetSmokeField();
+  UClass *Smoke = SmokeClass.Get();
+  if ((bSmokeField || Smoke) &&
+      BangGuChaSim::TrySpendFartFuel(CurrentFuel)) {
+    if (bSmokeField) {
+      Map->AddSmoke(GetActorLocation());
+    } else {
+      UBangGuChaActorPoolSubsystem::AcquireOrSpawn(
+          this, Smoke, GetActorLocation(), FRotator::ZeroRotator);
+    }
   }
 }
+
+void ABangGuChaPawn::ServerUseFart_Implementation() { UseFart(); }
@@ -3,10 +3,12 @@
 #include "BangGuChaPawn.generated.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Sim/BangGuChaSimRules.h"
 
 class UBoxComponent;
 class UCameraComponent;
 class USpringArmComponent;
+struct FStreamableHandle;
 
 UCLASS()
 class BANGGUCHA_API ABangGuChaPawn : public APawn {
@@ -22,6 +24,8 @@ public:
   virtual void Tick(float DeltaTime) override;
   virtual void SetupPlayerInputComponent(
       class UInputComponent *PlayerInputComponent) override;
+  virtual void GetLifetimeReplicatedProps(
+      TArray<FLifetimeProperty> &OutLifetimeProps) const override;
 
   // Components
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
@@ -47,23 +51,54 @@ public:
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fuel")
   float MaxFuel;
 
-  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Fuel")
+  // Replicated to the owning client only
+  UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Fuel")
   float CurrentFuel;
 
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fuel")
   float FuelConsumptionRate;
 
-  // Ability
+  // Ability. Loaded in the background from BeginPlay; until it is in,
+  // farts only work with a smoke field.
   UPROPERTY(EditDefaultsOnly, Category = "Ability")
-  TSubclassOf<class AActor> SmokeClass;
+  TSoftClassPtr<AActor> SmokeClass;
+
+  // Smoke clouds parked in the actor pool at BeginPlay
+  UPROPERTY(EditDefaultsOnly, Category = "Ability", meta = (ClampMin = "0"))
+  int32 SmokePoolSize;
 
   UFUNCTION(BlueprintCallable, Category = "Ability")
   void UseFart();
 
+  // Queues a turn exactly like the move actions; scripted runs use this
+  void QueueTurn(BangGuChaSim::EDirection Direction);
+
+  // Puts the pawn back on Location, standing still with a full tank, for a
+  // restart in place; server only
+  void Respawn(const FVector &Location);
+
 private:
-  FVector TargetLocation;
-  FVector CurrentDirection;
-  FVector NextDirection;
+  // Grid movement state, advanced by the shared sim rules
+  BangGuChaSim::FMover Mover;
+
+  // Mover packed by BangGuChaSim::PackNetGridState, rewritten by the server
+  // only when the direction changes. The owning client predicts its own
+  // moves and takes this as a correction; everyone else dead-reckons.
+  UPROPERTY(ReplicatedUsing = OnRep_NetGridState)
+  uint32 NetGridState;
+
+  UFUNCTION()
+  void OnRep_NetGridState();
+
+  TSharedPtr<FStreamableHandle> SmokeClassLoad;
+  void OnSmokeClassLoaded();
+
+  // Input from the owning client; the direction is a BangGuChaSim one
+  UFUNCTION(Server, Reliable)
+  void ServerQueueTurn(uint8 Direction);
+
+  UFUNCTION(Server, Reliable)
+  void ServerUseFart();
 
   void MoveUp();
   void MoveDown();
@@ -0,0 +1,203 @@
+#include "BangGuChaSignificanceSubsystem.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaStats.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarBangGuChaTickLOD(
+    TEXT("bgc.TickLOD"), 1,
+    TEXT("Lower the tick rate of enemies far from the player and camera."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBangGuChaTickLODNearTiles(
+    TEXT("bgc.TickLOD.NearTiles"), 8.f,
+    TEXT("Tiles from the player or camera within which actors tick every ")
+        TEXT("frame."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBangGuChaTickLODFarTiles(
+    TEXT("bgc.TickLOD.FarTiles"), 24.f,
+    TEXT("Tiles beyond which actors tick at bgc.TickLOD.FarInterval."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBangGuChaTickLODMidInterval(
+    TEXT("bgc.TickLOD.MidInterval"), 0.1f,
+    TEXT("Tick interval in seconds between NearTiles and FarTiles."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBangGuChaTickLODFarInterval(
+    TEXT("bgc.TickLOD.FarInterval"), 0.25f,
+    TEXT("Tick interval in seconds beyond FarTiles."), ECVF_Default);
+
+static FAutoConsoleCommandWithWorld BangGuChaTickLODStatsCommand(
+    TEXT("bgc.TickLODStats"),
+    TEXT("Log how many registered actors sit in each tick LOD bucket."),
+    FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld *World) {
+      if (const UBangGuChaSignificanceSubsystem *Significance =
+              World ? World->GetSubsystem<UBangGuChaSignificanceSubsystem>()
+                    : nullptr) {
+        Significance->LogStats();
+      }
+    }));
+
+void UBangGuChaSignificanceSubsystem::Tick(float DeltaTime) {
+  Super::Tick(DeltaTime);
+
+  CSV_CUSTOM_STAT(BangGuCha, TickLODNear, Counts.Near, ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(BangGuCha, TickLODMid, Counts.Mid, ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(BangGuCha, TickLODFar, Counts.Far, ECsvCustomStatOp::Set);
+
+  // Without a player every actor ticks at full rate
+  GatherViewpoints();
+  const bool bEnabled = CVarBangGuChaTickLOD.GetValueOnGameThread() != 0 &&
+                        Viewpoints.Num() > 0;
+
+  const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  const float GridSize = Map ? Map->GridSize : 100.f;
+  const float NearDist =
+      CVarBangGuChaTickLODNearTiles.GetValueOnGameThread() * GridSize;
+  const float FarDist =
+      CVarBangGuChaTickLODFarTiles.GetValueOnGameThread() * GridSize;
+  const float NearDistSq = NearDist * NearDist;
+  const float FarDistSq = FarDist * FarDist;
+
+  for (int32 Index = Actors.Num() - 1; Index >= 0; Index--) {
+    const AActor *Actor = Actors[Index].Get();
+    if (!Actor) {
+      RemoveAt(Index);
+      continue;
+    }
+    if (Buckets[Index] == EBangGuChaTickLOD::Static)
+      continue;
+
+    EBangGuChaTickLOD Bucket = EBangGuChaTickLOD::Near;
+    if (bEnabled) {
+      const FVector2D Location(Actor->GetActorLocation());
+      float DistSq = TNumericLimits<float>::Max();
+      for (const FVector2D &Viewpoint : Viewpoints) {
+        DistSq = FMath::Min(
+            DistSq, float(FVector2D::DistSquared(Location, Viewpoint)));
+      }
+      Bucket = DistSq <= NearDistSq  ? EBangGuChaTickLOD::Near
+               : DistSq <= FarDistSq ? EBangGuChaTickLOD::Mid
+                                     : EBangGuChaTickLOD::Far;
+    }
+    if (Bucket != Buckets[Index]) {
+      SetBucket(Index, Bucket);
+    }
+  }
+}
+
+void UBangGuChaSignificanceSubsystem::GatherViewpoints() {
+  Viewpoints.Reset();
+  for (FConstPlayerControllerIterator It =
+           GetWorld()->GetPlayerControllerIterator();
+       It; ++It) {
+    const APlayerController *Controller = It->IsValid() ? It->Get() : nullptr;
+    const APawn *Pawn = Controller ? Controller->GetPawn() : nullptr;
+    if (!Pawn)
+      continue;
+    Viewpoints.Add(FVector2D(Pawn->GetActorLocation()));
+    // Remote players' camera managers still track their view on the server
+    if (Controller->PlayerCameraManager) {
+      Viewpoints.Add(
+          FVector2D(Controller->PlayerCameraManager->GetCameraLocation()));
+    }
+  }
+}
+
+TStatId UBangGuChaSignificanceSubsystem::GetStatId() const {
+  RETURN_QUICK_DECLARE_CYCLE_STAT(UBangGuChaSignificanceSubsystem,
+                                  STATGROUP_Tickables);
+}
+
+bool UBangGuChaSignificanceSubsystem::DoesSupportWorldType(
+    EWorldType::Type WorldType) const {
+  return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBangGuChaSignificanceSubsystem::Register(AActor *Actor, bool bStatic) {
+  if (!Actor || Indices.Contains(Actor))
+    return;
+
+  const EBangGuChaTickLOD Bucket =
+      bStatic ? EBangGuChaTickLOD::Static : EBangGuChaTickLOD::Near;
+  Indices.Add(Actor, Actors.Num());
+  Actors.Add(Actor);
+  Keys.Add(Actor);
+  Buckets.Add(Bucket);
+  switch (Bucket) {
+  case EBangGuChaTickLOD::Static:
+    Counts.Static++;
+    break;
+  default:
+    Counts.Near++;
+    Actor->SetActorTickInterval(0.f);
+    break;
+  }
+}
+
+void UBangGuChaSignificanceSubsystem::Unregister(AActor *Actor) {
+  const int32 *Index = Actor ? Indices.Find(Actor) : nullptr;
+  if (!Index)
+    return;
+
+  // A pooled actor comes back at full rate, whatever its last bucket was
+  if (Buckets[*Index] != EBangGuChaTickLOD::Static) {
+    Actor->SetActorTickInterval(0.f);
+  }
+  RemoveAt(*Index);
+}
+
+void UBangGuChaSignificanceSubsystem::RemoveAt(int32 Index) {
+  switch (Buckets[Index]) {
+  case EBangGuChaTickLOD::Near:
+    Counts.Near--;
+    break;
+  case EBangGuChaTickLOD::Mid:
+    Counts.Mid--;
+    break;
+  case EBangGuChaTickLOD::Far:
+    Counts.Far--;
+    break;
+  case EBangGuChaTickLOD::Static:
+    Counts.Static--;
+    break;
+  }
+
+  Indices.Remove(Keys[Index]);
+  const int32 Last = Actors.Num() - 1;
+  if (Index != Last) {
+    Indices.Add(Keys[Last], Index);
+  }
+  Actors.RemoveAtSwap(Index, 1, false);
+  Keys.RemoveAtSwap(Index, 1, false);
+  Buckets.RemoveAtSwap(Index, 1, false);
+}
+
+void UBangGuChaSignificanceSubsystem::SetBucket(int32 Index,
+                                                EBangGuChaTickLOD Bucket) {
+  auto Count = [this](EBangGuChaTickLOD In) -> int32 & {
+    return In == EBangGuChaTickLOD::Near  ? Counts.Near
+           : In == EBangGuChaTickLOD::Mid ? Counts.Mid
+                                          : Counts.Far;
+  };
+  Count(Buckets[Index])--;
+  Count(Bucket)++;
+  Buckets[Index] = Bucket;
+
+  float Interval = 0.f;
+  if (Bucket == EBangGuChaTickLOD::Mid) {
+    Interval = CVarBangGuChaTickLODMidInterval.GetValueOnGameThread();
+  } else if (Bucket == EBangGuChaTickLOD::Far) {
+    Interval = CVarBangGuChaTickLODFarInterval.GetValueOnGameThread();
+  }
+  Actors[Index]->SetActorTickInterval(Interval);
+}
+
+void UBangGuChaSignificanceSubsystem::LogStats() const {
+  UE_LOG(LogTemp, Log, TEXT("Tick LOD: near %d, mid %d, far %d, static %d"),
+         Counts.Near, Counts.Mid, Counts.Far, Counts.Static);
+}
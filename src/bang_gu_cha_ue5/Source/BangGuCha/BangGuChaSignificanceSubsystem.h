@@ -0,0 +1,81 @@
+#pragma once
+
+#include "BangGuChaSignificanceSubsystem.generated.h"
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+UENUM(BlueprintType)
+enum class EBangGuChaTickLOD : uint8 {
+  // Ticks every frame
+  Near,
+  // Ticks at bgc.TickLOD.MidInterval
+  Mid,
+  // Ticks at bgc.TickLOD.FarInterval
+  Far,
+  // Never ticks; registered only to be counted
+  Static
+};
+
+USTRUCT(BlueprintType)
+struct FBangGuChaTickLODCounts {
+  GENERATED_BODY()
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Tick LOD")
+  int32 Near = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Tick LOD")
+  int32 Mid = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Tick LOD")
+  int32 Far = 0;
+
+  UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Tick LOD")
+  int32 Static = 0;
+};
+
+/**
+ * Distance-based tick LOD. Registered actors are bucketed every frame by
+ * their distance to the closest player pawn or camera over all players,
+ * and their tick interval follows the bucket. Within
+ * bgc.TickLOD.NearTiles of any player everything ticks every frame, so
+ * anything close enough to catch a player behaves exactly as without LOD.
+ */
+UCLASS()
+class BANGGUCHA_API UBangGuChaSignificanceSubsystem
+    : public UTickableWorldSubsystem {
+  GENERATED_BODY()
+
+public:
+  virtual void Tick(float DeltaTime) override;
+  virtual TStatId GetStatId() const override;
+
+  // Static actors are only counted; their tick is left alone
+  void Register(AActor *Actor, bool bStatic = false);
+  void Unregister(AActor *Actor);
+
+  UFUNCTION(BlueprintCallable, Category = "Tick LOD")
+  FBangGuChaTickLODCounts GetBucketCounts() const { return Counts; }
+
+  void LogStats() const;
+
+protected:
+  virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+  void GatherViewpoints();
+  void SetBucket(int32 Index, EBangGuChaTickLOD Bucket);
+  void RemoveAt(int32 Index);
+
+  // Parallel arrays; Indices maps an actor back to its slot. Keys still
+  // find the slot once the actor is gone.
+  TArray<TWeakObjectPtr<AActor>> Actors;
+  TArray<TObjectKey<AActor>> Keys;
+  TArray<EBangGuChaTickLOD> Buckets;
+  TMap<TObjectKey<AActor>, int32> Indices;
+
+  // Pawn and camera locations of every player, refilled each tick
+  TArray<FVector2D> Viewpoints;
+
+  FBangGuChaTickLODCounts Counts;
+};
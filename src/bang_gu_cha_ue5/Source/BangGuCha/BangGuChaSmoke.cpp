@@ -1,10 +1,20 @@
 #include "BangGuChaSmoke.h"
+#include "BangGuChaActorPoolSubsystem.h"
 #include "BangGuChaEnemy.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaNet.h"
+#include "BangGuChaOverlapSubsystem.h"
+#include "BangGuChaStats.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Sim/BangGuChaSimRules.h"
 
 ABangGuChaSmoke::ABangGuChaSmoke() {
-  PrimaryActorTick.bCanEverTick = false;
+  PrimaryActorTick.bCanEverTick = true;
+
+  // Clouds never move once placed, so only spawn and park are sent
+  bReplicates = true;
+  SetReplicateMovement(true);
 
   CollisionComp = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionComp"));
   RootComponent = CollisionComp;
@@ -15,17 +25,55 @@ ABangGuChaSmoke::ABangGuChaSmoke() {
   MeshComp->SetupAttachment(RootComponent);
 
   LifeSpan = 2.0f;
+  RemainingLife = 0.f;
 }
 
 void ABangGuChaSmoke::BeginPlay() {
   Super::BeginPlay();
-  SetLifeSpan(LifeSpan);
+  RemainingLife = LifeSpan;
+  UBangGuChaOverlapSubsystem::Register(this);
+}
+
+void ABangGuChaSmoke::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+  UBangGuChaOverlapSubsystem::Unregister(this);
+  Super::EndPlay(EndPlayReason);
+}
+
+void ABangGuChaSmoke::Tick(float DeltaTime) {
+  Super::Tick(DeltaTime);
+
+  if (HasAuthority() && !BangGuChaSim::TickLifetime(RemainingLife, DeltaTime)) {
+    UBangGuChaActorPoolSubsystem::ReleaseOrDestroy(this);
+  }
+}
+
+void ABangGuChaSmoke::OnAcquiredFromPool() {
+  RemainingLife = LifeSpan;
+  UBangGuChaOverlapSubsystem::Register(this);
+}
+
+void ABangGuChaSmoke::OnReturnedToPool() {
+  UBangGuChaOverlapSubsystem::Unregister(this);
 }
 
 void ABangGuChaSmoke::NotifyActorBeginOverlap(AActor *OtherActor) {
+  BANGGUCHA_SCOPE(SmokeOverlap);
+
   Super::NotifyActorBeginOverlap(OtherActor);
 
+  if (!HasAuthority())
+    return;
+
   if (ABangGuChaEnemy *Enemy = Cast<ABangGuChaEnemy>(OtherActor)) {
     Enemy->Stun();
   }
 }
+
+bool ABangGuChaSmoke::IsNetRelevantFor(const AActor *RealViewer,
+                                       const AActor *ViewTarget,
+                                       const FVector &SrcLocation) const {
+  const ABangGuChaMapGenerator *Map = ABangGuChaMapGenerator::Get(this);
+  return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation) &&
+         BangGuChaIsWithinNetRelevantTiles(this, SrcLocation,
+                                           Map ? Map->GridSize : 100.f);
+}
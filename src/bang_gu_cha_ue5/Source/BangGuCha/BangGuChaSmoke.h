@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BangGuChaSmoke.generated.h"
+#include "BangGuChaActorPoolSubsystem.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 
@@ -8,7 +9,8 @@ class UBoxComponent;
 class UStaticMeshComponent;
 
 UCLASS()
-class BANGGUCHA_API ABangGuChaSmoke : public AActor {
+class BANGGUCHA_API ABangGuChaSmoke : public AActor,
+                                      public IBangGuChaPooledActor {
   GENERATED_BODY()
 
 public:
@@ -16,9 +18,16 @@ public:
 
 protected:
   virtual void BeginPlay() override;
+  virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
+  virtual void Tick(float DeltaTime) override;
   virtual void NotifyActorBeginOverlap(AActor *OtherActor) override;
+  virtual bool IsNetRelevantFor(const AActor *RealViewer,
+                                const AActor *ViewTarget,
+                                const FVector &SrcLocation) const override;
+  virtual void OnAcquiredFromPool() override;
+  virtual void OnReturnedToPool() override;
 
   UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
   UBoxComponent *CollisionComp;
@@ -28,4 +37,7 @@ public:
 
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats")
   float LifeSpan;
+
+private:
+  float RemainingLife;
 };
@@ -0,0 +1,78 @@
+#include "BangGuChaStats.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_STAT(STAT_BangGuCha_PawnTick);
+DEFINE_STAT(STAT_BangGuCha_PawnUpdateMovement);
+DEFINE_STAT(STAT_BangGuCha_PawnCanMoveTo);
+DEFINE_STAT(STAT_BangGuCha_EnemyTick);
+DEFINE_STAT(STAT_BangGuCha_EnemyChooseNewDirection);
+DEFINE_STAT(STAT_BangGuCha_EnemyManagerTick);
+DEFINE_STAT(STAT_BangGuCha_EnemyInstances);
+DEFINE_STAT(STAT_BangGuCha_GenerateMap);
+DEFINE_STAT(STAT_BangGuCha_PathingUpdate);
+DEFINE_STAT(STAT_BangGuCha_MapStreamChunks);
+DEFINE_STAT(STAT_BangGuCha_ItemOverlap);
+DEFINE_STAT(STAT_BangGuCha_SmokeOverlap);
+DEFINE_STAT(STAT_BangGuCha_EnemyOverlap);
+DEFINE_STAT(STAT_BangGuCha_GridOverlaps);
+DEFINE_STAT(STAT_BangGuCha_SmokeField);
+DEFINE_STAT(STAT_BangGuCha_MatchRestart);
+
+LLM_DEFINE_TAG(BangGuCha);
+LLM_DEFINE_TAG(BangGuCha_PawnTick);
+LLM_DEFINE_TAG(BangGuCha_PawnUpdateMovement);
+LLM_DEFINE_TAG(BangGuCha_PawnCanMoveTo);
+LLM_DEFINE_TAG(BangGuCha_EnemyTick);
+LLM_DEFINE_TAG(BangGuCha_EnemyChooseNewDirection);
+LLM_DEFINE_TAG(BangGuCha_EnemyManagerTick);
+LLM_DEFINE_TAG(BangGuCha_EnemyInstances);
+LLM_DEFINE_TAG(BangGuCha_GenerateMap);
+LLM_DEFINE_TAG(BangGuCha_PathingUpdate);
+LLM_DEFINE_TAG(BangGuCha_MapStreamChunks);
+LLM_DEFINE_TAG(BangGuCha_ItemOverlap);
+LLM_DEFINE_TAG(BangGuCha_SmokeOverlap);
+LLM_DEFINE_TAG(BangGuCha_EnemyOverlap);
+LLM_DEFINE_TAG(BangGuCha_GridOverlaps);
+LLM_DEFINE_TAG(BangGuCha_SmokeField);
+LLM_DEFINE_TAG(BangGuCha_MatchRestart);
+
+CSV_DEFINE_CATEGORY_MODULE(BANGGUCHA_API, BangGuCha, true);
+
+#if CSV_PROFILER
+// Thin front end over the CSV profiler so a session can be captured from
+// the console on Development and Test builds. Files land in
+// Saved/Profiling/CSV with one row per frame.
+static FAutoConsoleCommand BangGuChaRecordFrameCsvCommand(
+    TEXT("bgc.RecordFrameCsv"),
+    TEXT("Record per-frame timings and call counts of the BangGuCha scopes ")
+        TEXT("to CSV. Usage: bgc.RecordFrameCsv [Frames] | stop. Without ")
+        TEXT("Frames it records until stopped."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(
+        [](const TArray<FString> &Args) {
+          FCsvProfiler *Profiler = FCsvProfiler::Get();
+          if (Args.Num() > 0 && Args[0].Equals(TEXT("stop"),
+                                               ESearchCase::IgnoreCase)) {
+            if (Profiler->IsCapturing()) {
+              Profiler->EndCapture();
+              UE_LOG(LogTemp, Log, TEXT("bgc.RecordFrameCsv: stopped"));
+            }
+            return;
+          }
+
+          if (Profiler->IsCapturing()) {
+            UE_LOG(LogTemp, Warning,
+                   TEXT("bgc.RecordFrameCsv: a capture is already running"));
+            return;
+          }
+
+          const int32 Frames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : -1;
+          Profiler->EnableCategoryByString(TEXT("BangGuCha"));
+          Profiler->BeginCapture(Frames > 0 ? Frames : -1, FString(),
+                                 FString::Printf(TEXT("BangGuCha_%s.csv"),
+                                                 *FDateTime::Now().ToString()));
+          UE_LOG(LogTemp, Log,
+                 TEXT("bgc.RecordFrameCsv: recording (%d frames, -1 = until "
+                      "stopped)"),
+                 Frames > 0 ? Frames : -1);
+        }));
+#endif
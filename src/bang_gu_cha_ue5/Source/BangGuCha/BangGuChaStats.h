@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+// "stat BangGuCha" shows inclusive time and call counts for every scope
+// below. The same scopes feed the BangGuCha CSV profiler category, which
+// bgc.RecordFrameCsv captures per frame.
+DECLARE_STATS_GROUP(TEXT("BangGuCha"), STATGROUP_BangGuCha, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pawn Tick"), STAT_BangGuCha_PawnTick,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pawn UpdateMovement"),
+                          STAT_BangGuCha_PawnUpdateMovement,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pawn CanMoveTo"), STAT_BangGuCha_PawnCanMoveTo,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Tick"), STAT_BangGuCha_EnemyTick,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy ChooseNewDirection"),
+                          STAT_BangGuCha_EnemyChooseNewDirection,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Manager Tick"),
+                          STAT_BangGuCha_EnemyManagerTick,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Instances"),
+                          STAT_BangGuCha_EnemyInstances, STATGROUP_BangGuCha,
+                          BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GenerateMap"), STAT_BangGuCha_GenerateMap,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pathing Update"), STAT_BangGuCha_PathingUpdate,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Map Chunk Streaming"),
+                          STAT_BangGuCha_MapStreamChunks, STATGROUP_BangGuCha,
+                          BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Item Overlap"), STAT_BangGuCha_ItemOverlap,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Smoke Overlap"), STAT_BangGuCha_SmokeOverlap,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Overlap"), STAT_BangGuCha_EnemyOverlap,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Grid Overlaps"), STAT_BangGuCha_GridOverlaps,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Smoke Field"), STAT_BangGuCha_SmokeField,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Match Restart"), STAT_BangGuCha_MatchRestart,
+                          STATGROUP_BangGuCha, BANGGUCHA_API);
+
+// Memory allocated inside each scope is tagged for the low-level memory
+// tracker, under BangGuCha/<Name> in "stat LLMFULL" and the -llmcsv
+// capture. A nested scope takes over the tag, so each tag counts only
+// what its scope allocates outside the scopes within it. Compiles away
+// without LLM.
+LLM_DECLARE_TAG_API(BangGuCha, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_PawnTick, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_PawnUpdateMovement, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_PawnCanMoveTo, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_EnemyTick, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_EnemyChooseNewDirection, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_EnemyManagerTick, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_EnemyInstances, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_GenerateMap, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_PathingUpdate, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_MapStreamChunks, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_ItemOverlap, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_SmokeOverlap, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_EnemyOverlap, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_GridOverlaps, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_SmokeField, BANGGUCHA_API);
+LLM_DECLARE_TAG_API(BangGuCha_MatchRestart, BANGGUCHA_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BANGGUCHA_API, BangGuCha);
+
+// Cycle stat, CSV timing, a per-frame CSV call count and the LLM tag for
+// one scope. Name is the stat suffix, e.g. BANGGUCHA_SCOPE(PawnTick).
+#define BANGGUCHA_SCOPE(Name)                                                  \
+  SCOPE_CYCLE_COUNTER(STAT_BangGuCha_##Name);                                  \
+  CSV_SCOPED_TIMING_STAT(BangGuCha, Name);                                     \
+  LLM_SCOPE_BYTAG(BangGuCha_##Name);                                           \
+  CSV_CUSTOM_STAT(BangGuCha, Name##Calls, 1, ECsvCustomStatOp::Accumulate)
@@ -0,0 +1,139 @@
+#include "BangGuChaSimEnemySwarm.h"
+#include "BangGuChaSimRules.h"
+
+#include <algorithm>
+
+namespace BangGuChaSim {
+
+void FEnemySwarm::Reset() {
+  X.clear();
+  Y.clear();
+  TargetX.clear();
+  TargetY.clear();
+  Direction.clear();
+  Remaining.clear();
+  PendingTime.clear();
+  StunTimer.clear();
+  bIsStunned.clear();
+  bNewTarget.clear();
+  TouchingPlayers.clear();
+  bInSmoke.clear();
+}
+
+void FEnemySwarm::Reserve(size_t Count) {
+  X.reserve(Count);
+  Y.reserve(Count);
+  TargetX.reserve(Count);
+  TargetY.reserve(Count);
+  Direction.reserve(Count);
+  Remaining.reserve(Count);
+  PendingTime.reserve(Count);
+  StunTimer.reserve(Count);
+  bIsStunned.reserve(Count);
+  bNewTarget.reserve(Count);
+  TouchingPlayers.reserve(Count);
+  bInSmoke.reserve(Count);
+}
+
+size_t FEnemySwarm::Add(FTile Spawn, float GridSize, EDirection Initial) {
+  X.push_back(Spawn.X * GridSize);
+  Y.push_back(Spawn.Y * GridSize);
+  TargetX.push_back(Spawn.X);
+  TargetY.push_back(Spawn.Y);
+  Direction.push_back(Initial);
+  Remaining.push_back(0);
+  PendingTime.push_back(0);
+  StunTimer.push_back(0.f);
+  bIsStunned.push_back(0);
+  bNewTarget.push_back(0);
+  TouchingPlayers.push_back(0);
+  bInSmoke.push_back(0);
+  return X.size() - 1;
+}
+
+void FEnemySwarm::Stun(size_t Index, float Duration) {
+  bool bStunned = false;
+  ApplyStun(bStunned, StunTimer[Index], Duration);
+  bIsStunned[Index] = bStunned;
+}
+
+void FEnemySwarm::Advance(float DeltaTime, const FEnemySwarmParams &Params,
+                          float PlayerX, float PlayerY,
+                          const FOccupancyGrid &Grid,
+                          const FFlowField *FlowField,
+                          const FJunctionGraph *Graph,
+                          const FHierarchicalPath *Hierarchical) {
+  const FEnemySwarmSnapshot Snapshot{PlayerX, PlayerY, &Grid, FlowField,
+                                     Graph, Hierarchical};
+  AdvanceRange(0, Num(), DeltaTime, Params, Snapshot);
+}
+
+void FEnemySwarm::PreparePaths(float DeltaTime,
+                               const FEnemySwarmParams &Params,
+                               FHierarchicalPath &Path) const {
+  // A step decides at its target and at every center after it, each a tile
+  // further on, and each decision reads the tiles next to it. Substeps
+  // carried over from the last step add at most one.
+  const int64_t Substeps = SubstepTime(DeltaTime) / SubstepTimeUnits + 1;
+  const int64_t Distance =
+      Substeps * MoveUnitsPerSubstep(Params.MoveSpeed, Params.GridSize);
+  const int32_t Reach = static_cast<int32_t>(Distance / TileUnits) + 1;
+
+  // Every cluster overlapping the square around the target covers all the
+  // tiles the step can read
+  const int32_t Size = Path.GetClusterSize();
+  for (size_t i = 0; i < Num(); i++) {
+    const int32_t MinX = std::max(TargetX[i] - Reach, 0) / Size * Size;
+    const int32_t MinY = std::max(TargetY[i] - Reach, 0) / Size * Size;
+    for (int32_t TileY = MinY; TileY <= TargetY[i] + Reach; TileY += Size) {
+      for (int32_t TileX = MinX; TileX <= TargetX[i] + Reach; TileX += Size)
+        Path.Prepare(FTile{TileX, TileY});
+    }
+  }
+}
+
+void FEnemySwarm::AdvanceRange(size_t Begin, size_t End, float DeltaTime,
+                               const FEnemySwarmParams &Params,
+                               const FEnemySwarmSnapshot &Snapshot) {
+  const FOccupancyGrid &Grid = *Snapshot.Grid;
+  auto CanEnter = [&Grid](int32_t TileX, int32_t TileY) {
+    return Grid.IsWalkable(TileX, TileY);
+  };
+
+  for (size_t i = Begin; i < End; i++) {
+    bNewTarget[i] = 0;
+
+    if (bIsStunned[i]) {
+      bool bStunned = true;
+      TickStun(bStunned, StunTimer[i], DeltaTime);
+      bIsStunned[i] = bStunned;
+      continue;
+    }
+
+    // Gathered into a local so the shared movement rules run on registers
+    FMover Mover;
+    Mover.Target = FTile{TargetX[i], TargetY[i]};
+    Mover.Direction = Direction[i];
+    Mover.Remaining = Remaining[i];
+    Mover.PendingTime = PendingTime[i];
+
+    bNewTarget[i] = StepEnemyMover(
+        Mover, DeltaTime, Params.MoveSpeed, Params.GridSize, [&]() {
+          return ChooseEnemyDirection(Mover.Target, Mover.X, Mover.Y,
+                                      Mover.Direction, Snapshot.PlayerX,
+                                      Snapshot.PlayerY, Snapshot.Graph,
+                                      Snapshot.Hierarchical,
+                                      Snapshot.FlowField, CanEnter);
+        });
+
+    X[i] = Mover.X;
+    Y[i] = Mover.Y;
+    TargetX[i] = Mover.Target.X;
+    TargetY[i] = Mover.Target.Y;
+    Direction[i] = Mover.Direction;
+    Remaining[i] = Mover.Remaining;
+    PendingTime[i] = Mover.PendingTime;
+  }
+}
+
+} // namespace BangGuChaSim
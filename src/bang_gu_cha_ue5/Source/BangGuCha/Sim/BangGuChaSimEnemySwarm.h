@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BangGuChaSimFlowField.h"
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimHierarchicalPath.h"
+#include "BangGuChaSimJunctionGraph.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+struct FEnemySwarmParams {
+  float MoveSpeed = 200.f;
+  float GridSize = 100.f;
+};
+
+// World state every enemy reads during one step; nothing in it may change
+// while the step runs
+struct FEnemySwarmSnapshot {
+  float PlayerX = 0.f;
+  float PlayerY = 0.f;
+  const FOccupancyGrid *Grid = nullptr;
+  const FFlowField *FlowField = nullptr;
+  const FJunctionGraph *Graph = nullptr;
+  const FHierarchicalPath *Hierarchical = nullptr;
+};
+
+/**
+ * All enemies of a match in struct-of-arrays form. Advance runs the same
+ * per-enemy rules as ABangGuChaEnemy (stun countdown, grid movement, chase
+ * decision at tile centers) for every enemy in one linear pass, so large
+ * swarms cost a tight loop instead of one actor tick each.
+ */
+struct FEnemySwarm {
+  void Reset();
+  void Reserve(size_t Count);
+
+  size_t Add(FTile Spawn, float GridSize,
+             EDirection Initial = EDirection::PosX);
+  size_t Num() const { return X.size(); }
+
+  void Stun(size_t Index, float Duration);
+
+  void Advance(float DeltaTime, const FEnemySwarmParams &Params,
+               float PlayerX, float PlayerY, const FOccupancyGrid &Grid,
+               const FFlowField *FlowField,
+               const FJunctionGraph *Graph = nullptr,
+               const FHierarchicalPath *Hierarchical = nullptr);
+
+  // Floods the hierarchical path's clusters around every enemy's target
+  // tile, as far as a DeltaTime step can carry it. Runs before a step with
+  // the same DeltaTime and Params, since the step itself only reads the
+  // path.
+  void PreparePaths(float DeltaTime, const FEnemySwarmParams &Params,
+                    FHierarchicalPath &Path) const;
+
+  // Steps enemies [Begin, End). Reads only Snapshot and their own slots and
+  // writes only their own slots, so disjoint ranges may run concurrently.
+  void AdvanceRange(size_t Begin, size_t End, float DeltaTime,
+                    const FEnemySwarmParams &Params,
+                    const FEnemySwarmSnapshot &Snapshot);
+
+  /**
+   * Advance with the enemies split into batches of BatchSize. No enemy
+   * reads another's state, so the result is bit for bit the same as
+   * Advance for any batch size or schedule.
+   *
+   * ParallelFor(Num, Body) must call Body(i) once for every i in [0, Num)
+   * and return when all calls are done.
+   */
+  template <typename ParallelForFn>
+  void AdvanceParallel(float DeltaTime, const FEnemySwarmParams &Params,
+                       const FEnemySwarmSnapshot &Snapshot, size_t BatchSize,
+                       ParallelForFn &&ParallelFor) {
+    const size_t Count = Num();
+    if (BatchSize == 0 || Count <= BatchSize) {
+      AdvanceRange(0, Count, DeltaTime, Params, Snapshot);
+      return;
+    }
+    const size_t NumBatches = (Count + BatchSize - 1) / BatchSize;
+    ParallelFor(static_cast<int32_t>(NumBatches), [&](int32_t Batch) {
+      const size_t Begin = static_cast<size_t>(Batch) * BatchSize;
+      const size_t End = Begin + BatchSize < Count ? Begin + BatchSize : Count;
+      AdvanceRange(Begin, End, DeltaTime, Params, Snapshot);
+    });
+  }
+
+  // World position on the XY plane
+  std::vector<float> X;
+  std::vector<float> Y;
+  // Tile being moved into
+  std::vector<int32_t> TargetX;
+  std::vector<int32_t> TargetY;
+  std::vector<EDirection> Direction;
+  // FMover::Remaining and FMover::PendingTime
+  std::vector<int32_t> Remaining;
+  std::vector<int32_t> PendingTime;
+  std::vector<float> StunTimer;
+  std::vector<uint8_t> bIsStunned;
+  // Set by Advance when the enemy picked a new target tile this step
+  std::vector<uint8_t> bNewTarget;
+  // Overlap state from the previous step, for begin-overlap detection.
+  // A bit per player touched; the headless world has one player, bit 0.
+  std::vector<uint8_t> TouchingPlayers;
+  std::vector<uint8_t> bInSmoke;
+};
+
+} // namespace BangGuChaSim
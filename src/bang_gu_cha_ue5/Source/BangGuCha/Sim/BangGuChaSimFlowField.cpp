@@ -0,0 +1,129 @@
+#include "BangGuChaSimFlowField.h"
+
+#include <algorithm>
+
+namespace BangGuChaSim {
+
+void FFlowField::Init(const FOccupancyGrid *InGrid) {
+  Reset();
+  Grid = InGrid;
+  if (!Grid || !Grid->IsValid())
+    return;
+
+  Width = Grid->GetWidth();
+  const size_t NumTiles = Grid->GetNumTiles();
+  for (FBuffer &Buffer : Buffers) {
+    Buffer.Dirs.assign(NumTiles, 0);
+    Buffer.Stamps.assign(NumTiles, 0);
+  }
+  Queue.resize(NumTiles);
+}
+
+void FFlowField::Reset() {
+  Grid = nullptr;
+  Width = 0;
+  for (FBuffer &Buffer : Buffers) {
+    Buffer.Dirs.clear();
+    Buffer.Stamps.clear();
+    Buffer.Generation = 0;
+  }
+  Front = 0;
+  Queue.clear();
+  QueueHead = QueueTail = 0;
+  bPending = false;
+  bQueued = false;
+  PendingGoal = PublishedGoal = QueuedGoal = FTile{-1, -1};
+}
+
+void FFlowField::SetGoal(FTile Goal) {
+  if (!Grid || !Grid->IsWalkable(Goal.X, Goal.Y))
+    return;
+  if (bPending) {
+    // Restarting here would throw the search away every time the goal
+    // moves; it publishes first and the latest goal follows
+    bQueued = Goal != PendingGoal;
+    QueuedGoal = Goal;
+    return;
+  }
+  if (Goal == PublishedGoal)
+    return;
+  StartSearch(Goal);
+}
+
+void FFlowField::StartSearch(FTile Goal) {
+  FBuffer &Back = Buffers[1 - Front];
+  // Stamps tag the tiles visited by this search, so nothing is cleared
+  // between rebuilds except on the (very rare) generation wrap-around.
+  const uint32_t NewGeneration =
+      std::max(Buffers[0].Generation, Buffers[1].Generation) + 1;
+  if (NewGeneration == 0) {
+    std::fill(Back.Stamps.begin(), Back.Stamps.end(), 0u);
+    Back.Generation = 1;
+  } else {
+    Back.Generation = NewGeneration;
+  }
+
+  const size_t GoalIndex = static_cast<size_t>(Goal.Y) * Width + Goal.X;
+  Back.Stamps[GoalIndex] = Back.Generation;
+  Back.Dirs[GoalIndex] = 0;
+
+  Queue[0] = static_cast<int32_t>(GoalIndex);
+  QueueHead = 0;
+  QueueTail = 1;
+  PendingGoal = Goal;
+  bPending = true;
+}
+
+bool FFlowField::Update(int32_t MaxTiles) {
+  if (!bPending)
+    return false;
+
+  FBuffer &Back = Buffers[1 - Front];
+  const uint32_t Generation = Back.Generation;
+  uint32_t *Stamps = Back.Stamps.data();
+  uint8_t *Dirs = Back.Dirs.data();
+  int32_t *Open = Queue.data();
+
+  // Neighbour directions paired with the step pointing back at the current
+  // tile
+  static constexpr EDirection Expand[4] = {EDirection::PosX, EDirection::NegX,
+                                           EDirection::PosY, EDirection::NegY};
+
+  int32_t Expanded = 0;
+  while (QueueHead < QueueTail && Expanded < MaxTiles) {
+    const int32_t Index = Open[QueueHead++];
+    const int32_t X = Index % Width;
+    const int32_t Y = Index / Width;
+    Expanded++;
+
+    for (EDirection Dir : Expand) {
+      const int32_t NX = X + StepX(Dir);
+      const int32_t NY = Y + StepY(Dir);
+      if (!Grid->IsWalkable(NX, NY))
+        continue;
+
+      const int32_t NIndex = NY * Width + NX;
+      if (Stamps[NIndex] == Generation)
+        continue;
+
+      Stamps[NIndex] = Generation;
+      Dirs[NIndex] = static_cast<uint8_t>(Opposite(Dir));
+      Open[QueueTail++] = NIndex;
+    }
+  }
+
+  if (QueueHead < QueueTail)
+    return false;
+
+  Front = 1 - Front;
+  PublishedGoal = PendingGoal;
+  bPending = false;
+  if (bQueued) {
+    bQueued = false;
+    if (QueuedGoal != PublishedGoal)
+      StartSearch(QueuedGoal);
+  }
+  return true;
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * Breadth-first flow field toward a single goal tile (the player).
+ * Every reachable tile stores the one-tile step that leads to the goal, so
+ * an enemy picks its next direction with a single lookup.
+ *
+ * Rebuilds are time-sliced: SetGoal starts a new search into a back buffer,
+ * Update expands a bounded number of tiles per call, and the finished field
+ * is published with a buffer swap. Readers always see the last complete
+ * field. A goal set while a search runs waits for it to publish, so a goal
+ * that moves faster than a rebuild still gets fresh fields.
+ */
+class FFlowField {
+public:
+  void Init(const FOccupancyGrid *InGrid);
+  void Reset();
+
+  // Starts a new search unless one toward Goal is already done or running.
+  // While another search runs, Goal is queued to start once it publishes;
+  // only the latest queued goal is kept.
+  void SetGoal(FTile Goal);
+
+  // Expands at most MaxTiles tiles of the pending search. Returns true when
+  // a search finished and was published during this call; a queued goal
+  // then starts on the next call.
+  bool Update(int32_t MaxTiles);
+
+  // Direction toward the goal, or None when the tile is unreached or is the
+  // goal itself.
+  EDirection GetStep(int32_t X, int32_t Y) const {
+    if (!Grid || !Grid->IsInBounds(X, Y))
+      return EDirection::None;
+    const FBuffer &Buffer = Buffers[Front];
+    const size_t Index = static_cast<size_t>(Y) * Width + X;
+    if (Buffer.Stamps[Index] != Buffer.Generation)
+      return EDirection::None;
+    return static_cast<EDirection>(Buffer.Dirs[Index]);
+  }
+
+  bool IsReady() const { return Buffers[Front].Generation != 0; }
+  bool IsBuilding() const { return bPending || bQueued; }
+  FTile GetGoal() const { return PublishedGoal; }
+
+private:
+  void StartSearch(FTile Goal);
+
+  struct FBuffer {
+    std::vector<uint8_t> Dirs;
+    std::vector<uint32_t> Stamps;
+    uint32_t Generation = 0;
+  };
+
+  const FOccupancyGrid *Grid = nullptr;
+  int32_t Width = 0;
+
+  FBuffer Buffers[2];
+  int32_t Front = 0;
+
+  std::vector<int32_t> Queue;
+  size_t QueueHead = 0;
+  size_t QueueTail = 0;
+  bool bPending = false;
+
+  FTile PendingGoal = {-1, -1};
+  FTile PublishedGoal = {-1, -1};
+  // Latest goal set while a search was running
+  FTile QueuedGoal = {-1, -1};
+  bool bQueued = false;
+};
+
+} // namespace BangGuChaSim
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * Packed wall map, one bit per tile (set = blocked).
+ * Tiles outside the map are never walkable.
+ */
+class FOccupancyGrid {
+public:
+  void Init(int32_t InWidth, int32_t InHeight) {
+    Width = InWidth > 0 ? InWidth : 0;
+    Height = InHeight > 0 ? InHeight : 0;
+    Words.assign((static_cast<size_t>(Width) * Height + 63) / 64, 0);
+  }
+
+  void Reset() { Init(0, 0); }
+
+  // Init, then copies bits laid out as GetWords() from Data, which needs
+  // no alignment. Bits past the last tile are cleared.
+  void InitFromWords(int32_t InWidth, int32_t InHeight, const void *Data) {
+    Init(InWidth, InHeight);
+    if (Words.empty())
+      return;
+    std::memcpy(Words.data(), Data, Words.size() * sizeof(uint64_t));
+    const size_t Tail = GetNumTiles() & 63;
+    if (Tail != 0)
+      Words.back() &= (uint64_t(1) << Tail) - 1;
+  }
+
+  // Sets or clears every tile at once; bits past the last tile stay clear
+  void Fill(bool bBlocked) {
+    Words.assign(Words.size(), bBlocked ? ~uint64_t(0) : 0);
+    const size_t Tail = GetNumTiles() & 63;
+    if (bBlocked && Tail != 0)
+      Words.back() = (uint64_t(1) << Tail) - 1;
+  }
+
+  void SetBlocked(int32_t X, int32_t Y, bool bBlocked = true) {
+    if (!IsInBounds(X, Y))
+      return;
+    const size_t Index = static_cast<size_t>(Y) * Width + X;
+    const uint64_t Bit = uint64_t(1) << (Index & 63);
+    if (bBlocked)
+      Words[Index >> 6] |= Bit;
+    else
+      Words[Index >> 6] &= ~Bit;
+  }
+
+  bool IsInBounds(int32_t X, int32_t Y) const {
+    return static_cast<uint32_t>(X) < static_cast<uint32_t>(Width) &&
+           static_cast<uint32_t>(Y) < static_cast<uint32_t>(Height);
+  }
+
+  bool IsWalkable(int32_t X, int32_t Y) const {
+    if (!IsInBounds(X, Y))
+      return false;
+    const size_t Index = static_cast<size_t>(Y) * Width + X;
+    return (Words[Index >> 6] & (uint64_t(1) << (Index & 63))) == 0;
+  }
+
+  bool IsValid() const { return Width > 0 && Height > 0; }
+  int32_t GetWidth() const { return Width; }
+  int32_t GetHeight() const { return Height; }
+  size_t GetNumTiles() const { return static_cast<size_t>(Width) * Height; }
+
+  const std::vector<uint64_t> &GetWords() const { return Words; }
+
+private:
+  int32_t Width = 0;
+  int32_t Height = 0;
+  std::vector<uint64_t> Words;
+};
+
+} // namespace BangGuChaSim
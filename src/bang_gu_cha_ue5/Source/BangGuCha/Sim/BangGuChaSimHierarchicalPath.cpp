@@ -0,0 +1,525 @@
+#include "BangGuChaSimHierarchicalPath.h"
+
+#include <algorithm>
+
+namespace BangGuChaSim {
+
+namespace {
+
+constexpr EDirection Dirs[4] = {EDirection::PosX, EDirection::NegX,
+                                EDirection::PosY, EDirection::NegY};
+
+// Runs this long or longer get an entrance at both ends
+constexpr int32_t LongRun = 6;
+
+} // namespace
+
+void FHierarchicalPath::Build(const FOccupancyGrid *InGrid,
+                              int32_t InClusterSize) {
+  Reset();
+  if (!InGrid || !InGrid->IsValid())
+    return;
+
+  Grid = InGrid;
+  ClusterSize = std::max(InClusterSize, 4);
+  Stride = ClusterSize + 2;
+  ClustersX = (Grid->GetWidth() + ClusterSize - 1) / ClusterSize;
+  ClustersY = (Grid->GetHeight() + ClusterSize - 1) / ClusterSize;
+  Clusters.resize(static_cast<size_t>(ClustersX) * ClustersY);
+  for (int32_t CY = 0; CY < ClustersY; CY++) {
+    for (int32_t CX = 0; CX < ClustersX; CX++) {
+      FCluster &Cluster = Clusters[static_cast<size_t>(CY * ClustersX + CX)];
+      Cluster.X0 = CX * ClusterSize;
+      Cluster.Y0 = CY * ClusterSize;
+      Cluster.X1 = std::min(Cluster.X0 + ClusterSize, Grid->GetWidth());
+      Cluster.Y1 = std::min(Cluster.Y0 + ClusterSize, Grid->GetHeight());
+    }
+  }
+
+  for (int32_t Index = 0; Index < static_cast<int32_t>(Clusters.size());
+       Index++)
+    BuildCluster(Index);
+  Renumber();
+}
+
+void FHierarchicalPath::Reset() {
+  Grid = nullptr;
+  ClustersX = ClustersY = 0;
+  Clusters.clear();
+  DirtyClusters.clear();
+  FieldBuilds = 0;
+  NodeCluster.clear();
+  NodePartner.clear();
+  GoalDist.clear();
+  Settled.clear();
+  Component.clear();
+  Buckets.clear();
+  ClearGoal();
+}
+
+int32_t FHierarchicalPath::NeighbourOf(int32_t Cluster, int32_t Side) const {
+  const int32_t CX = Cluster % ClustersX;
+  const int32_t CY = Cluster / ClustersX;
+  switch (Side) {
+  case SideNegX:
+    return CX > 0 ? Cluster - 1 : -1;
+  case SidePosX:
+    return CX + 1 < ClustersX ? Cluster + 1 : -1;
+  case SideNegY:
+    return CY > 0 ? Cluster - ClustersX : -1;
+  default:
+    return CY + 1 < ClustersY ? Cluster + ClustersX : -1;
+  }
+}
+
+void FHierarchicalPath::ScanSide(const FCluster &Cluster, int32_t Side,
+                                 std::vector<FTile> &Out) const {
+  // Tiles along the side paired with the tiles just across it. Both
+  // clusters scan the same pairs in the same order, so entrance i of one
+  // side faces entrance i of the other.
+  const bool bVertical = Side == SideNegX || Side == SidePosX;
+  const int32_t Begin = bVertical ? Cluster.Y0 : Cluster.X0;
+  const int32_t End = bVertical ? Cluster.Y1 : Cluster.X1;
+  const int32_t Inside = Side == SideNegX   ? Cluster.X0
+                         : Side == SidePosX ? Cluster.X1 - 1
+                         : Side == SideNegY ? Cluster.Y0
+                                            : Cluster.Y1 - 1;
+  const int32_t Across = Side == SideNegX || Side == SideNegY ? Inside - 1
+                                                              : Inside + 1;
+  auto TileAt = [&](int32_t Along) {
+    return bVertical ? FTile{Inside, Along} : FTile{Along, Inside};
+  };
+  auto IsOpen = [&](int32_t Along) {
+    return bVertical ? Grid->IsWalkable(Inside, Along) &&
+                           Grid->IsWalkable(Across, Along)
+                     : Grid->IsWalkable(Along, Inside) &&
+                           Grid->IsWalkable(Along, Across);
+  };
+
+  int32_t RunStart = -1;
+  for (int32_t Along = Begin; Along <= End; Along++) {
+    const bool bOpen = Along < End && IsOpen(Along);
+    if (bOpen && RunStart < 0)
+      RunStart = Along;
+    if (bOpen || RunStart < 0)
+      continue;
+
+    const int32_t RunEnd = Along - 1;
+    if (RunEnd - RunStart + 1 < LongRun) {
+      Out.push_back(TileAt((RunStart + RunEnd) / 2));
+    } else {
+      Out.push_back(TileAt(RunStart));
+      Out.push_back(TileAt(RunEnd));
+    }
+    RunStart = -1;
+  }
+}
+
+void FHierarchicalPath::LoadOpen(const FCluster &Cluster) {
+  Open.assign(static_cast<size_t>(Stride) * Stride, 0);
+  for (int32_t Y = Cluster.Y0; Y < Cluster.Y1; Y++) {
+    for (int32_t X = Cluster.X0; X < Cluster.X1; X++)
+      Open[static_cast<size_t>(LocalIndex(Cluster, X, Y))] =
+          Grid->IsWalkable(X, Y) ? 1 : 0;
+  }
+}
+
+void FHierarchicalPath::FloodCluster(
+    const std::vector<std::pair<int32_t, int32_t>> &Sorted,
+    std::vector<int32_t> &Out) {
+  // Breadth-first over Open from seeds that start at different distances:
+  // a seed joins the front once the queue has caught up with its distance
+  Out.assign(Open.size(), Unreachable);
+  Queue.clear();
+  size_t Head = 0;
+  size_t NextSeed = 0;
+  const int32_t Offsets[4] = {1, -1, Stride, -Stride};
+  for (;;) {
+    int32_t Local;
+    if (Head < Queue.size() &&
+        (NextSeed == Sorted.size() ||
+         Out[static_cast<size_t>(Queue[Head])] <= Sorted[NextSeed].first)) {
+      Local = Queue[Head++];
+    } else if (NextSeed < Sorted.size()) {
+      const std::pair<int32_t, int32_t> &Seed = Sorted[NextSeed++];
+      if (Seed.first >= Out[static_cast<size_t>(Seed.second)])
+        continue;
+      Out[static_cast<size_t>(Seed.second)] = Seed.first;
+      Local = Seed.second;
+    } else {
+      break;
+    }
+
+    const int32_t Dist = Out[static_cast<size_t>(Local)];
+    for (int32_t Offset : Offsets) {
+      const size_t Next = static_cast<size_t>(Local + Offset);
+      if (Open[Next] && Out[Next] > Dist + 1) {
+        Out[Next] = Dist + 1;
+        Queue.push_back(static_cast<int32_t>(Next));
+      }
+    }
+  }
+}
+
+void FHierarchicalPath::BuildCluster(int32_t Index) {
+  FCluster &Cluster = Clusters[static_cast<size_t>(Index)];
+  Cluster.Nodes.clear();
+  for (int32_t Side = 0; Side < NumSides; Side++) {
+    Cluster.SideStart[Side] = static_cast<int32_t>(Cluster.Nodes.size());
+    ScanSide(Cluster, Side, Cluster.Nodes);
+  }
+  Cluster.SideStart[NumSides] = static_cast<int32_t>(Cluster.Nodes.size());
+
+  const size_t NumNodes = Cluster.Nodes.size();
+  LoadOpen(Cluster);
+  Cluster.EdgeStart.assign(1, 0);
+  Cluster.Edges.clear();
+  for (size_t From = 0; From < NumNodes; From++) {
+    const FTile Start = Cluster.Nodes[From];
+    Seeds.assign(1, {0, LocalIndex(Cluster, Start.X, Start.Y)});
+    FloodCluster(Seeds, LocalDist);
+    for (size_t To = 0; To < NumNodes; To++) {
+      const FTile End = Cluster.Nodes[To];
+      const int32_t Length =
+          LocalDist[static_cast<size_t>(LocalIndex(Cluster, End.X, End.Y))];
+      if (To != From && Length != Unreachable)
+        Cluster.Edges.emplace_back(static_cast<int32_t>(To), Length);
+    }
+    Cluster.EdgeStart.push_back(static_cast<int32_t>(Cluster.Edges.size()));
+  }
+
+  Cluster.bDirty = false;
+  Cluster.Field.clear();
+  Cluster.FieldKey.clear();
+  Cluster.FieldStamp = 0;
+}
+
+void FHierarchicalPath::Renumber() {
+  int32_t Total = 0;
+  for (FCluster &Cluster : Clusters) {
+    Cluster.NodeBase = Total;
+    Total += static_cast<int32_t>(Cluster.Nodes.size());
+  }
+
+  NodeCluster.resize(static_cast<size_t>(Total));
+  NodePartner.resize(static_cast<size_t>(Total));
+  for (int32_t Index = 0; Index < static_cast<int32_t>(Clusters.size());
+       Index++) {
+    const FCluster &Cluster = Clusters[static_cast<size_t>(Index)];
+    for (int32_t Side = 0; Side < NumSides; Side++) {
+      // Sides pair up as NegX/PosX and NegY/PosY
+      const int32_t Facing = Side ^ 1;
+      const int32_t Neighbour = NeighbourOf(Index, Side);
+      for (int32_t Node = Cluster.SideStart[Side];
+           Node < Cluster.SideStart[Side + 1]; Node++) {
+        const FCluster &Other = Clusters[static_cast<size_t>(Neighbour)];
+        const size_t Id = static_cast<size_t>(Cluster.NodeBase + Node);
+        NodeCluster[Id] = Index;
+        NodePartner[Id] = Other.NodeBase + Other.SideStart[Facing] +
+                          (Node - Cluster.SideStart[Side]);
+      }
+    }
+  }
+  GoalDist.assign(static_cast<size_t>(Total), Unreachable);
+  Settled.assign(static_cast<size_t>(Total), 0);
+
+  // Union-find over both kinds of edge
+  Component.resize(static_cast<size_t>(Total));
+  for (int32_t Id = 0; Id < Total; Id++)
+    Component[static_cast<size_t>(Id)] = Id;
+  auto Find = [this](int32_t Id) {
+    while (Component[static_cast<size_t>(Id)] != Id) {
+      int32_t &Parent = Component[static_cast<size_t>(Id)];
+      Parent = Component[static_cast<size_t>(Parent)];
+      Id = Parent;
+    }
+    return Id;
+  };
+  auto Union = [&](int32_t A, int32_t B) {
+    A = Find(A);
+    B = Find(B);
+    if (A != B)
+      Component[static_cast<size_t>(std::max(A, B))] = std::min(A, B);
+  };
+  int32_t Longest = 1;
+  for (const FCluster &Cluster : Clusters) {
+    for (size_t Node = 0; Node + 1 < Cluster.EdgeStart.size(); Node++) {
+      for (int32_t Edge = Cluster.EdgeStart[Node];
+           Edge < Cluster.EdgeStart[Node + 1]; Edge++) {
+        const std::pair<int32_t, int32_t> &To =
+            Cluster.Edges[static_cast<size_t>(Edge)];
+        Union(Cluster.NodeBase + static_cast<int32_t>(Node),
+              Cluster.NodeBase + To.first);
+        Longest = std::max(Longest, To.second);
+      }
+    }
+  }
+  for (int32_t Id = 0; Id < Total; Id++)
+    Union(Id, NodePartner[static_cast<size_t>(Id)]);
+  for (int32_t Id = 0; Id < Total; Id++)
+    Component[static_cast<size_t>(Id)] = Find(Id);
+
+  // SetGoal seeds the goal cluster's entrances at their flood distance,
+  // which a winding cluster can push well past its longest edge. No path
+  // inside one cluster is longer than its tile count.
+  Buckets.assign(
+      static_cast<size_t>(std::max(Longest, ClusterSize * ClusterSize)) + 1,
+      {});
+}
+
+void FHierarchicalPath::MarkTileChanged(int32_t X, int32_t Y) {
+  if (!IsBuilt() || !Grid->IsInBounds(X, Y))
+    return;
+
+  auto Mark = [this](int32_t Index) {
+    if (Index < 0 || Clusters[static_cast<size_t>(Index)].bDirty)
+      return;
+    Clusters[static_cast<size_t>(Index)].bDirty = true;
+    DirtyClusters.push_back(Index);
+  };
+
+  // A tile on a cluster's edge also decides the entrances facing it
+  const int32_t Index = ClusterOf(X, Y);
+  const FCluster &Cluster = Clusters[static_cast<size_t>(Index)];
+  Mark(Index);
+  if (X == Cluster.X0)
+    Mark(NeighbourOf(Index, SideNegX));
+  if (X == Cluster.X1 - 1)
+    Mark(NeighbourOf(Index, SidePosX));
+  if (Y == Cluster.Y0)
+    Mark(NeighbourOf(Index, SideNegY));
+  if (Y == Cluster.Y1 - 1)
+    Mark(NeighbourOf(Index, SidePosY));
+}
+
+int32_t FHierarchicalPath::RebuildDirty() {
+  const int32_t Rebuilt = static_cast<int32_t>(DirtyClusters.size());
+  if (Rebuilt == 0)
+    return 0;
+
+  for (int32_t Index : DirtyClusters)
+    BuildCluster(Index);
+  DirtyClusters.clear();
+  Renumber();
+  ClearGoal();
+  return Rebuilt;
+}
+
+void FHierarchicalPath::SetGoal(FTile NewGoal) {
+  if (HasGoal() && NewGoal == Goal)
+    return;
+  if (!IsBuilt() || !Grid->IsWalkable(NewGoal.X, NewGoal.Y)) {
+    ClearGoal();
+    return;
+  }
+
+  Goal = NewGoal;
+  GoalCluster = ClusterOf(Goal.X, Goal.Y);
+  if (++GoalStamp == 0) {
+    std::fill(Settled.begin(), Settled.end(), 0);
+    for (FCluster &Cluster : Clusters)
+      Cluster.FieldStamp = 0;
+    GoalStamp = 1;
+  }
+
+  // The goal joins the abstract graph through its own cluster. The search
+  // itself waits for Prepare.
+  const FCluster &Home = Clusters[static_cast<size_t>(GoalCluster)];
+  LoadOpen(Home);
+  Seeds.assign(1, {0, LocalIndex(Home, Goal.X, Goal.Y)});
+  FloodCluster(Seeds, LocalDist);
+
+  std::fill(GoalDist.begin(), GoalDist.end(), Unreachable);
+  for (std::vector<int32_t> &Bucket : Buckets)
+    Bucket.clear();
+  Frontier = 0;
+  NumQueued = 0;
+  GoalComponent = -1;
+  for (size_t Node = 0; Node < Home.Nodes.size(); Node++) {
+    const FTile Tile = Home.Nodes[Node];
+    const int32_t Dist =
+        LocalDist[static_cast<size_t>(LocalIndex(Home, Tile.X, Tile.Y))];
+    if (Dist == Unreachable)
+      continue;
+    const int32_t Id = Home.NodeBase + static_cast<int32_t>(Node);
+    GoalDist[static_cast<size_t>(Id)] = Dist;
+    GoalComponent = Component[static_cast<size_t>(Id)];
+    Buckets[static_cast<size_t>(Dist) % Buckets.size()].push_back(Id);
+    NumQueued++;
+  }
+}
+
+void FHierarchicalPath::Settle(const FCluster &Cluster) {
+  auto Relax = [&](int32_t Id, int32_t Dist) {
+    if (Dist < GoalDist[static_cast<size_t>(Id)]) {
+      GoalDist[static_cast<size_t>(Id)] = Dist;
+      Buckets[static_cast<size_t>(Dist) % Buckets.size()].push_back(Id);
+      NumQueued++;
+    }
+  };
+  auto IsPending = [&](size_t Node) {
+    const size_t Id = static_cast<size_t>(Cluster.NodeBase) + Node;
+    return Settled[Id] != GoalStamp && Component[Id] == GoalComponent;
+  };
+
+  // Once every reachable entrance here is final, run one tile further so
+  // that their partners are final too
+  size_t Pending = Cluster.Nodes.size();
+  int32_t Limit = -1;
+  while (NumQueued > 0) {
+    while (Pending > 0 && !IsPending(Pending - 1))
+      Pending--;
+    if (Pending == 0 && Limit < 0) {
+      for (size_t Node = 0; Node < Cluster.Nodes.size(); Node++) {
+        const int32_t Dist =
+            GoalDist[static_cast<size_t>(Cluster.NodeBase) + Node];
+        if (Dist != Unreachable)
+          Limit = std::max(Limit, Dist + 1);
+      }
+    }
+
+    std::vector<int32_t> *Bucket =
+        &Buckets[static_cast<size_t>(Frontier) % Buckets.size()];
+    while (Bucket->empty()) {
+      Frontier++;
+      Bucket = &Buckets[static_cast<size_t>(Frontier) % Buckets.size()];
+    }
+    if (Pending == 0 && Frontier > Limit)
+      break;
+
+    const int32_t Id = Bucket->back();
+    Bucket->pop_back();
+    NumQueued--;
+    // Entries left behind by a shorter route, or already expanded
+    if (GoalDist[static_cast<size_t>(Id)] != Frontier ||
+        Settled[static_cast<size_t>(Id)] == GoalStamp)
+      continue;
+    Settled[static_cast<size_t>(Id)] = GoalStamp;
+
+    const FCluster &Owner =
+        Clusters[static_cast<size_t>(NodeCluster[static_cast<size_t>(Id)])];
+    const int32_t Local = Id - Owner.NodeBase;
+    for (int32_t Edge = Owner.EdgeStart[static_cast<size_t>(Local)];
+         Edge < Owner.EdgeStart[static_cast<size_t>(Local) + 1]; Edge++) {
+      const std::pair<int32_t, int32_t> &To =
+          Owner.Edges[static_cast<size_t>(Edge)];
+      Relax(Owner.NodeBase + To.first, Frontier + To.second);
+    }
+    Relax(NodePartner[static_cast<size_t>(Id)], Frontier + 1);
+  }
+}
+
+void FHierarchicalPath::ClearGoal() {
+  Goal = FTile{-1, -1};
+  GoalCluster = -1;
+}
+
+void FHierarchicalPath::Prepare(FTile At) {
+  if (!HasGoal() || !Grid->IsInBounds(At.X, At.Y))
+    return;
+  FCluster &Cluster = Clusters[static_cast<size_t>(ClusterOf(At.X, At.Y))];
+  if (Cluster.FieldStamp == GoalStamp)
+    return;
+  Settle(Cluster);
+
+  // Seeds are the entrances and the goal itself, if it is in here
+  Seeds.clear();
+  Key.clear();
+  const bool bHome = &Cluster == &Clusters[static_cast<size_t>(GoalCluster)];
+  Key.push_back(bHome ? LocalIndex(Cluster, Goal.X, Goal.Y) : -1);
+  if (bHome)
+    Seeds.emplace_back(0, Key[0]);
+  for (size_t Node = 0; Node < Cluster.Nodes.size(); Node++) {
+    const int32_t Dist =
+        GoalDist[static_cast<size_t>(Cluster.NodeBase) + Node];
+    if (Dist == Unreachable)
+      continue;
+    const FTile Tile = Cluster.Nodes[Node];
+    Seeds.emplace_back(Dist, LocalIndex(Cluster, Tile.X, Tile.Y));
+  }
+
+  int32_t Base = 0;
+  if (!Seeds.empty()) {
+    Base = std::min_element(Seeds.begin(), Seeds.end())->first;
+    for (std::pair<int32_t, int32_t> &Seed : Seeds)
+      Seed.first -= Base;
+  }
+  for (size_t Node = 0; Node < Cluster.Nodes.size(); Node++) {
+    const int32_t Dist =
+        GoalDist[static_cast<size_t>(Cluster.NodeBase) + Node];
+    Key.push_back(Dist == Unreachable ? -1 : Dist - Base);
+  }
+
+  // Same shape as last time: only the offset moved
+  Cluster.FieldBase = Base;
+  Cluster.FieldStamp = GoalStamp;
+  if (!Cluster.Field.empty() && Key == Cluster.FieldKey)
+    return;
+
+  std::sort(Seeds.begin(), Seeds.end());
+  LoadOpen(Cluster);
+  FloodCluster(Seeds, Cluster.Field);
+  Cluster.FieldKey = Key;
+  FieldBuilds++;
+}
+
+int32_t FHierarchicalPath::TileDistance(const FCluster &Cluster, int32_t X,
+                                        int32_t Y) const {
+  const int32_t Dist =
+      Cluster.Field[static_cast<size_t>(LocalIndex(Cluster, X, Y))];
+  return Dist == Unreachable ? Unreachable : Cluster.FieldBase + Dist;
+}
+
+EDirection FHierarchicalPath::GetStep(FTile At) const {
+  if (!HasGoal() || !Grid->IsWalkable(At.X, At.Y))
+    return EDirection::None;
+  const FCluster &Cluster =
+      Clusters[static_cast<size_t>(ClusterOf(At.X, At.Y))];
+  if (Cluster.FieldStamp != GoalStamp)
+    return EDirection::None;
+
+  const int32_t Here = TileDistance(Cluster, At.X, At.Y);
+  EDirection Best = EDirection::None;
+  int32_t BestDist = Here;
+  for (EDirection Dir : Dirs) {
+    const int32_t NX = At.X + StepX(Dir);
+    const int32_t NY = At.Y + StepY(Dir);
+    int32_t Dist = Unreachable;
+    if (NX >= Cluster.X0 && NX < Cluster.X1 && NY >= Cluster.Y0 &&
+        NY < Cluster.Y1) {
+      if (Grid->IsWalkable(NX, NY))
+        Dist = TileDistance(Cluster, NX, NY);
+    } else {
+      // Leaving the cluster is only allowed through an entrance
+      const int32_t Side = Dir == EDirection::NegX   ? SideNegX
+                           : Dir == EDirection::PosX ? SidePosX
+                           : Dir == EDirection::NegY ? SideNegY
+                                                     : SidePosY;
+      for (int32_t Node = Cluster.SideStart[Side];
+           Node < Cluster.SideStart[Side + 1]; Node++) {
+        if (Cluster.Nodes[static_cast<size_t>(Node)] == At) {
+          Dist = GoalDist[static_cast<size_t>(
+              NodePartner[static_cast<size_t>(Cluster.NodeBase + Node)])];
+          break;
+        }
+      }
+    }
+    if (Dist < BestDist) {
+      BestDist = Dist;
+      Best = Dir;
+    }
+  }
+  return Best;
+}
+
+int32_t FHierarchicalPath::GetDistance(FTile At) const {
+  if (!HasGoal() || !Grid->IsWalkable(At.X, At.Y))
+    return Unreachable;
+  const FCluster &Cluster =
+      Clusters[static_cast<size_t>(ClusterOf(At.X, At.Y))];
+  if (Cluster.FieldStamp != GoalStamp)
+    return Unreachable;
+  return TileDistance(Cluster, At.X, At.Y);
+}
+
+} // namespace BangGuChaSim
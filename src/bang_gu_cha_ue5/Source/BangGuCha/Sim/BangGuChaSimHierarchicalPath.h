@@ -0,0 +1,156 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * Hierarchical pathfinding (HPA*) toward a single goal, for maps too large
+ * to flood whenever the player moves. The grid is cut into square
+ * clusters. Each run of open tiles along a cluster border gets one or two
+ * entrances, and every cluster stores the distances between its own
+ * entrances. The goal search is Dijkstra over entrances only, so its cost
+ * follows the cluster count rather than the tile count, and it only runs
+ * as far out as the clusters asked about.
+ *
+ * Movers need an answer per tile, so Prepare settles one cluster's
+ * entrances and floods the cluster from them. The flood is kept until the
+ * goal distances of those entrances change relative to each other, which
+ * for clusters far from the player is rare. GetStep only reads, so many
+ * threads may call it between Prepares; a tile whose cluster is not
+ * prepared for the current goal gets None.
+ *
+ * Walls may change after Build: MarkTileChanged queues the clusters that
+ * can see the tile and RebuildDirty redoes only their entrances and
+ * distances.
+ */
+class FHierarchicalPath {
+public:
+  static constexpr int32_t Unreachable = std::numeric_limits<int32_t>::max();
+
+  // The grid must outlive the pathfinder or the next Build
+  void Build(const FOccupancyGrid *InGrid, int32_t InClusterSize = 16);
+  void Reset();
+
+  void MarkTileChanged(int32_t X, int32_t Y);
+  // Returns the number of clusters rebuilt. Any rebuild drops the goal.
+  int32_t RebuildDirty();
+
+  void SetGoal(FTile Goal);
+  void ClearGoal();
+
+  // Floods At's cluster toward the current goal unless already done
+  void Prepare(FTile At);
+
+  // Next step of the route from At, or None when At is the goal, cannot
+  // reach it or its cluster was not prepared
+  EDirection GetStep(FTile At) const;
+
+  // Length of the route GetStep follows, or Unreachable
+  int32_t GetDistance(FTile At) const;
+
+  bool IsBuilt() const { return Grid != nullptr; }
+  bool HasGoal() const { return GoalCluster >= 0; }
+  int32_t GetClusterSize() const { return ClusterSize; }
+  size_t GetNumClusters() const { return Clusters.size(); }
+  size_t GetNumEntrances() const { return NodeCluster.size(); }
+  // Cluster floods since Build; a reused flood leaves it unchanged
+  uint64_t GetFieldBuilds() const { return FieldBuilds; }
+
+private:
+  // Cluster sides, in the order their entrances are stored
+  enum ESide : int32_t { SideNegX, SidePosX, SideNegY, SidePosY, NumSides };
+
+  struct FCluster {
+    int32_t X0 = 0;
+    int32_t Y0 = 0;
+    int32_t X1 = 0;
+    int32_t Y1 = 0;
+
+    // Entrance tiles grouped by side; side S holds
+    // [SideStart[S], SideStart[S + 1])
+    std::vector<FTile> Nodes;
+    int32_t SideStart[NumSides + 1] = {};
+    // Paths between entrances that stay inside the cluster, as (entrance,
+    // length) lists; entrance N's are [EdgeStart[N], EdgeStart[N + 1])
+    std::vector<int32_t> EdgeStart;
+    std::vector<std::pair<int32_t, int32_t>> Edges;
+    int32_t NodeBase = 0;
+    bool bDirty = false;
+
+    // Goal distance of each tile, relative to FieldBase. FieldKey is the
+    // shape of the entrance distances the flood started from.
+    std::vector<int32_t> Field;
+    std::vector<int32_t> FieldKey;
+    int32_t FieldBase = 0;
+    uint32_t FieldStamp = 0;
+  };
+
+  int32_t ClusterOf(int32_t X, int32_t Y) const {
+    return (Y / ClusterSize) * ClustersX + X / ClusterSize;
+  }
+  // Cluster-local tile index, one tile in from the closed ring
+  int32_t LocalIndex(const FCluster &Cluster, int32_t X, int32_t Y) const {
+    return (Y - Cluster.Y0 + 1) * Stride + (X - Cluster.X0 + 1);
+  }
+  int32_t NeighbourOf(int32_t Cluster, int32_t Side) const;
+
+  void BuildCluster(int32_t Index);
+  void ScanSide(const FCluster &Cluster, int32_t Side,
+                std::vector<FTile> &Out) const;
+  void LoadOpen(const FCluster &Cluster);
+  void FloodCluster(const std::vector<std::pair<int32_t, int32_t>> &Sorted,
+                    std::vector<int32_t> &Out);
+  void Renumber();
+  // Runs the goal search until every entrance of Cluster is final
+  void Settle(const FCluster &Cluster);
+
+  int32_t TileDistance(const FCluster &Cluster, int32_t X, int32_t Y) const;
+
+  const FOccupancyGrid *Grid = nullptr;
+  int32_t ClusterSize = 16;
+  int32_t Stride = 18;
+  int32_t ClustersX = 0;
+  int32_t ClustersY = 0;
+  std::vector<FCluster> Clusters;
+  std::vector<int32_t> DirtyClusters;
+  uint64_t FieldBuilds = 0;
+
+  // Per entrance, numbered cluster by cluster
+  std::vector<int32_t> NodeCluster;
+  std::vector<int32_t> NodePartner;
+  std::vector<int32_t> GoalDist;
+  // GoalStamp once an entrance's GoalDist is final
+  std::vector<uint32_t> Settled;
+  // Entrances with the same component reach each other
+  std::vector<int32_t> Component;
+
+  FTile Goal = {-1, -1};
+  int32_t GoalCluster = -1;
+  int32_t GoalComponent = -1;
+  uint32_t GoalStamp = 0;
+
+  // Pending goal search as a ring of buckets by distance, Frontier being
+  // the smallest distance still queued. No edge or goal seed spans the
+  // whole ring.
+  std::vector<std::vector<int32_t>> Buckets;
+  int32_t Frontier = 0;
+  size_t NumQueued = 0;
+
+  // Scratch for floods and searches. Open is the cluster being flooded,
+  // walkable tiles as 1, with a closed ring around it.
+  std::vector<uint8_t> Open;
+  std::vector<std::pair<int32_t, int32_t>> Seeds;
+  std::vector<int32_t> Queue;
+  std::vector<int32_t> LocalDist;
+  std::vector<int32_t> Key;
+};
+
+} // namespace BangGuChaSim
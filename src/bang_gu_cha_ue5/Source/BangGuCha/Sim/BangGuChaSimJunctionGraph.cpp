@@ -0,0 +1,346 @@
+#include "BangGuChaSimJunctionGraph.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace BangGuChaSim {
+
+namespace {
+
+constexpr EDirection Dirs[4] = {EDirection::PosX, EDirection::NegX,
+                                EDirection::PosY, EDirection::NegY};
+
+size_t SlotOf(int32_t Node, EDirection Dir) {
+  return static_cast<size_t>(Node) * 4 + static_cast<uint8_t>(Dir) - 1;
+}
+
+int32_t AddDistance(int32_t Dist, int32_t Length) {
+  return Dist == FJunctionGraph::Unreachable ? Dist : Dist + Length;
+}
+
+} // namespace
+
+void FJunctionGraph::Build(const FOccupancyGrid &Grid) {
+  Reset();
+  if (!Grid.IsValid())
+    return;
+
+  Width = Grid.GetWidth();
+  Height = Grid.GetHeight();
+  const size_t NumTiles = Grid.GetNumTiles();
+  TileNode.assign(NumTiles, -1);
+  TileEdge.assign(NumTiles, -1);
+  TileOffset.assign(NumTiles, 0);
+  TileToFrom.assign(NumTiles, EDirection::None);
+  TileToTo.assign(NumTiles, EDirection::None);
+
+  for (int32_t Y = 0; Y < Height; Y++) {
+    for (int32_t X = 0; X < Width; X++) {
+      if (!Grid.IsWalkable(X, Y))
+        continue;
+      int32_t Open = 0;
+      for (EDirection Dir : Dirs)
+        Open += Grid.IsWalkable(X + StepX(Dir), Y + StepY(Dir));
+      if (Open != 2)
+        AddNode(X, Y);
+    }
+  }
+
+  auto TraceFrom = [&](int32_t Node) {
+    const FTile At = NodeTiles[static_cast<size_t>(Node)];
+    for (EDirection Dir : Dirs) {
+      if (NodeEdges[SlotOf(Node, Dir)] < 0 &&
+          Grid.IsWalkable(At.X + StepX(Dir), At.Y + StepY(Dir)))
+        TraceEdge(Grid, Node, Dir);
+    }
+  };
+  const int32_t NumJunctions = static_cast<int32_t>(NodeTiles.size());
+  for (int32_t Node = 0; Node < NumJunctions; Node++)
+    TraceFrom(Node);
+
+  // Corridors that loop back on themselves without a junction get one node
+  // of their own
+  for (int32_t Y = 0; Y < Height; Y++) {
+    for (int32_t X = 0; X < Width; X++) {
+      const size_t Index = IndexOf(X, Y);
+      if (Grid.IsWalkable(X, Y) && TileNode[Index] < 0 && TileEdge[Index] < 0)
+        TraceFrom(AddNode(X, Y));
+    }
+  }
+}
+
+void FJunctionGraph::Reset() {
+  Width = Height = 0;
+  TileNode.clear();
+  TileEdge.clear();
+  TileOffset.clear();
+  TileToFrom.clear();
+  TileToTo.clear();
+  NodeTiles.clear();
+  NodeEdges.clear();
+  Edges.clear();
+  Trees.clear();
+  UseClock = TreeBuilds = 0;
+  ClearGoal();
+}
+
+int32_t FJunctionGraph::AddNode(int32_t X, int32_t Y) {
+  const int32_t Node = static_cast<int32_t>(NodeTiles.size());
+  TileNode[IndexOf(X, Y)] = Node;
+  NodeTiles.push_back(FTile{X, Y});
+  NodeEdges.insert(NodeEdges.end(), 4, -1);
+  return Node;
+}
+
+void FJunctionGraph::TraceEdge(const FOccupancyGrid &Grid, int32_t Node,
+                               EDirection Dir) {
+  const int32_t Id = static_cast<int32_t>(Edges.size());
+  FEdge Edge;
+  Edge.From = Node;
+  Edge.FromDir = Dir;
+
+  // Corridor tiles have exactly two open neighbours, one of them behind
+  FTile At = NodeTiles[static_cast<size_t>(Node)];
+  EDirection Heading = Dir;
+  for (;;) {
+    At.X += StepX(Heading);
+    At.Y += StepY(Heading);
+    Edge.Length++;
+
+    const size_t Index = IndexOf(At.X, At.Y);
+    if (TileNode[Index] >= 0) {
+      Edge.To = TileNode[Index];
+      break;
+    }
+
+    const EDirection Back = Opposite(Heading);
+    TileEdge[Index] = Id;
+    TileOffset[Index] = Edge.Length;
+    TileToFrom[Index] = Back;
+    for (EDirection Next : Dirs) {
+      if (Next != Back && Grid.IsWalkable(At.X + StepX(Next),
+                                          At.Y + StepY(Next))) {
+        Heading = Next;
+        break;
+      }
+    }
+    TileToTo[Index] = Heading;
+  }
+
+  Edge.ToDir = Opposite(Heading);
+  Edges.push_back(Edge);
+  NodeEdges[SlotOf(Edge.From, Edge.FromDir)] = Id;
+  NodeEdges[SlotOf(Edge.To, Edge.ToDir)] = Id;
+}
+
+bool FJunctionGraph::Locate(FTile At, FPlace &Place) const {
+  if (static_cast<uint32_t>(At.X) >= static_cast<uint32_t>(Width) ||
+      static_cast<uint32_t>(At.Y) >= static_cast<uint32_t>(Height))
+    return false;
+
+  const size_t Index = IndexOf(At.X, At.Y);
+  Place = FPlace();
+  if (TileNode[Index] >= 0) {
+    Place.Node = TileNode[Index];
+    return true;
+  }
+  if (TileEdge[Index] >= 0) {
+    Place.Edge = TileEdge[Index];
+    Place.Offset = TileOffset[Index];
+    return true;
+  }
+  return false;
+}
+
+FJunctionGraph::FTree &FJunctionGraph::GetTree(int32_t Root) {
+  UseClock++;
+  for (FTree &Tree : Trees) {
+    if (Tree.Root == Root) {
+      Tree.LastUse = UseClock;
+      return Tree;
+    }
+  }
+
+  // Evict the least recently used tree and reuse its storage
+  FTree *Tree = nullptr;
+  if (Trees.size() < MaxCachedTrees) {
+    Trees.emplace_back();
+    Tree = &Trees.back();
+  } else {
+    Tree = &*std::min_element(Trees.begin(), Trees.end(),
+                              [](const FTree &A, const FTree &B) {
+                                return A.LastUse < B.LastUse;
+                              });
+  }
+  Tree->Root = Root;
+  Tree->LastUse = UseClock;
+  TreeBuilds++;
+
+  // Dijkstra over corridor lengths
+  std::vector<int32_t> &Dist = Tree->Dist;
+  Dist.assign(NodeTiles.size(), Unreachable);
+  Dist[static_cast<size_t>(Root)] = 0;
+  const auto Greater = std::greater<std::pair<int32_t, int32_t>>();
+  Heap.clear();
+  Heap.emplace_back(0, Root);
+  while (!Heap.empty()) {
+    std::pop_heap(Heap.begin(), Heap.end(), Greater);
+    const auto [NodeDist, Node] = Heap.back();
+    Heap.pop_back();
+    if (NodeDist > Dist[static_cast<size_t>(Node)])
+      continue;
+
+    for (EDirection Dir : Dirs) {
+      const int32_t Id = NodeEdges[SlotOf(Node, Dir)];
+      if (Id < 0)
+        continue;
+      const FEdge &Edge = Edges[static_cast<size_t>(Id)];
+      const int32_t Other =
+          Edge.From == Node && Edge.FromDir == Dir ? Edge.To : Edge.From;
+      const int32_t OtherDist = NodeDist + Edge.Length;
+      if (OtherDist < Dist[static_cast<size_t>(Other)]) {
+        Dist[static_cast<size_t>(Other)] = OtherDist;
+        Heap.emplace_back(OtherDist, Other);
+        std::push_heap(Heap.begin(), Heap.end(), Greater);
+      }
+    }
+  }
+  return *Tree;
+}
+
+void FJunctionGraph::SetGoal(FTile Goal) {
+  if (Goal == GoalTile && HasGoal())
+    return;
+
+  FPlace Place;
+  if (!Locate(Goal, Place)) {
+    ClearGoal();
+    return;
+  }
+  GoalTile = Goal;
+  GoalPlace = Place;
+
+  // Tree storage survives a grow of Trees, and the second fetch never
+  // evicts the first, which is the most recently used
+  if (Place.Node >= 0) {
+    GoalDistA = GoalDistB = GetTree(Place.Node).Dist.data();
+    GoalOffsetA = GoalOffsetB = 0;
+    return;
+  }
+  const FEdge &Edge = Edges[static_cast<size_t>(Place.Edge)];
+  GoalDistA = GetTree(Edge.From).Dist.data();
+  GoalDistB = GetTree(Edge.To).Dist.data();
+  GoalOffsetA = Place.Offset;
+  GoalOffsetB = Edge.Length - Place.Offset;
+}
+
+void FJunctionGraph::ClearGoal() {
+  GoalTile = FTile{-1, -1};
+  GoalPlace = FPlace();
+  GoalDistA = GoalDistB = nullptr;
+  GoalOffsetA = GoalOffsetB = 0;
+}
+
+void FJunctionGraph::SetMaxCachedTrees(size_t Max) {
+  MaxCachedTrees = std::max<size_t>(Max, 2);
+  if (Trees.size() <= MaxCachedTrees)
+    return;
+
+  const FTile Goal = GoalTile;
+  const bool bHadGoal = HasGoal();
+  Trees.clear();
+  ClearGoal();
+  if (bHadGoal)
+    SetGoal(Goal);
+}
+
+int32_t FJunctionGraph::DistanceFrom(int32_t Node) const {
+  const size_t Index = static_cast<size_t>(Node);
+  return std::min(AddDistance(GoalDistA[Index], GoalOffsetA),
+                  AddDistance(GoalDistB[Index], GoalOffsetB));
+}
+
+void FJunctionGraph::GetCorridorRoutes(const FPlace &Place, int32_t &ViaFrom,
+                                       int32_t &ViaTo) const {
+  const FEdge &Edge = Edges[static_cast<size_t>(Place.Edge)];
+  ViaFrom = AddDistance(DistanceFrom(Edge.From), Place.Offset);
+  ViaTo = AddDistance(DistanceFrom(Edge.To), Edge.Length - Place.Offset);
+}
+
+EDirection FJunctionGraph::NodeStep(int32_t Node) const {
+  EDirection Best = EDirection::None;
+  int32_t BestDist = Unreachable;
+  for (EDirection Dir : Dirs) {
+    const int32_t Id = NodeEdges[SlotOf(Node, Dir)];
+    if (Id < 0)
+      continue;
+    const FEdge &Edge = Edges[static_cast<size_t>(Id)];
+    const bool bFromSide = Edge.From == Node && Edge.FromDir == Dir;
+
+    int32_t Dist;
+    if (Id == GoalPlace.Edge) {
+      Dist = bFromSide ? GoalPlace.Offset : Edge.Length - GoalPlace.Offset;
+    } else {
+      Dist = AddDistance(DistanceFrom(bFromSide ? Edge.To : Edge.From),
+                         Edge.Length);
+    }
+    if (Dist < BestDist) {
+      BestDist = Dist;
+      Best = Dir;
+    }
+  }
+  return Best;
+}
+
+EDirection FJunctionGraph::GetStep(FTile At, EDirection Current) const {
+  FPlace Place;
+  if (!HasGoal() || !Locate(At, Place))
+    return EDirection::None;
+
+  if (Place.Node >= 0)
+    return Place.Node == GoalPlace.Node ? EDirection::None
+                                        : NodeStep(Place.Node);
+
+  const size_t Index = IndexOf(At.X, At.Y);
+  const EDirection ToFrom = TileToFrom[Index];
+  const EDirection ToTo = TileToTo[Index];
+  int32_t ViaFrom, ViaTo;
+  GetCorridorRoutes(Place, ViaFrom, ViaTo);
+
+  // A goal in the same corridor may still be closer around the other way
+  if (Place.Edge == GoalPlace.Edge) {
+    const int32_t Direct = std::abs(Place.Offset - GoalPlace.Offset);
+    if (Direct == 0)
+      return EDirection::None;
+    if (Direct <= ViaFrom && Direct <= ViaTo)
+      return Place.Offset > GoalPlace.Offset ? ToFrom : ToTo;
+    return ViaFrom <= ViaTo ? ToFrom : ToTo;
+  }
+  if (ViaFrom == Unreachable && ViaTo == Unreachable)
+    return EDirection::None;
+
+  // Keep going along the corridor; the choice was made at its entrance
+  if (Current == Opposite(ToFrom))
+    return ToTo;
+  if (Current == Opposite(ToTo))
+    return ToFrom;
+  return ViaFrom <= ViaTo ? ToFrom : ToTo;
+}
+
+int32_t FJunctionGraph::GetDistance(FTile At) const {
+  FPlace Place;
+  if (!HasGoal() || !Locate(At, Place))
+    return Unreachable;
+  if (Place.Node >= 0)
+    return DistanceFrom(Place.Node);
+
+  int32_t ViaFrom, ViaTo;
+  GetCorridorRoutes(Place, ViaFrom, ViaTo);
+  const int32_t Around = std::min(ViaFrom, ViaTo);
+  if (Place.Edge == GoalPlace.Edge)
+    return std::min(std::abs(Place.Offset - GoalPlace.Offset), Around);
+  return Around;
+}
+
+} // namespace BangGuChaSim
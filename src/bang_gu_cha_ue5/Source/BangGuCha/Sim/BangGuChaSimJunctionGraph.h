@@ -0,0 +1,124 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * The walkable tiles of a map compressed into junctions and corridors.
+ * Every tile without exactly two open neighbours (junctions and dead ends)
+ * is a node, and each corridor between two nodes is one edge weighted by
+ * its length in tiles.
+ *
+ * Shortest-path trees are built per node and kept in a small LRU cache
+ * that only Build clears, so a goal moving along a corridor keeps reusing
+ * the trees of that corridor's two ends. SetGoal picks the trees for the
+ * goal; GetStep only reads, so many threads may call it between SetGoals.
+ */
+class FJunctionGraph {
+public:
+  static constexpr int32_t Unreachable = std::numeric_limits<int32_t>::max();
+
+  // Rebuilds the graph and drops every cached tree
+  void Build(const FOccupancyGrid &Grid);
+  void Reset();
+
+  void SetGoal(FTile Goal);
+  void ClearGoal();
+
+  // Direction toward the goal for a mover standing on At after moving
+  // Current. In a corridor the mover keeps going unless the goal is in the
+  // same corridor; only nodes compare routes. None when the goal is unset,
+  // unreachable or At itself.
+  EDirection GetStep(FTile At, EDirection Current) const;
+
+  // Tiles from At to the goal, or Unreachable
+  int32_t GetDistance(FTile At) const;
+
+  // At least two trees are always kept, one per end of the goal's corridor
+  void SetMaxCachedTrees(size_t Max);
+
+  bool IsBuilt() const { return Width > 0; }
+  bool HasGoal() const { return GoalDistA != nullptr; }
+  size_t GetNumNodes() const { return NodeTiles.size(); }
+  size_t GetNumEdges() const { return Edges.size(); }
+  // Trees computed since Build; a cache hit leaves it unchanged
+  uint64_t GetTreeBuilds() const { return TreeBuilds; }
+
+private:
+  struct FEdge {
+    int32_t From = -1;
+    int32_t To = -1;
+    int32_t Length = 0;
+    // Leaves From (To) into the corridor
+    EDirection FromDir = EDirection::None;
+    EDirection ToDir = EDirection::None;
+  };
+
+  // A tile as a node, or as an edge and its distance from the edge's From
+  struct FPlace {
+    int32_t Node = -1;
+    int32_t Edge = -1;
+    int32_t Offset = 0;
+  };
+
+  struct FTree {
+    int32_t Root = -1;
+    uint64_t LastUse = 0;
+    std::vector<int32_t> Dist;
+  };
+
+  size_t IndexOf(int32_t X, int32_t Y) const {
+    return static_cast<size_t>(Y) * Width + X;
+  }
+
+  int32_t AddNode(int32_t X, int32_t Y);
+  void TraceEdge(const FOccupancyGrid &Grid, int32_t Node, EDirection Dir);
+  bool Locate(FTile At, FPlace &Place) const;
+  FTree &GetTree(int32_t Root);
+
+  int32_t DistanceFrom(int32_t Node) const;
+  void GetCorridorRoutes(const FPlace &Place, int32_t &ViaFrom,
+                         int32_t &ViaTo) const;
+  EDirection NodeStep(int32_t Node) const;
+
+  int32_t Width = 0;
+  int32_t Height = 0;
+
+  // Per tile: node id, or -1 for walls and corridors
+  std::vector<int32_t> TileNode;
+  // Per corridor tile: edge id (-1 elsewhere), distance from the edge's
+  // From node and the directions toward its From and To ends
+  std::vector<int32_t> TileEdge;
+  std::vector<int32_t> TileOffset;
+  std::vector<EDirection> TileToFrom;
+  std::vector<EDirection> TileToTo;
+
+  std::vector<FTile> NodeTiles;
+  // Four slots per node, indexed by direction - 1; -1 where walled off
+  std::vector<int32_t> NodeEdges;
+  std::vector<FEdge> Edges;
+
+  std::vector<FTree> Trees;
+  size_t MaxCachedTrees = 16;
+  uint64_t UseClock = 0;
+  uint64_t TreeBuilds = 0;
+  std::vector<std::pair<int32_t, int32_t>> Heap;
+
+  // Goal distance of node n is min(DistA[n] + OffsetA, DistB[n] + OffsetB)
+  FTile GoalTile = {-1, -1};
+  FPlace GoalPlace;
+  const int32_t *GoalDistA = nullptr;
+  const int32_t *GoalDistB = nullptr;
+  int32_t GoalOffsetA = 0;
+  int32_t GoalOffsetB = 0;
+};
+
+} // namespace BangGuChaSim
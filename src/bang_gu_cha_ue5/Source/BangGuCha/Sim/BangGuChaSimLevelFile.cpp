@@ -0,0 +1,173 @@
+#include "BangGuChaSimLevelFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace BangGuChaSim {
+
+namespace {
+
+template <typename T> T ReadAt(const uint8_t *Data, size_t Offset) {
+  T Value;
+  std::memcpy(&Value, Data + Offset, sizeof(T));
+  return Value;
+}
+
+template <typename T> void WriteAt(uint8_t *Data, size_t Offset, T Value) {
+  std::memcpy(Data + Offset, &Value, sizeof(T));
+}
+
+size_t NumWordsFor(int32_t Width, int32_t Height) {
+  return (static_cast<size_t>(Width) * static_cast<size_t>(Height) + 63) / 64;
+}
+
+constexpr size_t TileBytes = 2 * sizeof(int32_t);
+
+bool AllOnMap(const uint8_t *Tiles, size_t Count, int32_t Width,
+              int32_t Height) {
+  for (size_t Index = 0; Index < Count; Index++) {
+    const int32_t X = ReadAt<int32_t>(Tiles, Index * TileBytes);
+    const int32_t Y = ReadAt<int32_t>(Tiles, Index * TileBytes + 4);
+    if (X < 0 || X >= Width || Y < 0 || Y >= Height)
+      return false;
+  }
+  return true;
+}
+
+void CopyTiles(const uint8_t *Tiles, size_t Count, std::vector<FTile> &Out) {
+  Out.resize(Count);
+  for (size_t Index = 0; Index < Count; Index++) {
+    Out[Index].X = ReadAt<int32_t>(Tiles, Index * TileBytes);
+    Out[Index].Y = ReadAt<int32_t>(Tiles, Index * TileBytes + 4);
+  }
+}
+
+} // namespace
+
+bool FLevelView::Parse(const void *Data, size_t Size) {
+  *this = FLevelView();
+  const uint8_t *Bytes = static_cast<const uint8_t *>(Data);
+  if (!Bytes || Size < LevelFileHeaderSize ||
+      ReadAt<uint32_t>(Bytes, 0) != LevelFileMagic ||
+      ReadAt<uint32_t>(Bytes, 4) != LevelFileVersion)
+    return false;
+
+  FLevelFileHeader Parsed;
+  Parsed.Width = ReadAt<int32_t>(Bytes, 8);
+  Parsed.Height = ReadAt<int32_t>(Bytes, 12);
+  Parsed.Seed = ReadAt<uint64_t>(Bytes, 16);
+  Parsed.CacheKey = ReadAt<uint64_t>(Bytes, 24);
+  Parsed.PlayerStart.X = ReadAt<int32_t>(Bytes, 32);
+  Parsed.PlayerStart.Y = ReadAt<int32_t>(Bytes, 36);
+  Parsed.NumFlags = ReadAt<uint32_t>(Bytes, 40);
+  Parsed.NumEnemySpawns = ReadAt<uint32_t>(Bytes, 44);
+  if (Parsed.Width <= 0 || Parsed.Height <= 0)
+    return false;
+
+  // Sizes are bounded by the 32-bit fields, so none of this overflows
+  const size_t NumWords = NumWordsFor(Parsed.Width, Parsed.Height);
+  const size_t NumTiles =
+      static_cast<size_t>(Parsed.NumFlags) + Parsed.NumEnemySpawns;
+  if (Size != LevelFileHeaderSize + NumWords * sizeof(uint64_t) +
+                  NumTiles * TileBytes)
+    return false;
+
+  Header = Parsed;
+  Walls = Bytes + LevelFileHeaderSize;
+  Tiles = Walls + NumWords * sizeof(uint64_t);
+  NumWallWords = NumWords;
+  return true;
+}
+
+uint64_t MakeLevelCacheKey(const FMapParams &Params, uint64_t Seed,
+                           int32_t ChunkSize) {
+  auto FloatBits = [](float Value) {
+    uint32_t Bits;
+    std::memcpy(&Bits, &Value, sizeof(Bits));
+    return Bits;
+  };
+
+  const uint64_t Fields[] = {LevelFileVersion,
+                             LevelGeneratorVersion,
+                             Seed,
+                             static_cast<uint32_t>(Params.Width),
+                             static_cast<uint32_t>(Params.Height),
+                             FloatBits(Params.WallChance),
+                             FloatBits(Params.ItemChance),
+                             static_cast<uint32_t>(Params.SafeZoneSize),
+                             static_cast<uint32_t>(Params.ExtraEnemies),
+                             static_cast<uint8_t>(Params.Style),
+                             FloatBits(Params.BraidChance),
+                             Params.bEnsureReachable ? 1u : 0u,
+                             static_cast<uint32_t>(ChunkSize)};
+  uint64_t Key = 0;
+  for (uint64_t Field : Fields)
+    Key = FRandom::MixSeed(Key ^ Field, Field);
+  // 0 marks hand-made levels
+  return Key != 0 ? Key : 1;
+}
+
+std::string GetLevelCacheFileName(uint64_t CacheKey) {
+  char Name[32];
+  std::snprintf(Name, sizeof(Name), "%016llx.bgcl",
+                static_cast<unsigned long long>(CacheKey));
+  return Name;
+}
+
+void WriteLevel(const FMapLayout &Layout, uint64_t Seed, uint64_t CacheKey,
+                std::vector<uint8_t> &Out) {
+  const std::vector<uint64_t> &Words = Layout.Walls.GetWords();
+  const size_t NumTiles = Layout.Flags.size() + Layout.EnemySpawns.size();
+  Out.assign(LevelFileHeaderSize + Words.size() * sizeof(uint64_t) +
+                 NumTiles * TileBytes,
+             0);
+
+  uint8_t *Bytes = Out.data();
+  WriteAt<uint32_t>(Bytes, 0, LevelFileMagic);
+  WriteAt<uint32_t>(Bytes, 4, LevelFileVersion);
+  WriteAt<int32_t>(Bytes, 8, Layout.Walls.GetWidth());
+  WriteAt<int32_t>(Bytes, 12, Layout.Walls.GetHeight());
+  WriteAt<uint64_t>(Bytes, 16, Seed);
+  WriteAt<uint64_t>(Bytes, 24, CacheKey);
+  WriteAt<int32_t>(Bytes, 32, Layout.PlayerStart.X);
+  WriteAt<int32_t>(Bytes, 36, Layout.PlayerStart.Y);
+  WriteAt<uint32_t>(Bytes, 40, static_cast<uint32_t>(Layout.Flags.size()));
+  WriteAt<uint32_t>(Bytes, 44,
+                    static_cast<uint32_t>(Layout.EnemySpawns.size()));
+
+  size_t Offset = LevelFileHeaderSize;
+  const size_t WallBytes = Words.size() * sizeof(uint64_t);
+  if (WallBytes != 0)
+    std::memcpy(Bytes + Offset, Words.data(), WallBytes);
+  Offset += WallBytes;
+  for (const std::vector<FTile> *Tiles :
+       {&Layout.Flags, &Layout.EnemySpawns}) {
+    for (const FTile &Tile : *Tiles) {
+      WriteAt<int32_t>(Bytes, Offset, Tile.X);
+      WriteAt<int32_t>(Bytes, Offset + 4, Tile.Y);
+      Offset += TileBytes;
+    }
+  }
+}
+
+bool LoadLevel(const FLevelView &View, FMapLayout &Out) {
+  const FLevelFileHeader &Header = View.GetHeader();
+  if (!View.GetWallWords())
+    return false;
+  const uint8_t *Flags = View.GetTiles();
+  const uint8_t *Spawns = Flags + Header.NumFlags * TileBytes;
+  const FTile Start = Header.PlayerStart;
+  if (Start.X < 0 || Start.X >= Header.Width || Start.Y < 0 ||
+      Start.Y >= Header.Height ||
+      !AllOnMap(Flags, Header.NumFlags, Header.Width, Header.Height) ||
+      !AllOnMap(Spawns, Header.NumEnemySpawns, Header.Width, Header.Height))
+    return false;
+
+  Out.Walls.InitFromWords(Header.Width, Header.Height, View.GetWallWords());
+  CopyTiles(Flags, Header.NumFlags, Out.Flags);
+  CopyTiles(Spawns, Header.NumEnemySpawns, Out.EnemySpawns);
+  Out.PlayerStart = Start;
+  return true;
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BangGuChaSimMapGen.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * Binary level file, version 1. Little-endian and laid out so that a
+ * memory-mapped file can be read in place:
+ *
+ *   0   magic "BGCL", version (u32)
+ *   8   width, height (i32)
+ *   16  seed (u64)
+ *   24  cache key (u64), 0 for hand-made levels
+ *   32  player start x, y (i32)
+ *   40  flag count, enemy spawn count (u32)
+ *   48  wall bits, FOccupancyGrid::GetWords order (u64 each)
+ *       flags, then enemy spawns (x, y as i32 each)
+ *
+ * Every section starts on an 8-byte boundary. Only little-endian hosts
+ * are supported, which covers every platform the game ships on.
+ */
+constexpr uint32_t LevelFileMagic = 0x4c434742; // "BGCL"
+constexpr uint32_t LevelFileVersion = 1;
+constexpr size_t LevelFileHeaderSize = 48;
+
+// Bump whenever GenerateLayout or the chunked generator make a different
+// map from the same params and seed, so stale cache entries miss
+constexpr uint32_t LevelGeneratorVersion = 1;
+
+struct FLevelFileHeader {
+  int32_t Width = 0;
+  int32_t Height = 0;
+  uint64_t Seed = 0;
+  uint64_t CacheKey = 0;
+  FTile PlayerStart = {1, 1};
+  uint32_t NumFlags = 0;
+  uint32_t NumEnemySpawns = 0;
+};
+
+/**
+ * Validated, non-owning view of a level file in memory. Parse only checks
+ * the header and section sizes, so it costs the same for any map size;
+ * the bytes must stay mapped while the view is used.
+ */
+class FLevelView {
+public:
+  // False for anything that is not a complete version 1 level
+  bool Parse(const void *Data, size_t Size);
+
+  const FLevelFileHeader &GetHeader() const { return Header; }
+  const uint8_t *GetWallWords() const { return Walls; }
+  size_t GetNumWallWords() const { return NumWallWords; }
+  // Flags, then enemy spawns
+  const uint8_t *GetTiles() const { return Tiles; }
+
+private:
+  FLevelFileHeader Header;
+  const uint8_t *Walls = nullptr;
+  const uint8_t *Tiles = nullptr;
+  size_t NumWallWords = 0;
+};
+
+// Identifies a generated level: the same key means the same map
+uint64_t MakeLevelCacheKey(const FMapParams &Params, uint64_t Seed,
+                           int32_t ChunkSize = 0);
+
+// File name for a key inside a cache directory, e.g. "a1b2...c3d4.bgcl"
+std::string GetLevelCacheFileName(uint64_t CacheKey);
+
+void WriteLevel(const FMapLayout &Layout, uint64_t Seed, uint64_t CacheKey,
+                std::vector<uint8_t> &Out);
+
+/**
+ * Fills Out from a parsed view with one bulk copy of the walls. Returns
+ * false, leaving Out untouched, when the player, a flag or a spawn is off
+ * the map.
+ */
+bool LoadLevel(const FLevelView &View, FMapLayout &Out);
+
+} // namespace BangGuChaSim
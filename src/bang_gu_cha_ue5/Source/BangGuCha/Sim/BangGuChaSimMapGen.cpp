@@ -0,0 +1,217 @@
+#include "BangGuChaSimMapGen.h"
+#include "BangGuChaSimMaze.h"
+#include "BangGuChaSimReachability.h"
+
+#include <algorithm>
+
+namespace BangGuChaSim {
+
+namespace {
+
+bool IsBorder(const FMapParams &Params, int32_t X, int32_t Y) {
+  return X == 0 || X == Params.Width - 1 || Y == 0 || Y == Params.Height - 1;
+}
+
+bool IsInSafeZone(const FMapParams &Params, int32_t X, int32_t Y) {
+  return X < Params.SafeZoneSize && Y < Params.SafeZoneSize;
+}
+
+// Extra enemies on random open tiles, bounded so a nearly solid map cannot
+// stall here
+void PlaceExtraEnemies(const FMapParams &Params, FRandom &Rng,
+                       FMapLayout &Out) {
+  const int64_t MaxAttempts = static_cast<int64_t>(Params.ExtraEnemies) * 16;
+  int32_t Placed = 0;
+  for (int64_t Attempt = 0;
+       Attempt < MaxAttempts && Placed < Params.ExtraEnemies; Attempt++) {
+    const int32_t X = Rng.RandRange(1, Params.Width - 2);
+    const int32_t Y = Rng.RandRange(1, Params.Height - 2);
+    if (!Out.Walls.IsWalkable(X, Y) || IsInSafeZone(Params, X, Y))
+      continue;
+    Out.EnemySpawns.push_back(FTile{X, Y});
+    Placed++;
+  }
+}
+
+void ScatterWallsAndFlags(const FMapParams &Params, FRandom &Rng,
+                          FMapLayout &Out) {
+  // x-major order matches GenerateMap so a seed draws the same sequence
+  for (int32_t X = 0; X < Params.Width; X++) {
+    for (int32_t Y = 0; Y < Params.Height; Y++) {
+      // Border Walls
+      if (IsBorder(Params, X, Y)) {
+        Out.Walls.SetBlocked(X, Y);
+        continue;
+      }
+
+      // Safe Zone (Top-Left for Player)
+      if (IsInSafeZone(Params, X, Y))
+        continue;
+
+      // Random Inner Walls
+      if (Rng.NextFloat() < Params.WallChance) {
+        Out.Walls.SetBlocked(X, Y);
+        continue;
+      }
+
+      // Random Items
+      if (Rng.NextFloat() < Params.ItemChance) {
+        Out.Flags.push_back(FTile{X, Y});
+      }
+    }
+  }
+}
+
+void CarveMazeWithFlags(const FMapParams &Params, FRandom &Rng,
+                        FMapLayout &Out) {
+  CarveMaze(Out.Walls, Rng,
+            Params.Style == EMapStyle::Braided ? Params.BraidChance : 0.f);
+
+  // Row-major like the bitmap; mazes have no legacy draw order to keep
+  for (int32_t Y = 1; Y < Params.Height - 1; Y++) {
+    for (int32_t X = 1; X < Params.Width - 1; X++) {
+      if (IsInSafeZone(Params, X, Y)) {
+        Out.Walls.SetBlocked(X, Y, false);
+      } else if (Out.Walls.IsWalkable(X, Y) &&
+                 Rng.NextFloat() < Params.ItemChance) {
+        Out.Flags.push_back(FTile{X, Y});
+      }
+    }
+  }
+}
+
+} // namespace
+
+void GenerateLayout(const FMapParams &Params, FRandom &Rng, FMapLayout &Out) {
+  const int32_t Width = Params.Width;
+  const int32_t Height = Params.Height;
+
+  Out.Walls.Init(Width, Height);
+  Out.Flags.clear();
+  Out.EnemySpawns.clear();
+  Out.PlayerStart = FTile{1, 1};
+
+  if (Params.Style == EMapStyle::Scatter)
+    ScatterWallsAndFlags(Params, Rng, Out);
+  else
+    CarveMazeWithFlags(Params, Rng, Out);
+
+  // Enemies at opposite corners
+  Out.EnemySpawns.push_back(FTile{Width - 2, Height - 2});
+  Out.EnemySpawns.push_back(FTile{Width - 2, 1});
+
+  PlaceExtraEnemies(Params, Rng, Out);
+
+  if (Params.bEnsureReachable) {
+    FReachability Reach;
+    EnsureReachable(Out, Reach);
+  }
+}
+
+void PrepareChunkedLayout(const FMapParams &Params, int32_t ChunkSize,
+                          FChunkedMapLayout &Out) {
+  Out.ChunkSize = std::max(ChunkSize, 1);
+  Out.ChunksX = (Params.Width + Out.ChunkSize - 1) / Out.ChunkSize;
+  Out.ChunksY = (Params.Height + Out.ChunkSize - 1) / Out.ChunkSize;
+  Out.Chunks.resize(static_cast<size_t>(Out.ChunksX) * Out.ChunksY);
+
+  for (int32_t ChunkY = 0; ChunkY < Out.ChunksY; ChunkY++) {
+    for (int32_t ChunkX = 0; ChunkX < Out.ChunksX; ChunkX++) {
+      FMapChunk &Chunk = Out.Chunks[ChunkY * Out.ChunksX + ChunkX];
+      Chunk.MinX = ChunkX * Out.ChunkSize;
+      Chunk.MinY = ChunkY * Out.ChunkSize;
+      Chunk.MaxX = std::min(Chunk.MinX + Out.ChunkSize, Params.Width);
+      Chunk.MaxY = std::min(Chunk.MinY + Out.ChunkSize, Params.Height);
+      Chunk.Walls.clear();
+      Chunk.Flags.clear();
+      Chunk.EnemySpawns.clear();
+    }
+  }
+}
+
+void GenerateChunk(const FMapParams &Params, uint64_t Seed, int32_t Index,
+                   FMapChunk &Chunk) {
+  FRandom Rng(FRandom::MixSeed(Seed, static_cast<uint64_t>(Index)));
+
+  for (int32_t X = Chunk.MinX; X < Chunk.MaxX; X++) {
+    for (int32_t Y = Chunk.MinY; Y < Chunk.MaxY; Y++) {
+      if (IsBorder(Params, X, Y)) {
+        Chunk.Walls.push_back(FTile{X, Y});
+        continue;
+      }
+      if (IsInSafeZone(Params, X, Y))
+        continue;
+      if (Rng.NextFloat() < Params.WallChance) {
+        Chunk.Walls.push_back(FTile{X, Y});
+        continue;
+      }
+      if (Rng.NextFloat() < Params.ItemChance) {
+        Chunk.Flags.push_back(FTile{X, Y});
+      }
+    }
+  }
+}
+
+void FinishChunkedLayout(const FMapParams &Params, uint64_t Seed,
+                         FChunkedMapLayout &Out) {
+  FMapLayout &Layout = Out.Layout;
+  Layout.Walls.Init(Params.Width, Params.Height);
+  Layout.Flags.clear();
+  Layout.EnemySpawns.clear();
+  Layout.PlayerStart = FTile{1, 1};
+
+  for (const FMapChunk &Chunk : Out.Chunks) {
+    for (const FTile &Wall : Chunk.Walls)
+      Layout.Walls.SetBlocked(Wall.X, Wall.Y);
+    Layout.Flags.insert(Layout.Flags.end(), Chunk.Flags.begin(),
+                        Chunk.Flags.end());
+  }
+
+  Layout.EnemySpawns.push_back(FTile{Params.Width - 2, Params.Height - 2});
+  Layout.EnemySpawns.push_back(FTile{Params.Width - 2, 1});
+
+  // Past the last chunk index so it never shares a chunk's stream
+  FRandom Rng(
+      FRandom::MixSeed(Seed, static_cast<uint64_t>(Out.Chunks.size())));
+  PlaceExtraEnemies(Params, Rng, Layout);
+
+  // Corridors carved here must not be spawned as walls later
+  FReachability Reach;
+  if (Params.bEnsureReachable && EnsureReachable(Layout, Reach) > 0) {
+    for (FMapChunk &Chunk : Out.Chunks) {
+      Chunk.Walls.erase(std::remove_if(Chunk.Walls.begin(), Chunk.Walls.end(),
+                                       [&](const FTile &Wall) {
+                                         return Layout.Walls.IsWalkable(
+                                             Wall.X, Wall.Y);
+                                       }),
+                        Chunk.Walls.end());
+    }
+  }
+
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Out.Chunks[Out.ChunkIndexAt(Spawn.X, Spawn.Y)].EnemySpawns.push_back(Spawn);
+}
+
+void SplitLayoutIntoChunks(int32_t ChunkSize, FChunkedMapLayout &Out) {
+  const FMapLayout &Layout = Out.Layout;
+  FMapParams Params;
+  Params.Width = Layout.Walls.GetWidth();
+  Params.Height = Layout.Walls.GetHeight();
+  PrepareChunkedLayout(Params, ChunkSize, Out);
+
+  // Same visiting order as GenerateChunk
+  for (FMapChunk &Chunk : Out.Chunks) {
+    for (int32_t X = Chunk.MinX; X < Chunk.MaxX; X++) {
+      for (int32_t Y = Chunk.MinY; Y < Chunk.MaxY; Y++) {
+        if (!Layout.Walls.IsWalkable(X, Y))
+          Chunk.Walls.push_back(FTile{X, Y});
+      }
+    }
+  }
+  for (const FTile &Flag : Layout.Flags)
+    Out.Chunks[Out.ChunkIndexAt(Flag.X, Flag.Y)].Flags.push_back(Flag);
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Out.Chunks[Out.ChunkIndexAt(Spawn.X, Spawn.Y)].EnemySpawns.push_back(Spawn);
+}
+
+} // namespace BangGuChaSim
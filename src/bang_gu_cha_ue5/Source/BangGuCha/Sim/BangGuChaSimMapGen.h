@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimRandom.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+enum class EMapStyle : uint8_t {
+  // Independent random inner walls (the original rules)
+  Scatter,
+  // Perfect maze: exactly one path between any two tiles
+  Backtracker,
+  // Maze with a share of its dead ends opened into loops
+  Braided
+};
+
+struct FMapParams {
+  int32_t Width = 20;
+  int32_t Height = 15;
+  float WallChance = 0.1f;
+  float ItemChance = 0.05f;
+  // Top-left square kept free of walls and items for the player
+  int32_t SafeZoneSize = 3;
+  // Swarm modes: additional enemies on random open tiles outside the safe
+  // zone, drawn after the base layout so it stays seed-compatible
+  int32_t ExtraEnemies = 0;
+  // Mazes ignore WallChance. GenerateLayoutChunked always scatters.
+  EMapStyle Style = EMapStyle::Scatter;
+  // Braided only: fraction of dead ends opened up
+  float BraidChance = 0.5f;
+  // Carve corridors so every flag and enemy spawn connects to the player
+  bool bEnsureReachable = true;
+};
+
+struct FMapLayout {
+  FOccupancyGrid Walls;
+  std::vector<FTile> Flags;
+  std::vector<FTile> EnemySpawns;
+  FTile PlayerStart = {1, 1};
+};
+
+/**
+ * Same rules as ABangGuChaMapGenerator::GenerateMap: border walls, a safe
+ * zone for the player, random inner walls (or a maze) and flags, and two
+ * enemies at the far corners. Out is reused so repeated generation does not
+ * reallocate.
+ */
+void GenerateLayout(const FMapParams &Params, FRandom &Rng, FMapLayout &Out);
+
+// One square block of a chunked layout. Max is exclusive.
+struct FMapChunk {
+  int32_t MinX = 0;
+  int32_t MinY = 0;
+  int32_t MaxX = 0;
+  int32_t MaxY = 0;
+  std::vector<FTile> Walls;
+  std::vector<FTile> Flags;
+  std::vector<FTile> EnemySpawns;
+};
+
+struct FChunkedMapLayout {
+  FMapLayout Layout;
+  int32_t ChunkSize = 0;
+  int32_t ChunksX = 0;
+  int32_t ChunksY = 0;
+  // Row-major, ChunkY * ChunksX + ChunkX
+  std::vector<FMapChunk> Chunks;
+
+  int32_t ChunkIndexAt(int32_t X, int32_t Y) const {
+    return (Y / ChunkSize) * ChunksX + X / ChunkSize;
+  }
+};
+
+/**
+ * Chunked variant of GenerateLayout for very large maps. Every chunk draws
+ * from its own stream, MixSeed(Seed, ChunkIndex), so chunks can be filled
+ * in any order or in parallel and still give the same map. The result is
+ * not the same map GenerateLayout makes from that seed.
+ *
+ * ParallelFor(Num, Body) must call Body(i) once for every i in [0, Num);
+ * a plain loop, UE's ParallelFor and a thread pool all work.
+ */
+void PrepareChunkedLayout(const FMapParams &Params, int32_t ChunkSize,
+                          FChunkedMapLayout &Out);
+void GenerateChunk(const FMapParams &Params, uint64_t Seed, int32_t Index,
+                   FMapChunk &Chunk);
+// Serial: merges chunk walls into the grid, then places the enemies
+void FinishChunkedLayout(const FMapParams &Params, uint64_t Seed,
+                         FChunkedMapLayout &Out);
+
+// Fills the chunk lists from a complete Out.Layout, such as a loaded level,
+// so it streams like a generated one. For a layout GenerateLayoutChunked
+// made, the chunks come out the same as it left them.
+void SplitLayoutIntoChunks(int32_t ChunkSize, FChunkedMapLayout &Out);
+
+template <typename ParallelForFn>
+void GenerateLayoutChunked(const FMapParams &Params, uint64_t Seed,
+                           int32_t ChunkSize, FChunkedMapLayout &Out,
+                           ParallelForFn &&ParallelFor) {
+  PrepareChunkedLayout(Params, ChunkSize, Out);
+  ParallelFor(static_cast<int32_t>(Out.Chunks.size()), [&](int32_t Index) {
+    GenerateChunk(Params, Seed, Index, Out.Chunks[Index]);
+  });
+  FinishChunkedLayout(Params, Seed, Out);
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,97 @@
+#include "BangGuChaSimMaze.h"
+#include "BangGuChaSimTypes.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace BangGuChaSim {
+
+namespace {
+
+constexpr EDirection CellDirs[4] = {EDirection::PosX, EDirection::NegX,
+                                    EDirection::PosY, EDirection::NegY};
+
+} // namespace
+
+void CarveMaze(FOccupancyGrid &Grid, FRandom &Rng, float BraidChance) {
+  const int32_t CellsX = (Grid.GetWidth() - 1) / 2;
+  const int32_t CellsY = (Grid.GetHeight() - 1) / 2;
+  Grid.Fill(true);
+  if (CellsX < 1 || CellsY < 1)
+    return;
+
+  // Visited cells as bytes with a border of pre-visited cells, so the
+  // neighbour test below needs no bounds checks or branches
+  const int32_t Stride = CellsX + 2;
+  std::vector<uint8_t> Visited(static_cast<size_t>(Stride) * (CellsY + 2), 1);
+  for (int32_t CY = 0; CY < CellsY; CY++)
+    std::fill_n(&Visited[static_cast<size_t>(CY + 1) * Stride + 1], CellsX, 0);
+  const int32_t Offsets[4] = {1, -1, Stride, -Stride}; // CellDirs order
+
+  std::vector<int32_t> Stack;
+  Stack.reserve(static_cast<size_t>(CellsX) * CellsY / 4 + 1);
+  Grid.SetBlocked(1, 1, false);
+  Visited[Stride + 1] = 1;
+  Stack.push_back(Stride + 1);
+
+  while (!Stack.empty()) {
+    const int32_t Cell = Stack.back();
+    const uint32_t Unvisited = uint32_t(!Visited[Cell + Offsets[0]]) |
+                               uint32_t(!Visited[Cell + Offsets[1]]) << 1 |
+                               uint32_t(!Visited[Cell + Offsets[2]]) << 2 |
+                               uint32_t(!Visited[Cell + Offsets[3]]) << 3;
+    if (Unvisited == 0) {
+      Stack.pop_back();
+      continue;
+    }
+
+    // Pick the n-th unvisited neighbour in CellDirs order
+    const int32_t NumOptions = (Unvisited & 1) + (Unvisited >> 1 & 1) +
+                               (Unvisited >> 2 & 1) + (Unvisited >> 3 & 1);
+    int32_t Pick = Rng.RandRange(0, NumOptions - 1);
+    int32_t DirIndex = 0;
+    while (!(Unvisited >> DirIndex & 1) || Pick-- > 0)
+      DirIndex++;
+
+    const EDirection Dir = CellDirs[DirIndex];
+    const int32_t Next = Cell + Offsets[DirIndex];
+    const int32_t X = 2 * (Cell % Stride - 1) + 1;
+    const int32_t Y = 2 * (Cell / Stride - 1) + 1;
+    Grid.SetBlocked(X + StepX(Dir), Y + StepY(Dir), false);
+    Grid.SetBlocked(X + 2 * StepX(Dir), Y + 2 * StepY(Dir), false);
+    Visited[Next] = 1;
+    Stack.push_back(Next);
+  }
+
+  if (BraidChance <= 0.f)
+    return;
+
+  auto IsCell = [&](int32_t CX, int32_t CY) {
+    return CX >= 0 && CX < CellsX && CY >= 0 && CY < CellsY;
+  };
+
+  for (int32_t CY = 0; CY < CellsY; CY++) {
+    for (int32_t CX = 0; CX < CellsX; CX++) {
+      const int32_t X = 2 * CX + 1;
+      const int32_t Y = 2 * CY + 1;
+
+      EDirection Closed[4];
+      int32_t NumClosed = 0;
+      int32_t NumPassages = 0;
+      for (EDirection Dir : CellDirs) {
+        if (Grid.IsWalkable(X + StepX(Dir), Y + StepY(Dir)))
+          NumPassages++;
+        else if (IsCell(CX + StepX(Dir), CY + StepY(Dir)))
+          Closed[NumClosed++] = Dir;
+      }
+      if (NumPassages != 1 || NumClosed == 0 ||
+          Rng.NextFloat() >= BraidChance)
+        continue;
+
+      const EDirection Dir = Closed[Rng.RandRange(0, NumClosed - 1)];
+      Grid.SetBlocked(X + StepX(Dir), Y + StepY(Dir), false);
+    }
+  }
+}
+
+} // namespace BangGuChaSim
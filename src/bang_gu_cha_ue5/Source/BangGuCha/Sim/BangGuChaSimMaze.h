@@ -0,0 +1,17 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimRandom.h"
+
+namespace BangGuChaSim {
+
+/**
+ * Fills Grid with wall and carves a perfect maze with an iterative
+ * recursive backtracker. Cells sit on odd coordinates, starting at (1, 1),
+ * and the walls between them are the even tiles. With BraidChance > 0,
+ * that fraction of dead ends get knocked through to a neighbouring cell,
+ * which adds loops so a single chaser cannot corner the player.
+ */
+void CarveMaze(FOccupancyGrid &Grid, FRandom &Rng, float BraidChance);
+
+} // namespace BangGuChaSim
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "BangGuChaSimRules.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstdint>
+
+namespace BangGuChaSim {
+
+/**
+ * A mover's grid position packed into 32 bits for replication: the tile it
+ * is leaving (12 bits per axis, so maps up to 4096 tiles a side), its
+ * direction (3 bits) and how far it is toward the next tile in 1/32 tile
+ * steps (5 bits). A mover standing still packs as its tile with direction
+ * None and no progress.
+ *
+ * Receivers dead-reckon between updates with StepPlayerMover and no queued
+ * turn (straight on, stop at walls), so a sender only has to send a new
+ * state when its direction changes.
+ */
+constexpr int32_t NetTileBits = 12;
+constexpr uint32_t NetTileMask = (1u << NetTileBits) - 1;
+// Largest map side whose tiles still fit in NetTileBits
+constexpr int32_t NetMaxMapSize = 1 << NetTileBits;
+constexpr int32_t NetProgressSteps = 32;
+constexpr int32_t NetProgressUnits = TileUnits / NetProgressSteps;
+
+inline uint32_t PackNetGridState(const FMover &Mover) {
+  const EDirection Dir = Mover.Direction;
+  const FTile From{Mover.Target.X - StepX(Dir), Mover.Target.Y - StepY(Dir)};
+
+  int32_t Progress = 0;
+  if (Dir != EDirection::None) {
+    const int32_t Travelled = TileUnits - Mover.Remaining;
+    Progress = (Travelled + NetProgressUnits / 2) / NetProgressUnits;
+    Progress = Progress < 0 ? 0
+               : Progress >= NetProgressSteps ? NetProgressSteps - 1
+                                              : Progress;
+  }
+
+  return (static_cast<uint32_t>(From.X) & NetTileMask) |
+         (static_cast<uint32_t>(From.Y) & NetTileMask) << NetTileBits |
+         static_cast<uint32_t>(Dir) << (2 * NetTileBits) |
+         static_cast<uint32_t>(Progress) << (2 * NetTileBits + 3);
+}
+
+// Restores position, target and direction; NextDirection and PendingTime
+// are left alone
+inline void UnpackNetGridState(uint32_t State, float GridSize,
+                               FMover &Mover) {
+  const FTile From{static_cast<int32_t>(State & NetTileMask),
+                   static_cast<int32_t>((State >> NetTileBits) & NetTileMask)};
+  const EDirection Dir =
+      static_cast<EDirection>((State >> (2 * NetTileBits)) & 7u);
+  const int32_t Progress = static_cast<int32_t>(State >> (2 * NetTileBits + 3));
+
+  Mover.Direction = Dir;
+  Mover.Target = FTile{From.X + StepX(Dir), From.Y + StepY(Dir)};
+  Mover.Remaining =
+      Dir != EDirection::None ? TileUnits - Progress * NetProgressUnits : 0;
+  UpdateMoverPosition(Mover, GridSize);
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+namespace BangGuChaSim {
+
+/**
+ * Small seeded generator (PCG32) so a seed reproduces the same map and
+ * match on every platform, unlike FMath::RandRange.
+ */
+class FRandom {
+public:
+  explicit FRandom(uint64_t Seed = 0) { Reseed(Seed); }
+
+  void Reseed(uint64_t Seed) {
+    State = 0;
+    NextUInt32();
+    State += Seed + 0x853c49e6748fea9bULL;
+    NextUInt32();
+  }
+
+  uint32_t NextUInt32() {
+    const uint64_t Old = State;
+    State = Old * 6364136223846793005ULL + Increment;
+    const uint32_t XorShifted =
+        static_cast<uint32_t>(((Old >> 18u) ^ Old) >> 27u);
+    const uint32_t Rot = static_cast<uint32_t>(Old >> 59u);
+    return (XorShifted >> Rot) | (XorShifted << ((32u - Rot) & 31u));
+  }
+
+  // Uniform in [0, 1)
+  float NextFloat() {
+    return static_cast<float>(NextUInt32() >> 8) * (1.0f / 16777216.0f);
+  }
+
+  // Uniform in [Min, Max], both inclusive
+  int32_t RandRange(int32_t Min, int32_t Max) {
+    if (Max <= Min)
+      return Min;
+    const uint32_t Span = static_cast<uint32_t>(Max - Min) + 1u;
+    return Min + static_cast<int32_t>(NextUInt32() % Span);
+  }
+
+  // Decorrelated stream for a sub-problem (a chunk, a match in a batch)
+  static uint64_t MixSeed(uint64_t Seed, uint64_t Salt) {
+    uint64_t Z = Seed + 0x9e3779b97f4a7c15ULL * (Salt + 1);
+    Z = (Z ^ (Z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    Z = (Z ^ (Z >> 27)) * 0x94d049bb133111ebULL;
+    return Z ^ (Z >> 31);
+  }
+
+private:
+  static constexpr uint64_t Increment = 1442695040888963407ULL;
+  uint64_t State = 0;
+};
+
+} // namespace BangGuChaSim
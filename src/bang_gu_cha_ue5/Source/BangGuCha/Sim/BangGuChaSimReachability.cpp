@@ -0,0 +1,149 @@
+#include "BangGuChaSimReachability.h"
+#include "BangGuChaSimMapGen.h"
+
+namespace BangGuChaSim {
+
+namespace {
+
+// Grows Seeds through the open runs of one word in both directions with
+// shift-doubling (Kogge-Stone) fills: six steps cover all 64 bits.
+uint64_t FillRuns(uint64_t Seeds, uint64_t Open) {
+  uint64_t Up = Seeds;
+  uint64_t Down = Seeds;
+  uint64_t UpOpen = Open;
+  uint64_t DownOpen = Open;
+  for (int Shift = 1; Shift < 64; Shift <<= 1) {
+    Up |= UpOpen & (Up << Shift);
+    UpOpen &= UpOpen << Shift;
+    Down |= DownOpen & (Down >> Shift);
+    DownOpen &= DownOpen >> Shift;
+  }
+  return Up | Down;
+}
+
+int32_t StepToward(int32_t From, int32_t To) {
+  return From < To ? 1 : (From > To ? -1 : 0);
+}
+
+} // namespace
+
+void FReachability::Init(const FOccupancyGrid &Grid) {
+  Width = Grid.GetWidth();
+  Height = Grid.GetHeight();
+  WordsPerRow = (static_cast<size_t>(Width) + 63) / 64;
+  Open.assign(WordsPerRow * Height, 0);
+  Reached.assign(Open.size(), 0);
+  Work.clear();
+
+  // Re-pack the grid's row-major bit stream into row-aligned words
+  const std::vector<uint64_t> &Blocked = Grid.GetWords();
+  const uint64_t TailMask =
+      (Width & 63) ? (uint64_t(1) << (Width & 63)) - 1 : ~uint64_t(0);
+  for (int32_t Y = 0; Y < Height; Y++) {
+    const size_t RowBit = static_cast<size_t>(Y) * Width;
+    for (size_t Col = 0; Col < WordsPerRow; Col++) {
+      const size_t Bit = RowBit + Col * 64;
+      const size_t Index = Bit >> 6;
+      const unsigned Shift = Bit & 63;
+      uint64_t Bits = Blocked[Index] >> Shift;
+      if (Shift != 0 && Index + 1 < Blocked.size())
+        Bits |= Blocked[Index + 1] << (64 - Shift);
+      uint64_t Free = ~Bits;
+      if (Col + 1 == WordsPerRow)
+        Free &= TailMask;
+      Open[static_cast<size_t>(Y) * WordsPerRow + Col] = Free;
+    }
+  }
+}
+
+void FReachability::SetOpen(int32_t X, int32_t Y) {
+  if (static_cast<uint32_t>(X) >= static_cast<uint32_t>(Width) ||
+      static_cast<uint32_t>(Y) >= static_cast<uint32_t>(Height))
+    return;
+  Open[static_cast<size_t>(Y) * WordsPerRow + (X >> 6)] |= uint64_t(1)
+                                                           << (X & 63);
+}
+
+void FReachability::Spread(size_t Word, uint64_t Bits) {
+  const uint64_t Added = Bits & Open[Word] & ~Reached[Word];
+  if (Added != 0) {
+    Reached[Word] |= Added;
+    Work.push_back(Word);
+  }
+}
+
+void FReachability::Flood(int32_t X, int32_t Y) {
+  if (!IsOpen(X, Y) || IsReached(X, Y))
+    return;
+
+  Spread(static_cast<size_t>(Y) * WordsPerRow + (X >> 6), uint64_t(1)
+                                                             << (X & 63));
+  while (!Work.empty()) {
+    const size_t Word = Work.back();
+    Work.pop_back();
+
+    const uint64_t Filled = FillRuns(Reached[Word], Open[Word]);
+    Reached[Word] = Filled;
+
+    // Runs touching a word edge continue in the neighbouring word
+    const size_t Col = Word % WordsPerRow;
+    if (Col > 0 && (Filled & 1))
+      Spread(Word - 1, uint64_t(1) << 63);
+    if (Col + 1 < WordsPerRow && (Filled >> 63))
+      Spread(Word + 1, 1);
+    if (Word >= WordsPerRow)
+      Spread(Word - WordsPerRow, Filled);
+    if (Word + WordsPerRow < Open.size())
+      Spread(Word + WordsPerRow, Filled);
+  }
+}
+
+size_t FReachability::CountReached() const {
+  size_t Count = 0;
+  for (uint64_t Bits : Reached) {
+    while (Bits != 0) {
+      Bits &= Bits - 1;
+      Count++;
+    }
+  }
+  return Count;
+}
+
+int32_t EnsureReachable(FMapLayout &Layout, FReachability &Scratch) {
+  FOccupancyGrid &Walls = Layout.Walls;
+  const FTile Start = Layout.PlayerStart;
+  Scratch.Init(Walls);
+  Scratch.Flood(Start.X, Start.Y);
+
+  int32_t Carved = 0;
+  auto Connect = [&](const FTile &Target) {
+    if (Scratch.IsReached(Target.X, Target.Y))
+      return;
+
+    FTile At = Target;
+    for (;;) {
+      if (!Walls.IsWalkable(At.X, At.Y)) {
+        Walls.SetBlocked(At.X, At.Y, false);
+        Scratch.SetOpen(At.X, At.Y);
+        Carved++;
+      }
+      if (At == Start)
+        break;
+      const int32_t DX = StepToward(At.X, Start.X);
+      const FTile Next{At.X + DX,
+                       At.Y + (DX == 0 ? StepToward(At.Y, Start.Y) : 0)};
+      if (Scratch.IsReached(Next.X, Next.Y))
+        break;
+      At = Next;
+    }
+    Scratch.Flood(Target.X, Target.Y);
+  };
+
+  for (const FTile &Flag : Layout.Flags)
+    Connect(Flag);
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Connect(Spawn);
+  return Carved;
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+struct FMapLayout;
+
+/**
+ * Word-parallel flood fill over a copy of a grid's open tiles. Rows are
+ * padded to whole 64-bit words, so a word holds 64 horizontal neighbours:
+ * a single fill fills every open run in it, and a plain AND moves reach to
+ * the word above or below. The work list holds words, not tiles.
+ */
+class FReachability {
+public:
+  // Copies the open tiles of Grid and clears any previous reach
+  void Init(const FOccupancyGrid &Grid);
+
+  // Mirrors a tile opened in the source grid after Init
+  void SetOpen(int32_t X, int32_t Y);
+
+  // Adds everything connected to (X, Y); earlier reach is kept, so more
+  // seeds can be flooded one after another
+  void Flood(int32_t X, int32_t Y);
+
+  bool IsOpen(int32_t X, int32_t Y) const { return TestBit(Open, X, Y); }
+  bool IsReached(int32_t X, int32_t Y) const {
+    return TestBit(Reached, X, Y);
+  }
+  size_t CountReached() const;
+
+private:
+  bool TestBit(const std::vector<uint64_t> &Bits, int32_t X, int32_t Y) const {
+    if (static_cast<uint32_t>(X) >= static_cast<uint32_t>(Width) ||
+        static_cast<uint32_t>(Y) >= static_cast<uint32_t>(Height))
+      return false;
+    const size_t Word = static_cast<size_t>(Y) * WordsPerRow + (X >> 6);
+    return (Bits[Word] >> (X & 63)) & 1;
+  }
+
+  void Spread(size_t Word, uint64_t Bits);
+
+  int32_t Width = 0;
+  int32_t Height = 0;
+  size_t WordsPerRow = 0;
+  std::vector<uint64_t> Open;
+  std::vector<uint64_t> Reached;
+  std::vector<size_t> Work;
+};
+
+/**
+ * Floods from Layout.PlayerStart and, for every flag or enemy spawn the
+ * flood misses, carves a corridor toward the start (x first, then y) until
+ * it meets reached ground. Returns the number of wall tiles removed.
+ */
+int32_t EnsureReachable(FMapLayout &Layout, FReachability &Scratch);
+
+} // namespace BangGuChaSim
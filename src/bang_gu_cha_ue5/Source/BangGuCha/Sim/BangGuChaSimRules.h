@@ -0,0 +1,283 @@
+#pragma once
+
+#include "BangGuChaSimFlowField.h"
+#include "BangGuChaSimHierarchicalPath.h"
+#include "BangGuChaSimJunctionGraph.h"
+#include "BangGuChaSimTypes.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace BangGuChaSim {
+
+// Gameplay constants shared by the actors and the headless world
+constexpr float FartFuelCost = 10.f;
+constexpr int32_t FlagScore = 100;
+
+// Movement is integer tiles plus fixed-point progress, advanced in fixed
+// substeps. Where a mover ends up depends only on how many substeps ran,
+// not on how frame time was split, and every turn lands on a tile center.
+constexpr int32_t TileUnits = 1 << 16;
+constexpr int32_t MoveSubstepsPerSecond = 240;
+// Substep time is kept in 1/65536 substeps
+constexpr int32_t SubstepTimeUnits = 1 << 16;
+
+/** Grid walker used by both the player and the enemies. */
+struct FMover {
+  // World position on the XY plane, derived from the fields below after
+  // every step; writing it moves nothing
+  float X = 0.f;
+  float Y = 0.f;
+  // Tile currently being moved into (or standing on once arrived)
+  FTile Target;
+  EDirection Direction = EDirection::None;
+  // Queued player turn, applied at the next tile center it fits
+  EDirection NextDirection = EDirection::None;
+  // Distance left to Target's center in TileUnits; 0 when standing on it
+  int32_t Remaining = 0;
+  // Frame time not yet spent on a whole substep, in SubstepTimeUnits
+  int32_t PendingTime = 0;
+};
+
+inline FTile WorldToTile(float X, float Y, float GridSize) {
+  return FTile{static_cast<int32_t>(std::floor(X / GridSize + 0.5f)),
+               static_cast<int32_t>(std::floor(Y / GridSize + 0.5f))};
+}
+
+inline void UpdateMoverPosition(FMover &Mover, float GridSize) {
+  const float Behind = static_cast<float>(Mover.Remaining) / TileUnits;
+  Mover.X = (Mover.Target.X - StepX(Mover.Direction) * Behind) * GridSize;
+  Mover.Y = (Mover.Target.Y - StepY(Mover.Direction) * Behind) * GridSize;
+}
+
+// Places the mover standing on the tile center nearest (X, Y)
+inline void InitMover(FMover &Mover, float X, float Y, float GridSize) {
+  Mover = FMover();
+  Mover.Target = WorldToTile(X, Y, GridSize);
+  UpdateMoverPosition(Mover, GridSize);
+}
+
+// Rounded conversions; plain casts instead of std::lround keep them
+// inline in the per-enemy loop
+inline int32_t MoveUnitsPerSubstep(float Speed, float GridSize) {
+  if (Speed <= 0.f || GridSize <= 0.f)
+    return 0;
+  return static_cast<int32_t>(
+      Speed / GridSize *
+          (static_cast<float>(TileUnits) / MoveSubstepsPerSecond) +
+      0.5f);
+}
+
+inline int32_t SubstepTime(float DeltaTime) {
+  if (DeltaTime <= 0.f)
+    return 0;
+  return static_cast<int32_t>(
+      DeltaTime * static_cast<float>(MoveSubstepsPerSecond) *
+          static_cast<float>(SubstepTimeUnits) +
+      0.5f);
+}
+
+/**
+ * Spends DeltaTime on whole substeps at Speed. Each time the mover reaches
+ * Target's center, Decide(Mover) runs with X and Y on that center; it sets
+ * Direction and, returning true, Target to the next tile. Distance past a
+ * center carries into the next tile, so speed stays exact through turns at
+ * any frame rate. A mover that decides to stay put drops its pending time
+ * and decides again on the next call. Returns true when a new target tile
+ * was picked.
+ */
+template <typename DecideFn>
+bool StepMover(FMover &Mover, float DeltaTime, float Speed, float GridSize,
+               DecideFn &&Decide) {
+  Mover.PendingTime += SubstepTime(DeltaTime);
+  const int32_t Step = MoveUnitsPerSubstep(Speed, GridSize);
+  int32_t Substeps = Mover.PendingTime / SubstepTimeUnits;
+  Mover.PendingTime -= Substeps * SubstepTimeUnits;
+
+  // Whole runs of substeps between tile centers are applied at once; the
+  // result is the same as stepping them one by one
+  bool bNewTarget = false;
+  while (Substeps > 0) {
+    if (Substeps * Step < Mover.Remaining) {
+      Mover.Remaining -= Substeps * Step;
+      break;
+    }
+    // Substeps that end short of Target's center
+    const int32_t Short = Step > 0             ? (Mover.Remaining - 1) / Step
+                          : Mover.Remaining > 0 ? Substeps
+                                                : 0;
+    if (Short >= Substeps) {
+      Mover.Remaining -= Substeps * Step;
+      break;
+    }
+    Mover.Remaining -= (Short + 1) * Step;
+    Substeps -= Short + 1;
+
+    while (Mover.Remaining <= 0) {
+      Mover.X = Mover.Target.X * GridSize;
+      Mover.Y = Mover.Target.Y * GridSize;
+      if (!Decide(Mover)) {
+        Mover.Remaining = 0;
+        Mover.PendingTime = 0;
+        return bNewTarget;
+      }
+      bNewTarget = true;
+      Mover.Remaining += TileUnits;
+    }
+  }
+
+  UpdateMoverPosition(Mover, GridSize);
+  return bNewTarget;
+}
+
+// Player movement: at each tile center take the queued turn if it fits,
+// keep going straight otherwise, and stop at walls. Returns true when a new
+// target tile was picked.
+template <typename CanEnterFn>
+bool StepPlayerMover(FMover &Mover, float DeltaTime, float Speed,
+                     float GridSize, CanEnterFn &&CanEnter) {
+  return StepMover(Mover, DeltaTime, Speed, GridSize, [&](FMover &At) {
+    if (At.NextDirection != EDirection::None &&
+        CanEnter(At.Target.X + StepX(At.NextDirection),
+                 At.Target.Y + StepY(At.NextDirection))) {
+      At.Direction = At.NextDirection;
+    }
+
+    if (At.Direction == EDirection::None)
+      return false;
+
+    const FTile Next{At.Target.X + StepX(At.Direction),
+                     At.Target.Y + StepY(At.Direction)};
+    if (!CanEnter(Next.X, Next.Y)) {
+      At.Direction = EDirection::None;
+      return false;
+    }
+    At.Target = Next;
+    return true;
+  });
+}
+
+// Enemy movement: at each tile center ask Choose() for a direction and
+// commit to it. Returns true when a new target tile was picked.
+template <typename ChooseFn>
+bool StepEnemyMover(FMover &Mover, float DeltaTime, float Speed,
+                    float GridSize, ChooseFn &&Choose) {
+  return StepMover(Mover, DeltaTime, Speed, GridSize, [&](FMover &At) {
+    At.Direction = Choose();
+    if (At.Direction == EDirection::None)
+      return false;
+
+    At.Target.X += StepX(At.Direction);
+    At.Target.Y += StepY(At.Direction);
+    return true;
+  });
+}
+
+inline int32_t SignOf(float Value) {
+  return Value > 0.f ? 1 : (Value < 0.f ? -1 : 0);
+}
+
+// Chase decision for an enemy standing on tile At (world position X, Y).
+// Follows the junction graph, the hierarchical path or the flow field,
+// whichever is given and has a way to the player; otherwise prefers the
+// axis with the larger distance to the player, then the other axis, then
+// any open direction, and reverses Current as a last resort.
+template <typename CanEnterFn>
+EDirection ChooseEnemyDirection(FTile At, float X, float Y, EDirection Current,
+                                float PlayerX, float PlayerY,
+                                const FJunctionGraph *Graph,
+                                const FHierarchicalPath *Hierarchical,
+                                const FFlowField *FlowField,
+                                CanEnterFn &&CanEnter) {
+  if (Graph) {
+    const EDirection Step = Graph->GetStep(At, Current);
+    if (Step != EDirection::None)
+      return Step;
+  }
+  if (Hierarchical) {
+    const EDirection Step = Hierarchical->GetStep(At);
+    if (Step != EDirection::None)
+      return Step;
+  }
+  if (FlowField) {
+    const EDirection Step = FlowField->GetStep(At.X, At.Y);
+    if (Step != EDirection::None)
+      return Step;
+  }
+
+  const float DiffX = PlayerX - X;
+  const float DiffY = PlayerY - Y;
+  const int32_t SignX = SignOf(DiffX);
+  const int32_t SignY = SignOf(DiffY);
+
+  // Preferred may be None when the player is straight ahead on this tile's
+  // axis line; standing still is then a valid choice.
+  const bool bPreferX = std::fabs(DiffX) > std::fabs(DiffY);
+  const EDirection Preferred =
+      bPreferX ? DirectionFromStep(SignX, 0) : DirectionFromStep(0, SignY);
+  if (CanEnter(At.X + StepX(Preferred), At.Y + StepY(Preferred)))
+    return Preferred;
+
+  EDirection Secondary =
+      bPreferX ? DirectionFromStep(0, SignY) : DirectionFromStep(SignX, 0);
+  if (Secondary == EDirection::None)
+    Secondary = EDirection::PosX; // Fallback
+  if (CanEnter(At.X + StepX(Secondary), At.Y + StepY(Secondary)))
+    return Secondary;
+
+  static constexpr EDirection Dirs[4] = {EDirection::PosX, EDirection::NegX,
+                                         EDirection::PosY, EDirection::NegY};
+  for (EDirection Dir : Dirs) {
+    if (CanEnter(At.X + StepX(Dir), At.Y + StepY(Dir)))
+      return Dir;
+  }
+
+  return Opposite(Current); // Reverse as last resort
+}
+
+// Fuel drains only while moving and bottoms out at zero.
+inline void ConsumeFuel(float &Fuel, float ConsumptionRate, float DeltaTime) {
+  Fuel -= ConsumptionRate * DeltaTime;
+  if (Fuel <= 0.f)
+    Fuel = 0.f;
+}
+
+inline bool TrySpendFartFuel(float &Fuel) {
+  if (Fuel < FartFuelCost)
+    return false;
+  Fuel -= FartFuelCost;
+  return true;
+}
+
+inline void ApplyStun(bool &bIsStunned, float &StunTimer, float Duration) {
+  bIsStunned = true;
+  StunTimer = Duration;
+}
+
+// Returns true when the stun used up this frame (including the frame it
+// wears off), in which case the enemy does not move.
+inline bool TickStun(bool &bIsStunned, float &StunTimer, float DeltaTime) {
+  if (!bIsStunned)
+    return false;
+  StunTimer -= DeltaTime;
+  if (StunTimer <= 0.f)
+    bIsStunned = false;
+  return true;
+}
+
+// Returns false once the lifetime has run out.
+inline bool TickLifetime(float &Remaining, float DeltaTime) {
+  Remaining -= DeltaTime;
+  return Remaining > 0.f;
+}
+
+inline void CollectFlag(int32_t &Score, int32_t &CollectedFlags) {
+  CollectedFlags++;
+  Score += FlagScore;
+}
+
+inline bool HasCollectedAllFlags(int32_t CollectedFlags, int32_t TotalFlags) {
+  return TotalFlags > 0 && CollectedFlags >= TotalFlags;
+}
+
+} // namespace BangGuChaSim
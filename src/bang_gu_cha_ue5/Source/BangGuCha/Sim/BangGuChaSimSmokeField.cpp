@@ -0,0 +1,203 @@
+#include "BangGuChaSimSmokeField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BANGGUCHA_SIM_SSE2 1
+#include <emmintrin.h>
+#else
+#define BANGGUCHA_SIM_SSE2 0
+#endif
+
+namespace BangGuChaSim {
+
+namespace {
+
+constexpr uint8_t Closed = 0xff;
+constexpr int32_t TilesPerIteration = 16;
+
+// Steps one row of Count tiles from In to Out, both pointing at the row's
+// first tile; rows above and below are a Stride away. Everything up to the
+// next multiple of TilesPerIteration may be read and written. With Gain the
+// faded spread share, a tile with N open neighbours keeps
+// Fade - Gain * N of its own smoke and gains Gain of each neighbour's.
+// Returns true if any tile still holds smoke.
+bool StepRow(const float *In, const uint8_t *Codes, float *Out,
+             size_t Stride, int32_t Count, float Gain, float Fade) {
+  const float *Above = In - Stride;
+  const float *Below = In + Stride;
+#if BANGGUCHA_SIM_SSE2
+  const __m128 VGain = _mm_set1_ps(Gain);
+  const __m128 VFade = _mm_set1_ps(Fade);
+  const __m128 VFlush = _mm_set1_ps(FSmokeField::FlushDensity);
+  const __m128i VZero = _mm_setzero_si128();
+  const __m128i VClosed = _mm_set1_epi8(static_cast<char>(Closed));
+  __m128 Kept = _mm_setzero_ps();
+
+  auto StepFour = [&](int32_t X, __m128i Open32, __m128i Wall32) {
+    const __m128 Open = _mm_cvtepi32_ps(Open32);
+    const __m128 Sum = _mm_add_ps(
+        _mm_add_ps(_mm_loadu_ps(In + X - 1), _mm_loadu_ps(In + X + 1)),
+        _mm_add_ps(_mm_loadu_ps(Above + X), _mm_loadu_ps(Below + X)));
+    const __m128 Keep = _mm_sub_ps(VFade, _mm_mul_ps(VGain, Open));
+    const __m128 Value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(In + X), Keep),
+                                    _mm_mul_ps(VGain, Sum));
+    const __m128 Mask = _mm_andnot_ps(_mm_castsi128_ps(Wall32),
+                                      _mm_cmpge_ps(Value, VFlush));
+    _mm_storeu_ps(Out + X, _mm_and_ps(Value, Mask));
+    Kept = _mm_or_ps(Kept, Mask);
+  };
+
+  for (int32_t X = 0; X < Count; X += TilesPerIteration) {
+    // Widen sixteen codes to four vectors of ints; walls widen to all ones
+    // in a separate mask so their code never reaches the float math
+    const __m128i Codes8 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Codes + X));
+    const __m128i Wall8 = _mm_cmpeq_epi8(Codes8, VClosed);
+    const __m128i Open8 = _mm_andnot_si128(Wall8, Codes8);
+    const __m128i OpenLo = _mm_unpacklo_epi8(Open8, VZero);
+    const __m128i OpenHi = _mm_unpackhi_epi8(Open8, VZero);
+    const __m128i WallLo = _mm_unpacklo_epi8(Wall8, Wall8);
+    const __m128i WallHi = _mm_unpackhi_epi8(Wall8, Wall8);
+    StepFour(X, _mm_unpacklo_epi16(OpenLo, VZero),
+             _mm_unpacklo_epi16(WallLo, WallLo));
+    StepFour(X + 4, _mm_unpackhi_epi16(OpenLo, VZero),
+             _mm_unpackhi_epi16(WallLo, WallLo));
+    StepFour(X + 8, _mm_unpacklo_epi16(OpenHi, VZero),
+             _mm_unpacklo_epi16(WallHi, WallHi));
+    StepFour(X + 12, _mm_unpackhi_epi16(OpenHi, VZero),
+             _mm_unpackhi_epi16(WallHi, WallHi));
+  }
+  return _mm_movemask_ps(Kept) != 0;
+#else
+  bool bKept = false;
+  for (int32_t X = 0; X < Count; X++) {
+    const float Open = Codes[X] == Closed ? 0.f : float(Codes[X]);
+    const float Sum = In[X - 1] + In[X + 1] + Above[X] + Below[X];
+    const float Value = In[X] * (Fade - Gain * Open) + Gain * Sum;
+    const bool bKeep = Codes[X] != Closed && Value >= FSmokeField::FlushDensity;
+    Out[X] = bKeep ? Value : 0.f;
+    bKept |= bKeep;
+  }
+  return bKept;
+#endif
+}
+
+} // namespace
+
+void FSmokeField::Init(const FOccupancyGrid &Walls) {
+  Width = Walls.GetWidth();
+  Height = Walls.GetHeight();
+  // One more iteration's worth of columns covers the left border and the
+  // right neighbour of the last group
+  const size_t Groups = (static_cast<size_t>(std::max(Width, 0)) +
+                         TilesPerIteration - 1) /
+                        TilesPerIteration;
+  Stride = Width > 0 ? (Groups + 1) * TilesPerIteration : 0;
+  const size_t Size = Stride * (static_cast<size_t>(Height) + 2);
+  for (FBuffer &Buffer : Buffers) {
+    Buffer.Density.assign(Size, 0.f);
+    Buffer.FirstRow = 0;
+    Buffer.LastRow = -1;
+  }
+  Front = 0;
+
+  Neighbours.assign(Size, Closed);
+  for (int32_t Y = 0; Y < Height; Y++) {
+    for (int32_t X = 0; X < Width; X++) {
+      if (!Walls.IsWalkable(X, Y))
+        continue;
+      Neighbours[IndexOf(X, Y)] = static_cast<uint8_t>(
+          Walls.IsWalkable(X - 1, Y) + Walls.IsWalkable(X + 1, Y) +
+          Walls.IsWalkable(X, Y - 1) + Walls.IsWalkable(X, Y + 1));
+    }
+  }
+}
+
+void FSmokeField::Reset() {
+  Width = 0;
+  Height = 0;
+  Stride = 0;
+  for (FBuffer &Buffer : Buffers) {
+    Buffer.Density.clear();
+    Buffer.FirstRow = 0;
+    Buffer.LastRow = -1;
+  }
+  Front = 0;
+  Neighbours.clear();
+}
+
+void FSmokeField::Clear() {
+  // Rows outside a buffer's range are clear already
+  for (FBuffer &Buffer : Buffers) {
+    for (int32_t Y = Buffer.FirstRow; Y <= Buffer.LastRow; Y++) {
+      std::fill_n(Buffer.Density.begin() +
+                      static_cast<std::ptrdiff_t>(IndexOf(0, Y)),
+                  Width, 0.f);
+    }
+    Buffer.FirstRow = 0;
+    Buffer.LastRow = -1;
+  }
+}
+
+void FSmokeField::Deposit(int32_t X, int32_t Y, float Amount) {
+  if (static_cast<uint32_t>(X) >= static_cast<uint32_t>(Width) ||
+      static_cast<uint32_t>(Y) >= static_cast<uint32_t>(Height) ||
+      Neighbours[IndexOf(X, Y)] == Closed || !(Amount > 0.f))
+    return;
+  FBuffer &Current = Buffers[Front];
+  Current.Density[IndexOf(X, Y)] += Amount;
+  Current.FirstRow =
+      Current.FirstRow > Current.LastRow ? Y : std::min(Current.FirstRow, Y);
+  Current.LastRow = std::max(Current.LastRow, Y);
+}
+
+void FSmokeField::Step(float DeltaTime, float SpreadRate, float FadeRate) {
+  if (IsEmpty())
+    return;
+
+  const float Fade = std::exp(-std::max(FadeRate, 0.f) * DeltaTime);
+  const float Gain =
+      std::min(std::max(SpreadRate * DeltaTime, 0.f), 0.25f) * Fade;
+
+  const FBuffer &In = Buffers[Front];
+  FBuffer &Out = Buffers[Front ^ 1];
+
+  // Rows next to the smoke may receive some; everything else stays clear
+  const int32_t Begin = std::max(In.FirstRow - 1, 0);
+  const int32_t End = std::min(In.LastRow + 1, Height - 1);
+
+  // The back buffer still holds the step before last. Its rows outside
+  // this step's are cleared here; the rest are overwritten.
+  for (int32_t Y = Out.FirstRow; Y <= Out.LastRow; Y++) {
+    if (Y < Begin || Y > End) {
+      std::fill_n(Out.Density.begin() +
+                      static_cast<std::ptrdiff_t>(IndexOf(0, Y)),
+                  Width, 0.f);
+    }
+  }
+  Out.FirstRow = 0;
+  Out.LastRow = -1;
+
+  for (int32_t Y = Begin; Y <= End; Y++) {
+    const size_t Row = IndexOf(0, Y);
+    if (StepRow(&In.Density[Row], &Neighbours[Row], &Out.Density[Row],
+                Stride, Width, Gain, Fade)) {
+      Out.FirstRow = Out.FirstRow > Out.LastRow ? Y : Out.FirstRow;
+      Out.LastRow = Y;
+    }
+  }
+  Front ^= 1;
+}
+
+double FSmokeField::GetTotal() const {
+  double Total = 0.0;
+  for (float Value : Buffers[Front].Density)
+    Total += Value;
+  return Total;
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "BangGuChaSimGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+/**
+ * Smoke as a density per tile instead of one box per cloud. Each step every
+ * open tile hands a share of its smoke to each open neighbour, then all of
+ * it fades; walls neither hold nor pass smoke. Densities that fade below
+ * FlushDensity are dropped, so a field goes back to exactly empty.
+ *
+ * The kernel steps sixteen tiles per iteration as four SSE2 vectors where
+ * the target has them and falls back to a branch-free scalar loop. Only
+ * the rows that held smoke last step, plus one on each side, are visited,
+ * and the result goes to a second buffer that then becomes the current
+ * one.
+ */
+class FSmokeField {
+public:
+  // Below this a tile counts as clear. Also keeps denormals out of the
+  // kernel.
+  static constexpr float FlushDensity = 1.f / 65536;
+
+  // Sizes the field to Walls and clears it. Later wall changes are not
+  // seen until the next Init.
+  void Init(const FOccupancyGrid &Walls);
+  void Reset();
+  void Clear();
+
+  // Adds smoke to an open tile; walls and tiles off the map are ignored
+  void Deposit(int32_t X, int32_t Y, float Amount);
+
+  // SpreadRate is the share of a tile's smoke each open neighbour receives
+  // per second, capped at a quarter per step to stay stable. FadeRate is
+  // the exponential decay per second.
+  void Step(float DeltaTime, float SpreadRate, float FadeRate);
+
+  float GetDensity(int32_t X, int32_t Y) const {
+    if (static_cast<uint32_t>(X) >= static_cast<uint32_t>(Width) ||
+        static_cast<uint32_t>(Y) >= static_cast<uint32_t>(Height))
+      return 0.f;
+    return Buffers[Front].Density[IndexOf(X, Y)];
+  }
+
+  // Sum over every tile
+  double GetTotal() const;
+
+  bool IsEmpty() const {
+    return Buffers[Front].FirstRow > Buffers[Front].LastRow;
+  }
+  int32_t GetWidth() const { return Width; }
+  int32_t GetHeight() const { return Height; }
+
+private:
+  // A closed border column on the left and padding on the right let the
+  // kernel read neighbours and run whole groups of sixteen without bounds
+  // checks. Closed rows above and below do the same vertically.
+  size_t IndexOf(int32_t X, int32_t Y) const {
+    return (static_cast<size_t>(Y) + 1) * Stride + 1 +
+           static_cast<size_t>(X);
+  }
+
+  struct FBuffer {
+    std::vector<float> Density;
+    // Rows that may hold smoke; every other row is clear. Empty when
+    // FirstRow > LastRow.
+    int32_t FirstRow = 0;
+    int32_t LastRow = -1;
+  };
+
+  int32_t Width = 0;
+  int32_t Height = 0;
+  size_t Stride = 0;
+  FBuffer Buffers[2];
+  int32_t Front = 0;
+  // Open neighbours per tile, or Closed for walls and padding
+  std::vector<uint8_t> Neighbours;
+};
+
+} // namespace BangGuChaSim
@@ -0,0 +1,48 @@
+#include "BangGuChaSimTileHash.h"
+
+namespace BangGuChaSim {
+
+void FTileHash::Reset(float GridSize) {
+  InvGridSize = GridSize > 0.f ? 1.f / GridSize : 0.f;
+  Pending.clear();
+  Sorted.clear();
+}
+
+void FTileHash::Reserve(size_t Count) {
+  Pending.reserve(Count);
+  Sorted.reserve(Count);
+}
+
+void FTileHash::Add(float X, float Y) {
+  Pending.push_back(
+      FEntry{TileOf(X), TileOf(Y), static_cast<uint32_t>(Pending.size())});
+}
+
+void FTileHash::Build() {
+  // At least two buckets per point keeps the chains short
+  size_t NumBuckets = 2;
+  int32_t Bits = 1;
+  while (NumBuckets < Pending.size() * 2) {
+    NumBuckets <<= 1;
+    Bits++;
+  }
+  Shift = 64 - Bits;
+
+  // Counting sort: sizes land one slot to the right, the prefix sum turns
+  // them into starts, and scattering advances each start to the next
+  // bucket's, which the final shift puts back
+  BucketStart.assign(NumBuckets + 1, 0);
+  for (const FEntry &Entry : Pending)
+    BucketStart[BucketOf(Entry.TileX, Entry.TileY) + 1]++;
+  for (size_t Bucket = 1; Bucket <= NumBuckets; Bucket++)
+    BucketStart[Bucket] += BucketStart[Bucket - 1];
+
+  Sorted.resize(Pending.size());
+  for (const FEntry &Entry : Pending)
+    Sorted[BucketStart[BucketOf(Entry.TileX, Entry.TileY)]++] = Entry;
+  for (size_t Bucket = NumBuckets; Bucket > 0; Bucket--)
+    BucketStart[Bucket] = BucketStart[Bucket - 1];
+  BucketStart[0] = 0;
+}
+
+} // namespace BangGuChaSim
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+// Trigger test on the XY plane: centers closer than Reach on both axes
+inline bool Overlaps(float AX, float AY, float BX, float BY, float Reach) {
+  return std::fabs(AX - BX) < Reach && std::fabs(AY - BY) < Reach;
+}
+
+/**
+ * Points bucketed by the tile their center lies on, for overlap queries
+ * that should only look at neighbouring tiles. Buckets are a hash of the
+ * tile, sized to the point count rather than the map, and Build sorts the
+ * points into them with one counting pass.
+ *
+ * Rebuilding with no more points than before does not allocate.
+ */
+class FTileHash {
+public:
+  // Starts over with no points. Points are numbered in the order they are
+  // added.
+  void Reset(float GridSize);
+  void Reserve(size_t Count);
+  void Add(float X, float Y);
+
+  // Sorts the points added since Reset into their buckets; queries see
+  // nothing before this
+  void Build();
+
+  size_t Num() const { return Pending.size(); }
+
+  // Calls Visit(Index) once for every point on a tile that a box of
+  // half-extent Reach around (X, Y) touches. Callers do the exact test.
+  template <typename VisitFn>
+  void ForEachNear(float X, float Y, float Reach, VisitFn &&Visit) const {
+    if (Sorted.empty())
+      return;
+    // The slack keeps float rounding at a tile edge from dropping a tile
+    constexpr float Slack = 1.f / 64;
+    const int32_t X0 = TileOf(X - Reach, -Slack);
+    const int32_t X1 = TileOf(X + Reach, Slack);
+    const int32_t Y0 = TileOf(Y - Reach, -Slack);
+    const int32_t Y1 = TileOf(Y + Reach, Slack);
+    for (int32_t TileY = Y0; TileY <= Y1; TileY++) {
+      for (int32_t TileX = X0; TileX <= X1; TileX++) {
+        const uint32_t Bucket = BucketOf(TileX, TileY);
+        // Tiles sharing a bucket are told apart here, so no point is
+        // visited twice
+        for (uint32_t At = BucketStart[Bucket]; At < BucketStart[Bucket + 1];
+             At++) {
+          const FEntry &Entry = Sorted[At];
+          if (Entry.TileX == TileX && Entry.TileY == TileY)
+            Visit(Entry.Index);
+        }
+      }
+    }
+  }
+
+private:
+  struct FEntry {
+    int32_t TileX;
+    int32_t TileY;
+    uint32_t Index;
+  };
+
+  int32_t TileOf(float Coord, float Bias = 0.f) const {
+    return static_cast<int32_t>(std::floor(Coord * InvGridSize + 0.5f + Bias));
+  }
+
+  uint32_t BucketOf(int32_t TileX, int32_t TileY) const {
+    const uint64_t Key = (static_cast<uint64_t>(static_cast<uint32_t>(TileX))
+                          << 32) |
+                         static_cast<uint32_t>(TileY);
+    return static_cast<uint32_t>((Key * 0x9e3779b97f4a7c15ULL) >> Shift);
+  }
+
+  float InvGridSize = 0.01f;
+  int32_t Shift = 63;
+
+  // Insertion order, then bucket order
+  std::vector<FEntry> Pending;
+  std::vector<FEntry> Sorted;
+  // One past the last bucket holds the total
+  std::vector<uint32_t> BucketStart;
+};
+
+} // namespace BangGuChaSim
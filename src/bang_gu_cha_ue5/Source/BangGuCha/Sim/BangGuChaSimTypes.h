@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Engine-independent game rules for BangGuCha.
+ *
+ * Everything under Sim/ is plain C++17 with no Unreal headers so the same
+ * sources compile into the game module and into the standalone CMake build
+ * used for headless simulation.
+ */
+namespace BangGuChaSim {
+
+// Values match the direction codes stored by FFlowField.
+enum class EDirection : uint8_t { None = 0, PosX, NegX, PosY, NegY };
+
+constexpr int32_t DirectionX[5] = {0, 1, -1, 0, 0};
+constexpr int32_t DirectionY[5] = {0, 0, 0, 1, -1};
+
+constexpr int32_t StepX(EDirection Dir) {
+  return DirectionX[static_cast<uint8_t>(Dir)];
+}
+constexpr int32_t StepY(EDirection Dir) {
+  return DirectionY[static_cast<uint8_t>(Dir)];
+}
+
+constexpr EDirection Opposite(EDirection Dir) {
+  return Dir == EDirection::PosX   ? EDirection::NegX
+         : Dir == EDirection::NegX ? EDirection::PosX
+         : Dir == EDirection::PosY ? EDirection::NegY
+         : Dir == EDirection::NegY ? EDirection::PosY
+                                   : EDirection::None;
+}
+
+// Unit step (-1, 0, 1 per axis) to direction; anything diagonal is None.
+constexpr EDirection DirectionFromStep(int32_t X, int32_t Y) {
+  return (X > 0 && Y == 0)   ? EDirection::PosX
+         : (X < 0 && Y == 0) ? EDirection::NegX
+         : (Y > 0 && X == 0) ? EDirection::PosY
+         : (Y < 0 && X == 0) ? EDirection::NegY
+                             : EDirection::None;
+}
+
+struct FTile {
+  int32_t X = 0;
+  int32_t Y = 0;
+
+  friend bool operator==(const FTile &A, const FTile &B) {
+    return A.X == B.X && A.Y == B.Y;
+  }
+  friend bool operator!=(const FTile &A, const FTile &B) { return !(A == B); }
+};
+
+} // namespace BangGuChaSim
@@ -0,0 +1,270 @@
+#include "BangGuChaSimWorld.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace BangGuChaSim {
+
+namespace {
+
+uint64_t HashCombine(uint64_t Hash, uint64_t Value) {
+  return (Hash ^ Value) * 0x100000001b3ULL;
+}
+
+uint64_t HashFloat(uint64_t Hash, float Value) {
+  uint32_t Bits;
+  std::memcpy(&Bits, &Value, sizeof(Bits));
+  return HashCombine(Hash, Bits);
+}
+
+} // namespace
+
+void FSimWorld::Reset(const FSimConfig &InConfig, uint64_t Seed) {
+  Config = InConfig;
+  Rng.Reseed(Seed);
+
+  GenerateLayout(Config.Map, Rng, Layout);
+  FlowField.Init(&Layout.Walls);
+  Graph.Reset();
+  Hierarchical.Reset();
+  if (Config.Pathing == EPathing::JunctionGraph)
+    Graph.Build(Layout.Walls);
+  else if (Config.Pathing == EPathing::Hierarchical)
+    Hierarchical.Build(&Layout.Walls, Config.PathClusterSize);
+
+  if (Config.SmokeModel == ESmokeModel::Field)
+    SmokeField.Init(Layout.Walls);
+  else
+    SmokeField.Reset();
+  // Fuel only runs down, so this many clouds is the most there can be and
+  // spawning one never allocates
+  Smokes.clear();
+  Smokes.reserve(static_cast<size_t>(Config.MaxFuel / FartFuelCost) + 1);
+  // A player box at the default reach touches at most four flag tiles
+  FlagHits.reserve(4);
+
+  StartMatch();
+}
+
+void FSimWorld::Restart() { StartMatch(); }
+
+void FSimWorld::StartMatch() {
+  InitMover(Player.Mover, Layout.PlayerStart.X * Config.GridSize,
+            Layout.PlayerStart.Y * Config.GridSize, Config.GridSize);
+  Player.Fuel = Config.MaxFuel;
+
+  Enemies.Reset();
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Enemies.Add(Spawn, Config.GridSize);
+
+  Smokes.clear();
+  SmokeField.Clear();
+  NewSmokeTile = FTile{-1, -1};
+  Flags = Layout.Flags;
+  bFlagHashDirty = true;
+
+  State = EMatchState::Running;
+  Score = 0;
+  TotalFlags = static_cast<int32_t>(Flags.size());
+  CollectedFlags = 0;
+  StepCount = 0;
+}
+
+EMatchState FSimWorld::Step(const FSimInput &Input) {
+  if (State != EMatchState::Running)
+    return State;
+
+  StepSmokes();
+
+  // Clouds from this step are appended after the survivors
+  const size_t FirstNewSmoke = Smokes.size();
+  StepPlayer(Input);
+
+  const FTile PlayerTile =
+      WorldToTile(Player.Mover.X, Player.Mover.Y, Config.GridSize);
+  switch (Config.Pathing) {
+  case EPathing::JunctionGraph:
+    Graph.SetGoal(PlayerTile);
+    break;
+  case EPathing::Hierarchical:
+    Hierarchical.SetGoal(PlayerTile);
+    Enemies.PreparePaths(Config.FixedDeltaTime, GetEnemyParams(),
+                         Hierarchical);
+    break;
+  default:
+    FlowField.SetGoal(PlayerTile);
+    FlowField.Update(std::numeric_limits<int32_t>::max());
+    break;
+  }
+
+  StepEnemies();
+  ResolveOverlaps(FirstNewSmoke);
+
+  StepCount++;
+  return State;
+}
+
+void FSimWorld::StepPlayer(const FSimInput &Input) {
+  const float DeltaTime = Config.FixedDeltaTime;
+
+  if (Input.Move != EDirection::None)
+    Player.Mover.NextDirection = Input.Move;
+
+  NewSmokeTile = FTile{-1, -1};
+  if (Input.bFart && TrySpendFartFuel(Player.Fuel)) {
+    if (Config.SmokeModel == ESmokeModel::Field) {
+      NewSmokeTile =
+          WorldToTile(Player.Mover.X, Player.Mover.Y, Config.GridSize);
+      SmokeField.Deposit(NewSmokeTile.X, NewSmokeTile.Y, Config.SmokeAmount);
+    } else {
+      Smokes.push_back(
+          FSimSmoke{Player.Mover.X, Player.Mover.Y, Config.SmokeLifeSpan});
+    }
+  }
+
+  StepPlayerMover(Player.Mover, DeltaTime, Config.PlayerMoveSpeed,
+                  Config.GridSize,
+                  [this](int32_t X, int32_t Y) { return CanEnter(X, Y); });
+
+  if (Player.Mover.Direction != EDirection::None)
+    ConsumeFuel(Player.Fuel, Config.FuelConsumptionRate, DeltaTime);
+}
+
+FEnemySwarmParams FSimWorld::GetEnemyParams() const {
+  FEnemySwarmParams Params;
+  Params.MoveSpeed = Config.EnemyMoveSpeed;
+  Params.GridSize = Config.GridSize;
+  return Params;
+}
+
+void FSimWorld::StepEnemies() {
+  Enemies.Advance(Config.FixedDeltaTime, GetEnemyParams(), Player.Mover.X,
+                  Player.Mover.Y, Layout.Walls, &FlowField,
+                  Config.Pathing == EPathing::JunctionGraph ? &Graph : nullptr,
+                  Config.Pathing == EPathing::Hierarchical ? &Hierarchical
+                                                           : nullptr);
+}
+
+void FSimWorld::StepSmokes() {
+  const float DeltaTime = Config.FixedDeltaTime;
+
+  if (Config.SmokeModel == ESmokeModel::Field) {
+    SmokeField.Step(DeltaTime, Config.SmokeSpreadRate, Config.SmokeFadeRate);
+    return;
+  }
+
+  // Order-preserving compaction keeps runs deterministic
+  size_t Kept = 0;
+  for (size_t i = 0; i < Smokes.size(); i++) {
+    if (TickLifetime(Smokes[i].Remaining, DeltaTime))
+      Smokes[Kept++] = Smokes[i];
+  }
+  Smokes.resize(Kept);
+}
+
+void FSimWorld::ResolveOverlaps(size_t FirstNewSmoke) {
+  const float PlayerX = Player.Mover.X;
+  const float PlayerY = Player.Mover.Y;
+
+  // Flag pickup
+  const float FlagReach = Config.PlayerExtent + Config.FlagRadius;
+  if (bFlagHashDirty) {
+    FlagHash.Reset(Config.GridSize);
+    for (const FTile &Flag : Flags)
+      FlagHash.Add(Flag.X * Config.GridSize, Flag.Y * Config.GridSize);
+    FlagHash.Build();
+    bFlagHashDirty = false;
+  }
+  FlagHits.clear();
+  FlagHash.ForEachNear(PlayerX, PlayerY, FlagReach, [&](uint32_t i) {
+    if (Overlaps(PlayerX, PlayerY, Flags[i].X * Config.GridSize,
+                 Flags[i].Y * Config.GridSize, FlagReach))
+      FlagHits.push_back(i);
+  });
+  if (!FlagHits.empty()) {
+    // Back to front, so the indices still to go stay valid
+    std::sort(FlagHits.begin(), FlagHits.end());
+    for (auto It = FlagHits.rbegin(); It != FlagHits.rend(); ++It)
+      Flags.erase(Flags.begin() + static_cast<std::ptrdiff_t>(*It));
+    bFlagHashDirty = true;
+    for (size_t Hit = 0; Hit < FlagHits.size(); Hit++) {
+      CollectFlag(Score, CollectedFlags);
+      if (HasCollectedAllFlags(CollectedFlags, TotalFlags)) {
+        State = EMatchState::Won;
+        return;
+      }
+    }
+  }
+
+  // Smoke stuns an enemy when it walks in, or when a new cloud lands on it.
+  // Fuel caps the clouds at a handful, so scanning them beats a hash probe.
+  const float SmokeReach = Config.SmokeExtent + Config.EnemyExtent;
+  const bool bSmokeField = Config.SmokeModel == ESmokeModel::Field;
+  for (size_t e = 0; e < Enemies.Num(); e++) {
+    bool bInSmoke = false;
+    bool bHitByNewSmoke = false;
+    if (bSmokeField && !SmokeField.IsEmpty()) {
+      // The field is read at the enemy's tile only
+      const FTile Tile =
+          WorldToTile(Enemies.X[e], Enemies.Y[e], Config.GridSize);
+      bInSmoke =
+          SmokeField.GetDensity(Tile.X, Tile.Y) >= Config.SmokeStunDensity;
+      bHitByNewSmoke = Tile == NewSmokeTile;
+    }
+    for (size_t i = 0; i < Smokes.size(); i++) {
+      if (Overlaps(Enemies.X[e], Enemies.Y[e], Smokes[i].X, Smokes[i].Y,
+                   SmokeReach)) {
+        bInSmoke = true;
+        bHitByNewSmoke |= i >= FirstNewSmoke;
+      }
+    }
+    if ((bInSmoke && !Enemies.bInSmoke[e]) || bHitByNewSmoke)
+      Enemies.Stun(e, Config.StunDuration);
+    Enemies.bInSmoke[e] = bInSmoke;
+  }
+
+  // Enemy catching the player; stunned enemies are harmless
+  const float CatchReach = Config.EnemyExtent + Config.PlayerExtent;
+  for (size_t e = 0; e < Enemies.Num(); e++) {
+    const bool bTouching =
+        Overlaps(Enemies.X[e], Enemies.Y[e], PlayerX, PlayerY, CatchReach);
+    const bool bBeginOverlap = bTouching && !Enemies.TouchingPlayers[e];
+    Enemies.TouchingPlayers[e] = bTouching;
+    if (bBeginOverlap && !Enemies.bIsStunned[e]) {
+      State = EMatchState::Lost;
+      return;
+    }
+  }
+}
+
+uint64_t FSimWorld::HashState() const {
+  uint64_t Hash = 0xcbf29ce484222325ULL;
+  auto HashMover = [&Hash](const FMover &Mover) {
+    Hash = HashFloat(Hash, Mover.X);
+    Hash = HashFloat(Hash, Mover.Y);
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Mover.Target.X));
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Mover.Target.Y));
+    Hash = HashCombine(Hash, static_cast<uint8_t>(Mover.Direction));
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Mover.Remaining));
+  };
+
+  HashMover(Player.Mover);
+  Hash = HashFloat(Hash, Player.Fuel);
+  for (size_t e = 0; e < Enemies.Num(); e++) {
+    Hash = HashFloat(Hash, Enemies.X[e]);
+    Hash = HashFloat(Hash, Enemies.Y[e]);
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Enemies.TargetX[e]));
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Enemies.TargetY[e]));
+    Hash = HashCombine(Hash, static_cast<uint8_t>(Enemies.Direction[e]));
+    Hash = HashCombine(Hash, static_cast<uint32_t>(Enemies.Remaining[e]));
+    Hash = HashCombine(Hash, Enemies.bIsStunned[e]);
+    Hash = HashFloat(Hash, Enemies.StunTimer[e]);
+  }
+  Hash = HashCombine(Hash, Smokes.size());
+  Hash = HashCombine(Hash, static_cast<uint32_t>(Score));
+  Hash = HashCombine(Hash, static_cast<uint8_t>(State));
+  return HashCombine(Hash, StepCount);
+}
+
+} // namespace BangGuChaSim
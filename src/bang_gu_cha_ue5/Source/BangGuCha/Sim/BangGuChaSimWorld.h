@@ -0,0 +1,168 @@
+#pragma once
+
+#include "BangGuChaSimEnemySwarm.h"
+#include "BangGuChaSimFlowField.h"
+#include "BangGuChaSimHierarchicalPath.h"
+#include "BangGuChaSimJunctionGraph.h"
+#include "BangGuChaSimMapGen.h"
+#include "BangGuChaSimRules.h"
+#include "BangGuChaSimSmokeField.h"
+#include "BangGuChaSimTileHash.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace BangGuChaSim {
+
+// Where enemies get their chase directions from
+enum class EPathing : uint8_t {
+  // Breadth-first field over every tile, rebuilt when the player moves
+  FlowField,
+  // Junctions and corridors, with cached shortest-path trees
+  JunctionGraph,
+  // Clusters and their entrances (HPA*), for very large maps
+  Hierarchical
+};
+
+// How farts turn into smoke
+enum class ESmokeModel : uint8_t {
+  // A fixed box per cloud for SmokeLifeSpan seconds
+  Clouds,
+  // Density on an FSmokeField that spreads through open tiles and fades
+  Field
+};
+
+/** Tunables for one headless match; defaults mirror the actor defaults. */
+struct FSimConfig {
+  FMapParams Map;
+  float GridSize = 100.f;
+  float FixedDeltaTime = 1.f / 60.f;
+
+  float PlayerMoveSpeed = 300.f;
+  float MaxFuel = 100.f;
+  float FuelConsumptionRate = 5.f;
+
+  float EnemyMoveSpeed = 200.f;
+  float StunDuration = 3.f;
+  EPathing Pathing = EPathing::JunctionGraph;
+  int32_t PathClusterSize = 16;
+
+  ESmokeModel SmokeModel = ESmokeModel::Clouds;
+  float SmokeLifeSpan = 2.f;
+  // Field only: density one fart adds to the player's tile, how fast it
+  // spreads and fades per second, and the density at which enemies stun
+  float SmokeAmount = 1.f;
+  float SmokeSpreadRate = 0.5f;
+  float SmokeFadeRate = 0.5f;
+  float SmokeStunDensity = 0.1f;
+
+  // Collision half-extents on the XY plane, as set up on the actors
+  float PlayerExtent = 40.f;
+  float EnemyExtent = 40.f;
+  float FlagRadius = 30.f;
+  float SmokeExtent = 45.f;
+};
+
+enum class EMatchState : uint8_t { Running, Won, Lost };
+
+/** Player commands for a single step (pressed this step). */
+struct FSimInput {
+  EDirection Move = EDirection::None;
+  bool bFart = false;
+};
+
+struct FSimPlayer {
+  FMover Mover;
+  float Fuel = 0.f;
+};
+
+struct FSimSmoke {
+  float X = 0.f;
+  float Y = 0.f;
+  float Remaining = 0.f;
+};
+
+/**
+ * Deterministic headless match. Each Step advances exactly
+ * Config.FixedDeltaTime, and the seed fully determines the map, so the same
+ * seed and input sequence always produce the same result.
+ */
+class FSimWorld {
+public:
+  FSimWorld() = default;
+  // The flow field and hierarchical path point into Layout, so worlds are
+  // not copied
+  FSimWorld(const FSimWorld &) = delete;
+  FSimWorld &operator=(const FSimWorld &) = delete;
+
+  void Reset(const FSimConfig &InConfig, uint64_t Seed);
+  // Starts the match over on the current layout. Plays out exactly like a
+  // Reset with the same config and seed, but generates and builds nothing
+  // and reuses every buffer, so it does not allocate.
+  void Restart();
+
+  EMatchState Step(const FSimInput &Input);
+
+  const FSimConfig &GetConfig() const { return Config; }
+  const FMapLayout &GetLayout() const { return Layout; }
+  const FFlowField &GetFlowField() const { return FlowField; }
+  const FJunctionGraph &GetJunctionGraph() const { return Graph; }
+  const FHierarchicalPath &GetHierarchicalPath() const { return Hierarchical; }
+  const FSimPlayer &GetPlayer() const { return Player; }
+  const FEnemySwarm &GetEnemies() const { return Enemies; }
+  const std::vector<FSimSmoke> &GetSmokes() const { return Smokes; }
+  const FSmokeField &GetSmokeField() const { return SmokeField; }
+  const std::vector<FTile> &GetRemainingFlags() const { return Flags; }
+
+  EMatchState GetState() const { return State; }
+  int32_t GetScore() const { return Score; }
+  int32_t GetTotalFlags() const { return TotalFlags; }
+  int32_t GetCollectedFlags() const { return CollectedFlags; }
+  uint64_t GetStepCount() const { return StepCount; }
+  float GetElapsedTime() const {
+    return static_cast<float>(StepCount) * Config.FixedDeltaTime;
+  }
+
+  // Digest of the dynamic state, for replay and regression comparisons
+  uint64_t HashState() const;
+
+private:
+  bool CanEnter(int32_t X, int32_t Y) const {
+    return Layout.Walls.IsWalkable(X, Y);
+  }
+
+  void StartMatch();
+  void StepSmokes();
+  void StepPlayer(const FSimInput &Input);
+  FEnemySwarmParams GetEnemyParams() const;
+  void StepEnemies();
+  void ResolveOverlaps(size_t FirstNewSmoke);
+
+  FSimConfig Config;
+  FRandom Rng;
+  FMapLayout Layout;
+  FFlowField FlowField;
+  FJunctionGraph Graph;
+  FHierarchicalPath Hierarchical;
+
+  FSimPlayer Player;
+  FEnemySwarm Enemies;
+  std::vector<FSimSmoke> Smokes;
+  FSmokeField SmokeField;
+  // Tile the field took a fart on this step, if any
+  FTile NewSmokeTile{-1, -1};
+  std::vector<FTile> Flags;
+
+  // Remaining flags by tile, rebuilt only after a pickup
+  FTileHash FlagHash;
+  std::vector<uint32_t> FlagHits;
+  bool bFlagHashDirty = true;
+
+  EMatchState State = EMatchState::Running;
+  int32_t Score = 0;
+  int32_t TotalFlags = 0;
+  int32_t CollectedFlags = 0;
+  uint64_t StepCount = 0;
+};
+
+} // namespace BangGuChaSim
@@ -0,0 +1,201 @@
+// Replication bandwidth gate. Starts a listen server plus two clients in one
+// editor process (PIE), generates a level with 100 enemies and checks that
+// no client connection averages more than BandwidthBudget outgoing bytes
+// per second from the server.
+//
+// Runs with:
+//   UnrealEditor-Cmd BangGuCha.uproject -nullrhi -nosound -unattended
+//     -ExecCmds="Automation RunTests BangGuCha.Net; Quit"
+//
+// Optional switch: -BangGuChaNetSeconds=N (default 10).
+
+#include "BangGuChaEnemy.h"
+#include "BangGuChaGameModeBase.h"
+#include "BangGuChaItem.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaWall.h"
+#include "Editor.h"
+#include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Settings/LevelEditorPlaySettings.h"
+#include "Tests/AutomationCommon.h"
+#include "Tests/AutomationEditorCommon.h"
+
+#if WITH_EDITOR && WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+constexpr int32 NetClients = 2;
+constexpr double BandwidthBudget = 2048.0;
+// Two regular spawns plus the swarm
+constexpr int32 NetSwarmEnemies = 98;
+// Give up if PIE has not connected every client after this long
+constexpr double ConnectTimeoutSeconds = 60.0;
+// Skip the spawn burst that opens every actor channel
+constexpr double WarmupSeconds = 3.0;
+
+UWorld *FindServerWorld() {
+  for (const FWorldContext &Context : GEngine->GetWorldContexts()) {
+    UWorld *World = Context.World();
+    if (Context.WorldType == EWorldType::PIE && World &&
+        World->GetNetMode() == NM_ListenServer) {
+      return World;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Waits for every client to connect and the level to finish generating,
+ * then samples each client connection's outgoing rate once a second. The
+ * net driver updates OutBytesPerSecond once a second, so sampling faster
+ * only repeats values.
+ */
+class FBangGuChaNetMeasureCommand : public IAutomationLatentCommand {
+public:
+  FBangGuChaNetMeasureCommand(FAutomationTestBase *InTest, float InSeconds)
+      : Test(InTest), Seconds(InSeconds) {}
+
+  virtual bool Update() override {
+    const double Now = FPlatformTime::Seconds();
+    if (StartTime == 0.0) {
+      StartTime = Now;
+    }
+
+    UWorld *World = FindServerWorld();
+    UNetDriver *Driver = World ? World->GetNetDriver() : nullptr;
+    const ABangGuChaMapGenerator *Map =
+        World ? ABangGuChaMapGenerator::Get(World) : nullptr;
+    const bool bReady = Driver && Map && !Map->IsGenerating() &&
+                        Driver->ClientConnections.Num() >= NetClients;
+
+    if (ReadyTime == 0.0) {
+      if (!bReady) {
+        if (Now - StartTime > ConnectTimeoutSeconds) {
+          Test->AddError(TEXT("Timed out waiting for PIE clients"));
+          return Finish();
+        }
+        return false;
+      }
+      ReadyTime = Now;
+      LastSampleTime = Now;
+    }
+
+    if (!bReady) {
+      Test->AddError(TEXT("Lost the listen server or a client"));
+      return Finish();
+    }
+
+    if (Now - LastSampleTime >= 1.0) {
+      LastSampleTime = Now;
+      if (Now - ReadyTime >= WarmupSeconds) {
+        for (const UNetConnection *Connection : Driver->ClientConnections) {
+          Samples.FindOrAdd(Connection->GetName())
+              .Add(Connection->OutBytesPerSecond);
+        }
+      }
+    }
+
+    if (Now - ReadyTime < WarmupSeconds + Seconds)
+      return false;
+
+    Report();
+    return Finish();
+  }
+
+private:
+  void Report() {
+    if (Samples.Num() == 0) {
+      Test->AddError(TEXT("No bandwidth samples were taken"));
+      return;
+    }
+    for (const TPair<FString, TArray<int32>> &Client : Samples) {
+      int64 Total = 0;
+      int32 Peak = 0;
+      for (const int32 Bytes : Client.Value) {
+        Total += Bytes;
+        Peak = FMath::Max(Peak, Bytes);
+      }
+      const double Average = double(Total) / FMath::Max(1, Client.Value.Num());
+      Test->AddInfo(FString::Printf(
+          TEXT("%s: average %.0f B/s, peak %d B/s over %d s"), *Client.Key,
+          Average, Peak, Client.Value.Num()));
+      if (Average > BandwidthBudget) {
+        Test->AddError(
+            FString::Printf(TEXT("%s: average %.0f B/s exceeds %.0f B/s"),
+                            *Client.Key, Average, BandwidthBudget));
+      }
+    }
+  }
+
+  bool Finish() {
+    GEditor->RequestEndPlayMap();
+    return true;
+  }
+
+  FAutomationTestBase *Test;
+  float Seconds;
+
+  double StartTime = 0.0;
+  double ReadyTime = 0.0;
+  double LastSampleTime = 0.0;
+  TMap<FString, TArray<int32>> Samples;
+};
+
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBangGuChaNetBandwidthTest,
+                                 "BangGuCha.Net.Bandwidth",
+                                 EAutomationTestFlags::EditorContext |
+                                     EAutomationTestFlags::PerfFilter)
+
+bool FBangGuChaNetBandwidthTest::RunTest(const FString &Parameters) {
+  float Seconds = 10.f;
+  FParse::Value(FCommandLine::Get(), TEXT("BangGuChaNetSeconds="), Seconds);
+
+  UWorld *World = FAutomationEditorCommonUtils::CreateNewMap();
+  if (!World) {
+    AddError(TEXT("Could not create an empty editor map"));
+    return false;
+  }
+  World->GetWorldSettings()->DefaultGameMode =
+      ABangGuChaGameModeBase::StaticClass();
+
+  // Placed in the editor map so every PIE world loads the same generator;
+  // the server's seed then reaches the clients through replication
+  ABangGuChaMapGenerator *Generator =
+      World->SpawnActor<ABangGuChaMapGenerator>();
+  Generator->MapWidth = 64;
+  Generator->MapHeight = 64;
+  Generator->MapStyle = EBangGuChaMapStyle::Braided;
+  Generator->WallMode = EBangGuChaWallMode::Instanced;
+  Generator->SwarmEnemyCount = NetSwarmEnemies;
+  Generator->Seed = 12345;
+  Generator->WallClass = ABangGuChaWall::StaticClass();
+  Generator->ItemClass = ABangGuChaItem::StaticClass();
+  Generator->EnemyClass = ABangGuChaEnemy::StaticClass();
+
+  ULevelEditorPlaySettings *PlaySettings =
+      NewObject<ULevelEditorPlaySettings>();
+  PlaySettings->SetPlayNetMode(EPlayNetMode::PIE_ListenServer);
+  // The listen server's own player counts as one
+  PlaySettings->SetPlayNumberOfClients(NetClients + 1);
+  PlaySettings->SetRunUnderOneProcess(true);
+  PlaySettings->bLaunchSeparateServer = false;
+
+  FRequestPlaySessionParams Params;
+  Params.WorldType = EPlaySessionWorldType::PlayInEditor;
+  Params.EditorPlaySettings = PlaySettings;
+  GEditor->RequestPlaySession(Params);
+
+  ADD_LATENT_AUTOMATION_COMMAND(
+      FBangGuChaNetMeasureCommand(this, FMath::Max(Seconds, 1.f)));
+  return true;
+}
+
+#endif
@@ -0,0 +1,383 @@
+// Headless performance gates. Each case boots the BangGuCha game mode on an
+// empty map, generates a level through ABangGuChaMapGenerator, drives the
+// pawn with a scripted input sequence and compares frame time percentiles,
+// actor counts and memory against Tests/BangGuChaPerfBaselines.csv.
+//
+// Runs on CPU-only agents with:
+//   UnrealEditor-Cmd BangGuCha.uproject -game -nullrhi -nosound -unattended
+//     -ExecCmds="Automation RunTests BangGuCha.Perf; Quit"
+//
+// Optional switches: -BangGuChaPerfSeconds=N (default 20) and
+// -BangGuChaPerfBaselines=<csv>. Every run appends its measurements, in the
+// baseline format, to Saved/Automation/BangGuChaPerfResults.csv.
+
+#include "BangGuChaEnemy.h"
+#include "BangGuChaGameModeBase.h"
+#include "BangGuChaItem.h"
+#include "BangGuChaMapGenerator.h"
+#include "BangGuChaPawn.h"
+#include "BangGuChaSmoke.h"
+#include "BangGuChaWall.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+// Entry is an empty engine map; the game mode comes from the URL
+const TCHAR *PerfMapUrl =
+    TEXT("/Engine/Maps/Entry?game=/Script/BangGuCha.BangGuChaGameModeBase");
+
+// Give up if a chunked map is still streaming after this long
+constexpr double GenerateTimeoutSeconds = 60.0;
+
+struct FBangGuChaPerfCase {
+  const TCHAR *Name;
+  int32 Width;
+  int32 Height;
+  EBangGuChaMapStyle Style;
+  EBangGuChaWallMode WallMode;
+  bool bChunked;
+  bool bEnemyManager;
+  int32 SwarmEnemies;
+};
+
+const FBangGuChaPerfCase PerfCases[] = {
+    {TEXT("Small"), 20, 15, EBangGuChaMapStyle::Scatter,
+     EBangGuChaWallMode::Actors, false, false, 0},
+    {TEXT("Maze128"), 128, 128, EBangGuChaMapStyle::Braided,
+     EBangGuChaWallMode::Instanced, false, false, 32},
+    {TEXT("Swarm256"), 256, 256, EBangGuChaMapStyle::Braided,
+     EBangGuChaWallMode::Instanced, true, true, 512},
+};
+
+// One row of the baseline file; measured values must not exceed it
+struct FBangGuChaPerfRow {
+  double GenerateMs = 0.0;
+  double FrameP50Ms = 0.0;
+  double FrameP95Ms = 0.0;
+  double FrameP99Ms = 0.0;
+  int32 PeakActors = 0;
+  double PeakMemoryMB = 0.0;
+};
+
+const TCHAR *PerfCsvHeader =
+    TEXT("case,generate_ms,frame_p50_ms,frame_p95_ms,frame_p99_ms,")
+        TEXT("peak_actors,peak_memory_mb");
+
+FString BaselinePath() {
+  FString Path;
+  if (FParse::Value(FCommandLine::Get(), TEXT("BangGuChaPerfBaselines="),
+                    Path)) {
+    return Path;
+  }
+  return FPaths::Combine(FPaths::ProjectDir(), TEXT("Tests"),
+                         TEXT("BangGuChaPerfBaselines.csv"));
+}
+
+bool LoadBaseline(const FString &CaseName, FBangGuChaPerfRow &Out) {
+  TArray<FString> Lines;
+  if (!FFileHelper::LoadFileToStringArray(Lines, *BaselinePath()))
+    return false;
+
+  for (const FString &Line : Lines) {
+    TArray<FString> Fields;
+    Line.ParseIntoArray(Fields, TEXT(","));
+    if (Fields.Num() != 7 || Fields[0] != CaseName)
+      continue;
+    Out.GenerateMs = FCString::Atod(*Fields[1]);
+    Out.FrameP50Ms = FCString::Atod(*Fields[2]);
+    Out.FrameP95Ms = FCString::Atod(*Fields[3]);
+    Out.FrameP99Ms = FCString::Atod(*Fields[4]);
+    Out.PeakActors = FCString::Atoi(*Fields[5]);
+    Out.PeakMemoryMB = FCString::Atod(*Fields[6]);
+    return true;
+  }
+  return false;
+}
+
+void AppendResult(const FString &CaseName, const FBangGuChaPerfRow &Row) {
+  const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(),
+                                       TEXT("Automation"),
+                                       TEXT("BangGuChaPerfResults.csv"));
+  FString Text;
+  if (!IFileManager::Get().FileExists(*Path)) {
+    Text = FString(PerfCsvHeader) + LINE_TERMINATOR;
+  }
+  Text += FString::Printf(TEXT("%s,%.2f,%.3f,%.3f,%.3f,%d,%.1f"), *CaseName,
+                          Row.GenerateMs, Row.FrameP50Ms, Row.FrameP95Ms,
+                          Row.FrameP99Ms, Row.PeakActors, Row.PeakMemoryMB);
+  Text += LINE_TERMINATOR;
+  FFileHelper::SaveStringToFile(Text, *Path,
+                                FFileHelper::EEncodingOptions::ForceAnsi,
+                                &IFileManager::Get(), FILEWRITE_Append);
+}
+
+// Nearest-rank percentile of an ascending array
+double Percentile(const TArray<double> &Sorted, double Fraction) {
+  if (Sorted.Num() == 0)
+    return 0.0;
+  const int32 Rank = FMath::CeilToInt(Fraction * Sorted.Num()) - 1;
+  return Sorted[FMath::Clamp(Rank, 0, Sorted.Num() - 1)];
+}
+
+double UsedMemoryMB() {
+  return double(FPlatformMemory::GetStats().UsedPhysical) / (1024.0 * 1024.0);
+}
+
+UWorld *FindGameWorld() {
+  for (const FWorldContext &Context : GEngine->GetWorldContexts()) {
+    if (Context.WorldType == EWorldType::Game && Context.World()) {
+      return Context.World();
+    }
+  }
+  return nullptr;
+}
+
+// Same script as the sim regression tests: turn every half second, fart
+// every two seconds
+constexpr float TurnInterval = 0.5f;
+constexpr float FartInterval = 2.f;
+const BangGuChaSim::EDirection ScriptedTurns[4] = {
+    BangGuChaSim::EDirection::PosY, BangGuChaSim::EDirection::PosX,
+    BangGuChaSim::EDirection::NegY, BangGuChaSim::EDirection::NegX};
+
+/**
+ * Spawns the generator, waits for the level to finish streaming, then
+ * plays for the requested time while sampling one game-thread frame per
+ * update. Frame time excludes the idle sleep a frame-rate cap inserts.
+ */
+class FBangGuChaPerfRunCommand : public IAutomationLatentCommand {
+public:
+  FBangGuChaPerfRunCommand(FAutomationTestBase *InTest,
+                           const FBangGuChaPerfCase &InCase, float InSeconds)
+      : Test(InTest), Case(InCase), Seconds(InSeconds) {}
+
+  virtual bool Update() override {
+    UWorld *World = FindGameWorld();
+    if (!World || !World->HasBegunPlay()) {
+      Test->AddError(TEXT("No game world to run the perf case in"));
+      return true;
+    }
+
+    switch (Phase) {
+    case EPhase::Setup:
+      return Setup(World);
+    case EPhase::Generating:
+      return WaitForMap(World);
+    case EPhase::Playing:
+      return Play(World);
+    }
+    return true;
+  }
+
+private:
+  enum class EPhase { Setup, Generating, Playing };
+
+  bool Setup(UWorld *World) {
+    if (!Cast<ABangGuChaGameModeBase>(World->GetAuthGameMode())) {
+      Test->AddError(TEXT("World is not running ABangGuChaGameModeBase"));
+      return true;
+    }
+
+    BaseMemoryMB = UsedMemoryMB();
+    PeakMemoryMB = BaseMemoryMB;
+    SetupTime = FPlatformTime::Seconds();
+
+    // Defaults are applied before BeginPlay, which is where GenerateMap runs
+    Generator = World->SpawnActorDeferred<ABangGuChaMapGenerator>(
+        ABangGuChaMapGenerator::StaticClass(), FTransform::Identity);
+    Generator->MapWidth = Case.Width;
+    Generator->MapHeight = Case.Height;
+    Generator->MapStyle = Case.Style;
+    Generator->WallMode = Case.WallMode;
+    Generator->bChunkedGeneration = Case.bChunked;
+    Generator->bUseEnemyManager = Case.bEnemyManager;
+    Generator->SwarmEnemyCount = Case.SwarmEnemies;
+    Generator->Seed = 12345;
+    // Time generation itself, not a cache hit left by an earlier run
+    Generator->bUseLevelCache = false;
+    Generator->WallClass = ABangGuChaWall::StaticClass();
+    Generator->ItemClass = ABangGuChaItem::StaticClass();
+    Generator->EnemyClass = ABangGuChaEnemy::StaticClass();
+    Generator->FinishSpawning(FTransform::Identity);
+
+    Phase = EPhase::Generating;
+    return false;
+  }
+
+  bool WaitForMap(UWorld *World) {
+    if (!IsValid(Generator)) {
+      Test->AddError(TEXT("Map generator was destroyed"));
+      return true;
+    }
+    PeakMemoryMB = FMath::Max(PeakMemoryMB, UsedMemoryMB());
+    if (Generator->IsGenerating()) {
+      if (FPlatformTime::Seconds() - SetupTime > GenerateTimeoutSeconds) {
+        Test->AddError(TEXT("Timed out waiting for the map to stream in"));
+        return true;
+      }
+      return false;
+    }
+    Result.GenerateMs = Generator->LastGenerateMs;
+
+    const BangGuChaSim::FTile Start = Generator->GetLayout().PlayerStart;
+    const FVector Location = Generator->TileToWorld(Start.X, Start.Y);
+    Pawn = World->SpawnActorDeferred<ABangGuChaPawn>(
+        ABangGuChaPawn::StaticClass(), FTransform(Location), nullptr, nullptr,
+        ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+    Pawn->SmokeClass = ABangGuChaSmoke::StaticClass();
+    Pawn->FinishSpawning(FTransform(Location));
+
+    if (APlayerController *Controller = World->GetFirstPlayerController()) {
+      APawn *DefaultPawn = Controller->GetPawn();
+      Controller->Possess(Pawn);
+      if (DefaultPawn && DefaultPawn != Pawn) {
+        DefaultPawn->Destroy();
+      }
+    }
+
+    PlayStartTime = World->GetTimeSeconds();
+    LastFrameTime = FPlatformTime::Seconds();
+    Phase = EPhase::Playing;
+    return false;
+  }
+
+  bool Play(UWorld *World) {
+    const double Now = FPlatformTime::Seconds();
+    const double FrameMs =
+        FMath::Max(0.0, Now - LastFrameTime - FApp::GetIdleTime()) * 1000.0;
+    LastFrameTime = Now;
+    FrameTimesMs.Add(FrameMs);
+    Result.PeakActors = FMath::Max(Result.PeakActors, World->GetActorCount());
+    PeakMemoryMB = FMath::Max(PeakMemoryMB, UsedMemoryMB());
+
+    const float Elapsed = float(World->GetTimeSeconds() - PlayStartTime);
+    if (IsValid(Pawn)) {
+      const int32 Turn = FMath::FloorToInt(Elapsed / TurnInterval);
+      if (Turn != LastTurn) {
+        Pawn->QueueTurn(ScriptedTurns[Turn % 4]);
+        LastTurn = Turn;
+      }
+      const int32 Fart = FMath::FloorToInt(Elapsed / FartInterval);
+      if (Fart != LastFart) {
+        Pawn->UseFart();
+        LastFart = Fart;
+      }
+    }
+
+    if (Elapsed < Seconds)
+      return false;
+
+    Report();
+    return true;
+  }
+
+  void Report() {
+    // The first frames after spawning include one-off work like pool and
+    // flow field warmup; they are not what the gate measures
+    const int32 Warmup = FMath::Min(10, FrameTimesMs.Num() / 10);
+    FrameTimesMs.RemoveAt(0, Warmup);
+    FrameTimesMs.Sort();
+    Result.FrameP50Ms = Percentile(FrameTimesMs, 0.50);
+    Result.FrameP95Ms = Percentile(FrameTimesMs, 0.95);
+    Result.FrameP99Ms = Percentile(FrameTimesMs, 0.99);
+    Result.PeakMemoryMB = FMath::Max(0.0, PeakMemoryMB - BaseMemoryMB);
+
+    const FString Name = Case.Name;
+    Test->AddInfo(FString::Printf(
+        TEXT("%s: generate %.2f ms, %d frames p50/p95/p99 %.3f/%.3f/%.3f ms, "
+             "peak actors %d, peak memory +%.1f MB"),
+        *Name, Result.GenerateMs, FrameTimesMs.Num(), Result.FrameP50Ms,
+        Result.FrameP95Ms, Result.FrameP99Ms, Result.PeakActors,
+        Result.PeakMemoryMB));
+    AppendResult(Name, Result);
+
+    FBangGuChaPerfRow Baseline;
+    if (!LoadBaseline(Name, Baseline)) {
+      Test->AddError(FString::Printf(TEXT("No baseline for %s in %s"), *Name,
+                                     *BaselinePath()));
+      return;
+    }
+
+    auto Check = [this, &Name](const TCHAR *What, double Value,
+                               double Limit) {
+      if (Value > Limit) {
+        Test->AddError(
+            FString::Printf(TEXT("%s: %s %.3f exceeds baseline %.3f"), *Name,
+                            What, Value, Limit));
+      }
+    };
+    Check(TEXT("generate_ms"), Result.GenerateMs, Baseline.GenerateMs);
+    Check(TEXT("frame_p50_ms"), Result.FrameP50Ms, Baseline.FrameP50Ms);
+    Check(TEXT("frame_p95_ms"), Result.FrameP95Ms, Baseline.FrameP95Ms);
+    Check(TEXT("frame_p99_ms"), Result.FrameP99Ms, Baseline.FrameP99Ms);
+    Check(TEXT("peak_actors"), Result.PeakActors, Baseline.PeakActors);
+    Check(TEXT("peak_memory_mb"), Result.PeakMemoryMB, Baseline.PeakMemoryMB);
+  }
+
+  FAutomationTestBase *Test;
+  FBangGuChaPerfCase Case;
+  float Seconds;
+
+  EPhase Phase = EPhase::Setup;
+  ABangGuChaMapGenerator *Generator = nullptr;
+  ABangGuChaPawn *Pawn = nullptr;
+  double SetupTime = 0.0;
+  double PlayStartTime = 0.0;
+  double LastFrameTime = 0.0;
+  int32 LastTurn = -1;
+  int32 LastFart = -1;
+  double BaseMemoryMB = 0.0;
+  double PeakMemoryMB = 0.0;
+  TArray<double> FrameTimesMs;
+  FBangGuChaPerfRow Result;
+};
+
+} // namespace
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FBangGuChaPerfTest, "BangGuCha.Perf",
+                                  EAutomationTestFlags::ClientContext |
+                                      EAutomationTestFlags::PerfFilter)
+
+void FBangGuChaPerfTest::GetTests(TArray<FString> &OutBeautifiedNames,
+                                  TArray<FString> &OutTestCommands) const {
+  for (const FBangGuChaPerfCase &Case : PerfCases) {
+    OutBeautifiedNames.Add(Case.Name);
+    OutTestCommands.Add(Case.Name);
+  }
+}
+
+bool FBangGuChaPerfTest::RunTest(const FString &Parameters) {
+  const FBangGuChaPerfCase *Case = nullptr;
+  for (const FBangGuChaPerfCase &Candidate : PerfCases) {
+    if (Parameters == Candidate.Name) {
+      Case = &Candidate;
+    }
+  }
+  if (!Case) {
+    AddError(FString::Printf(TEXT("Unknown perf case %s"), *Parameters));
+    return false;
+  }
+
+  float Seconds = 20.f;
+  FParse::Value(FCommandLine::Get(), TEXT("BangGuChaPerfSeconds="), Seconds);
+
+  // A fresh map per case keeps pools and actor counts independent
+  AutomationOpenMap(PerfMapUrl, true);
+  ADD_LATENT_AUTOMATION_COMMAND(
+      FBangGuChaPerfRunCommand(this, *Case, FMath::Max(Seconds, 1.f)));
+  return true;
+}
+
+#endif
@@ -0,0 +1,1213 @@
+// Regression tests for the headless simulation core (Source/BangGuCha/Sim).
+// Plain asserts-and-return-code runner so the build needs nothing beyond a
+// C++17 compiler; registered with CTest.
+
+#include "BangGuChaSimEnemySwarm.h"
+#include "BangGuChaSimFlowField.h"
+#include "BangGuChaSimHierarchicalPath.h"
+#include "BangGuChaSimJunctionGraph.h"
+#include "BangGuChaSimLevelFile.h"
+#include "BangGuChaSimMapGen.h"
+#include "BangGuChaSimNet.h"
+#include "BangGuChaSimReachability.h"
+#include "BangGuChaSimRules.h"
+#include "BangGuChaSimSmokeField.h"
+#include "BangGuChaSimTileHash.h"
+#include "BangGuChaSimWorld.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace BangGuChaSim;
+
+// Every heap allocation in this binary, for the zero-allocation checks
+static std::atomic<uint64_t> NumAllocations{0};
+
+void *operator new(std::size_t Size) {
+  NumAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *Ptr = std::malloc(Size != 0 ? Size : 1))
+    return Ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *Ptr) noexcept { std::free(Ptr); }
+void operator delete(void *Ptr, std::size_t) noexcept { std::free(Ptr); }
+
+namespace {
+
+int Failures = 0;
+
+#define SIM_EXPECT(Cond)                                                       \
+  do {                                                                         \
+    if (!(Cond)) {                                                             \
+      std::printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #Cond);         \
+      Failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+// Scripted input: turn every half second, fart every two seconds
+FSimInput ScriptedInput(uint64_t Step) {
+  static constexpr EDirection Turns[4] = {EDirection::PosY, EDirection::PosX,
+                                          EDirection::NegY, EDirection::NegX};
+  FSimInput Input;
+  if (Step % 30 == 0)
+    Input.Move = Turns[(Step / 30) % 4];
+  Input.bFart = Step % 120 == 60;
+  return Input;
+}
+
+uint64_t RunMatch(uint64_t Seed, int32_t MaxSteps, EMatchState &OutState) {
+  FSimConfig Config;
+  FSimWorld World;
+  World.Reset(Config, Seed);
+  for (int32_t Step = 0; Step < MaxSteps; Step++) {
+    if (World.Step(ScriptedInput(static_cast<uint64_t>(Step))) !=
+        EMatchState::Running)
+      break;
+  }
+  OutState = World.GetState();
+  return World.HashState();
+}
+
+void TestLayoutMatchesGeneratorRules() {
+  FMapParams Params;
+  FRandom Rng(42);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+
+  for (int32_t X = 0; X < Params.Width; X++) {
+    SIM_EXPECT(!Layout.Walls.IsWalkable(X, 0));
+    SIM_EXPECT(!Layout.Walls.IsWalkable(X, Params.Height - 1));
+  }
+  for (int32_t Y = 0; Y < Params.Height; Y++) {
+    SIM_EXPECT(!Layout.Walls.IsWalkable(0, Y));
+    SIM_EXPECT(!Layout.Walls.IsWalkable(Params.Width - 1, Y));
+  }
+  for (int32_t X = 1; X < Params.SafeZoneSize; X++) {
+    for (int32_t Y = 1; Y < Params.SafeZoneSize; Y++)
+      SIM_EXPECT(Layout.Walls.IsWalkable(X, Y));
+  }
+  for (const FTile &Flag : Layout.Flags)
+    SIM_EXPECT(Layout.Walls.IsWalkable(Flag.X, Flag.Y));
+  SIM_EXPECT(Layout.EnemySpawns.size() == 2);
+  SIM_EXPECT(!Layout.Walls.IsWalkable(-1, 1));
+  SIM_EXPECT(!Layout.Walls.IsWalkable(Params.Width, 1));
+}
+
+// Tile-at-a-time reference for FReachability
+std::vector<uint8_t> ScalarFlood(const FOccupancyGrid &Grid, FTile From) {
+  const int32_t Width = Grid.GetWidth();
+  std::vector<uint8_t> Reached(Grid.GetNumTiles(), 0);
+  std::vector<FTile> Queue;
+  if (Grid.IsWalkable(From.X, From.Y)) {
+    Reached[From.Y * Width + From.X] = 1;
+    Queue.push_back(From);
+  }
+  for (size_t Head = 0; Head < Queue.size(); Head++) {
+    for (EDirection Dir : {EDirection::PosX, EDirection::NegX,
+                           EDirection::PosY, EDirection::NegY}) {
+      const FTile Next{Queue[Head].X + StepX(Dir), Queue[Head].Y + StepY(Dir)};
+      if (Grid.IsWalkable(Next.X, Next.Y) &&
+          !Reached[Next.Y * Width + Next.X]) {
+        Reached[Next.Y * Width + Next.X] = 1;
+        Queue.push_back(Next);
+      }
+    }
+  }
+  return Reached;
+}
+
+void TestReachabilityMatchesScalarFlood() {
+  // Widths straddle word boundaries; dense walls leave sealed pockets
+  const FTile Sizes[] = {{20, 15}, {63, 40}, {64, 64}, {130, 77}};
+  for (const FTile &Size : Sizes) {
+    FMapParams Params;
+    Params.Width = Size.X;
+    Params.Height = Size.Y;
+    Params.WallChance = 0.38f;
+    Params.bEnsureReachable = false;
+    FRandom Rng(static_cast<uint64_t>(Size.X * 1000 + Size.Y));
+    FMapLayout Layout;
+    GenerateLayout(Params, Rng, Layout);
+
+    FReachability Reach;
+    Reach.Init(Layout.Walls);
+    Reach.Flood(1, 1);
+    const std::vector<uint8_t> Expected = ScalarFlood(Layout.Walls, {1, 1});
+
+    size_t Mismatches = 0;
+    size_t ExpectedCount = 0;
+    for (int32_t Y = 0; Y < Size.Y; Y++) {
+      for (int32_t X = 0; X < Size.X; X++) {
+        const bool bExpected = Expected[Y * Size.X + X] != 0;
+        ExpectedCount += bExpected;
+        Mismatches += Reach.IsReached(X, Y) != bExpected;
+        SIM_EXPECT(Reach.IsOpen(X, Y) == Layout.Walls.IsWalkable(X, Y));
+      }
+    }
+    SIM_EXPECT(Mismatches == 0);
+    SIM_EXPECT(Reach.CountReached() == ExpectedCount);
+  }
+}
+
+void TestGeneratedTargetsAreReachable() {
+  struct FCase {
+    EMapStyle Style;
+    int32_t Width;
+    int32_t Height;
+    float WallChance;
+  };
+  const FCase Cases[] = {{EMapStyle::Scatter, 90, 70, 0.42f},
+                         {EMapStyle::Backtracker, 101, 75, 0.f},
+                         {EMapStyle::Backtracker, 100, 74, 0.f},
+                         {EMapStyle::Braided, 129, 65, 0.f}};
+  for (const FCase &Case : Cases) {
+    FMapParams Params;
+    Params.Style = Case.Style;
+    Params.Width = Case.Width;
+    Params.Height = Case.Height;
+    Params.WallChance = Case.WallChance;
+    Params.ExtraEnemies = 30;
+    FRandom Rng(99);
+    FMapLayout Layout;
+    GenerateLayout(Params, Rng, Layout);
+
+    const std::vector<uint8_t> Reached =
+        ScalarFlood(Layout.Walls, Layout.PlayerStart);
+    SIM_EXPECT(!Layout.Flags.empty());
+    for (const FTile &Flag : Layout.Flags)
+      SIM_EXPECT(Reached[Flag.Y * Case.Width + Flag.X]);
+    for (const FTile &Spawn : Layout.EnemySpawns)
+      SIM_EXPECT(Reached[Spawn.Y * Case.Width + Spawn.X]);
+    for (int32_t X = 0; X < Case.Width; X++)
+      SIM_EXPECT(!Layout.Walls.IsWalkable(X, Case.Height - 1));
+    for (int32_t Y = 0; Y < Case.Height; Y++)
+      SIM_EXPECT(!Layout.Walls.IsWalkable(Case.Width - 1, Y));
+
+    // A perfect maze is a tree: every open tile hangs off the start
+    if (Case.Style == EMapStyle::Backtracker) {
+      size_t Open = 0;
+      size_t Connected = 0;
+      for (int32_t Y = 0; Y < Case.Height; Y++) {
+        for (int32_t X = 0; X < Case.Width; X++) {
+          Open += Layout.Walls.IsWalkable(X, Y);
+          Connected += Reached[Y * Case.Width + X];
+        }
+      }
+      SIM_EXPECT(Open == Connected);
+    }
+  }
+}
+
+void TestChunkedLayoutIsOrderIndependent() {
+  FMapParams Params;
+  Params.Width = 150;
+  Params.Height = 90;
+  Params.ExtraEnemies = 20;
+
+  FChunkedMapLayout Serial;
+  GenerateLayoutChunked(Params, 77, 32, Serial,
+                        [](int32_t Num, const auto &Body) {
+                          for (int32_t Index = 0; Index < Num; Index++)
+                            Body(Index);
+                        });
+
+  // Reverse order across threads, as a worker pool might schedule it
+  FChunkedMapLayout Threaded;
+  GenerateLayoutChunked(
+      Params, 77, 32, Threaded, [](int32_t Num, const auto &Body) {
+        std::vector<std::thread> Threads;
+        for (int32_t Index = Num - 1; Index >= 0; Index--)
+          Threads.emplace_back([&Body, Index]() { Body(Index); });
+        for (std::thread &Thread : Threads)
+          Thread.join();
+      });
+
+  SIM_EXPECT(Serial.ChunksX == 5 && Serial.ChunksY == 3);
+  SIM_EXPECT(Serial.Layout.Walls.GetWords() ==
+             Threaded.Layout.Walls.GetWords());
+  SIM_EXPECT(Serial.Layout.Flags.size() == Threaded.Layout.Flags.size());
+  SIM_EXPECT(Serial.Layout.EnemySpawns.size() == 22);
+
+  size_t ChunkEnemies = 0;
+  for (const FMapChunk &Chunk : Serial.Chunks) {
+    for (const FTile &Spawn : Chunk.EnemySpawns) {
+      SIM_EXPECT(Spawn.X >= Chunk.MinX && Spawn.X < Chunk.MaxX);
+      SIM_EXPECT(Spawn.Y >= Chunk.MinY && Spawn.Y < Chunk.MaxY);
+      SIM_EXPECT(Serial.Layout.Walls.IsWalkable(Spawn.X, Spawn.Y));
+    }
+    ChunkEnemies += Chunk.EnemySpawns.size();
+  }
+  SIM_EXPECT(ChunkEnemies == Serial.Layout.EnemySpawns.size());
+
+  for (int32_t X = 0; X < Params.Width; X++)
+    SIM_EXPECT(!Serial.Layout.Walls.IsWalkable(X, Params.Height - 1));
+  for (const FTile &Flag : Serial.Layout.Flags)
+    SIM_EXPECT(Serial.Layout.Walls.IsWalkable(Flag.X, Flag.Y));
+  SIM_EXPECT(Serial.Layout.Walls.IsWalkable(1, 1));
+}
+
+void TestSplitLayoutMatchesChunkedGeneration() {
+  FMapParams Params;
+  Params.Width = 150;
+  Params.Height = 90;
+  Params.ExtraEnemies = 20;
+  Params.bEnsureReachable = true;
+
+  FChunkedMapLayout Generated;
+  GenerateLayoutChunked(Params, 77, 32, Generated,
+                        [](int32_t Num, const auto &Body) {
+                          for (int32_t Index = 0; Index < Num; Index++)
+                            Body(Index);
+                        });
+
+  // As a cache hit would see it: only the finished layout
+  FChunkedMapLayout Loaded;
+  Loaded.Layout = Generated.Layout;
+  SplitLayoutIntoChunks(32, Loaded);
+
+  SIM_EXPECT(Loaded.ChunksX == Generated.ChunksX &&
+             Loaded.ChunksY == Generated.ChunksY);
+  SIM_EXPECT(Loaded.Chunks.size() == Generated.Chunks.size());
+  for (size_t Index = 0; Index < Loaded.Chunks.size(); Index++) {
+    const FMapChunk &A = Loaded.Chunks[Index];
+    const FMapChunk &B = Generated.Chunks[Index];
+    SIM_EXPECT(A.Walls == B.Walls);
+    SIM_EXPECT(A.Flags == B.Flags);
+    SIM_EXPECT(A.EnemySpawns == B.EnemySpawns);
+  }
+}
+
+void TestLevelFileRoundTrip() {
+  FMapParams Params;
+  Params.Width = 131; // Not a multiple of 64, so the last word is partial
+  Params.Height = 77;
+  Params.ExtraEnemies = 12;
+  FRandom Rng(5);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+  Layout.PlayerStart = FTile{2, 1};
+
+  const uint64_t Key = MakeLevelCacheKey(Params, 5);
+  std::vector<uint8_t> Bytes;
+  WriteLevel(Layout, 5, Key, Bytes);
+  SIM_EXPECT(Bytes.size() == LevelFileHeaderSize + 158 * 8 +
+                                 (Layout.Flags.size() + 14) * 8);
+
+  FLevelView View;
+  SIM_EXPECT(View.Parse(Bytes.data(), Bytes.size()));
+  SIM_EXPECT(View.GetHeader().Seed == 5 && View.GetHeader().CacheKey == Key);
+  FMapLayout Loaded;
+  SIM_EXPECT(LoadLevel(View, Loaded));
+  SIM_EXPECT(Loaded.Walls.GetWidth() == 131 && Loaded.Walls.GetHeight() == 77);
+  SIM_EXPECT(Loaded.Walls.GetWords() == Layout.Walls.GetWords());
+  SIM_EXPECT(Loaded.Flags == Layout.Flags);
+  SIM_EXPECT(Loaded.EnemySpawns == Layout.EnemySpawns);
+  SIM_EXPECT(Loaded.PlayerStart == Layout.PlayerStart);
+
+  // Truncated, padded, wrong version, tiles off the map
+  SIM_EXPECT(!View.Parse(Bytes.data(), Bytes.size() - 1));
+  Bytes.push_back(0);
+  SIM_EXPECT(!View.Parse(Bytes.data(), Bytes.size()));
+  Bytes.pop_back();
+  std::vector<uint8_t> Corrupt = Bytes;
+  Corrupt[4] = 2;
+  SIM_EXPECT(!View.Parse(Corrupt.data(), Corrupt.size()));
+  Corrupt = Bytes;
+  Corrupt[Corrupt.size() - 4] = 0xff;
+  SIM_EXPECT(View.Parse(Corrupt.data(), Corrupt.size()));
+  SIM_EXPECT(!LoadLevel(View, Loaded));
+  SIM_EXPECT(Loaded.Flags == Layout.Flags);
+
+  // Anything that changes the map changes the key
+  FMapParams Other = Params;
+  Other.WallChance = 0.2f;
+  SIM_EXPECT(MakeLevelCacheKey(Params, 5) == Key);
+  SIM_EXPECT(MakeLevelCacheKey(Params, 6) != Key);
+  SIM_EXPECT(MakeLevelCacheKey(Other, 5) != Key);
+  SIM_EXPECT(MakeLevelCacheKey(Params, 5, 64) != Key);
+  SIM_EXPECT(GetLevelCacheFileName(0x2a) == "000000000000002a.bgcl");
+}
+
+void TestFlowFieldTimeSlicingMatchesFullRebuild() {
+  FMapParams Params;
+  Params.Width = 64;
+  Params.Height = 48;
+  FRandom Rng(7);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+
+  FFlowField Full;
+  Full.Init(&Layout.Walls);
+  Full.SetGoal(Layout.PlayerStart);
+  SIM_EXPECT(Full.Update(1 << 30));
+
+  FFlowField Sliced;
+  Sliced.Init(&Layout.Walls);
+  Sliced.SetGoal(Layout.PlayerStart);
+  int32_t Calls = 0;
+  while (!Sliced.Update(17))
+    Calls++;
+  SIM_EXPECT(Calls > 1);
+
+  for (int32_t Y = 0; Y < Params.Height; Y++) {
+    for (int32_t X = 0; X < Params.Width; X++)
+      SIM_EXPECT(Full.GetStep(X, Y) == Sliced.GetStep(X, Y));
+  }
+
+  // Every step must lead into open space and eventually reach the goal
+  for (int32_t Y = 0; Y < Params.Height; Y++) {
+    for (int32_t X = 0; X < Params.Width; X++) {
+      FTile At{X, Y};
+      int32_t Guard = Params.Width * Params.Height;
+      while (Full.GetStep(At.X, At.Y) != EDirection::None && Guard-- > 0) {
+        const EDirection Step = Full.GetStep(At.X, At.Y);
+        At = FTile{At.X + StepX(Step), At.Y + StepY(Step)};
+        SIM_EXPECT(Layout.Walls.IsWalkable(At.X, At.Y));
+      }
+      SIM_EXPECT(Guard > 0);
+    }
+  }
+}
+
+void TestFlowFieldPublishesWhileGoalMoves() {
+  FMapParams Params;
+  Params.Width = 64;
+  Params.Height = 48;
+  FRandom Rng(7);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+
+  std::vector<FTile> Open;
+  for (int32_t Y = 0; Y < Params.Height; Y++) {
+    for (int32_t X = 0; X < Params.Width; X++) {
+      if (Layout.Walls.IsWalkable(X, Y))
+        Open.push_back(FTile{X, Y});
+    }
+  }
+
+  // A new goal every call with a budget far below one full rebuild
+  FFlowField Field;
+  Field.Init(&Layout.Walls);
+  int32_t Published = 0;
+  for (size_t Call = 0; Call < 200; Call++) {
+    Field.SetGoal(Open[(Call * 7) % Open.size()]);
+    if (Field.Update(64))
+      Published++;
+  }
+  SIM_EXPECT(Published > 1);
+  SIM_EXPECT(Field.IsReady());
+
+  // The latest goal wins once the goal holds still
+  const FTile Last = Open[(199 * 7) % Open.size()];
+  while (Field.IsBuilding())
+    Field.Update(64);
+  SIM_EXPECT(Field.GetGoal() == Last);
+}
+
+// Tile distances to Goal by breadth-first search; -1 where unreachable
+std::vector<int32_t> BfsDistances(const FOccupancyGrid &Grid, FTile Goal) {
+  const int32_t Width = Grid.GetWidth();
+  std::vector<int32_t> Dist(Grid.GetNumTiles(), -1);
+  std::vector<FTile> Open = {Goal};
+  Dist[static_cast<size_t>(Goal.Y * Width + Goal.X)] = 0;
+  for (size_t Head = 0; Head < Open.size(); Head++) {
+    const FTile At = Open[Head];
+    for (EDirection Dir : {EDirection::PosX, EDirection::NegX,
+                           EDirection::PosY, EDirection::NegY}) {
+      const FTile Next{At.X + StepX(Dir), At.Y + StepY(Dir)};
+      int32_t &NextDist = Dist[static_cast<size_t>(Next.Y * Width + Next.X)];
+      if (Grid.IsWalkable(Next.X, Next.Y) && NextDist < 0) {
+        NextDist = Dist[static_cast<size_t>(At.Y * Width + At.X)] + 1;
+        Open.push_back(Next);
+      }
+    }
+  }
+  return Dist;
+}
+
+void TestJunctionGraphFollowsShortestPaths() {
+  for (EMapStyle Style :
+       {EMapStyle::Scatter, EMapStyle::Backtracker, EMapStyle::Braided}) {
+    FMapParams Params;
+    Params.Width = 41;
+    Params.Height = 31;
+    Params.Style = Style;
+    FRandom Rng(11);
+    FMapLayout Layout;
+    GenerateLayout(Params, Rng, Layout);
+    const FOccupancyGrid &Walls = Layout.Walls;
+
+    FJunctionGraph Graph;
+    Graph.SetMaxCachedTrees(4);
+    Graph.Build(Walls);
+    SIM_EXPECT(Graph.GetNumNodes() > 0);
+
+    // Standing still, every tile takes a shortest step toward the goal
+    FRandom GoalRng(5);
+    for (int32_t Goals = 0; Goals < 8; Goals++) {
+      FTile Goal{1, 1};
+      do {
+        Goal = FTile{GoalRng.RandRange(1, Params.Width - 2),
+                     GoalRng.RandRange(1, Params.Height - 2)};
+      } while (!Walls.IsWalkable(Goal.X, Goal.Y));
+      Graph.SetGoal(Goal);
+      const std::vector<int32_t> Dist = BfsDistances(Walls, Goal);
+
+      for (int32_t Y = 0; Y < Params.Height; Y++) {
+        for (int32_t X = 0; X < Params.Width; X++) {
+          const int32_t Expected =
+              Dist[static_cast<size_t>(Y * Params.Width + X)];
+          const int32_t Actual = Graph.GetDistance(FTile{X, Y});
+          SIM_EXPECT(Expected >= 0 ? Actual == Expected
+                                   : Actual == FJunctionGraph::Unreachable);
+
+          const EDirection Step = Graph.GetStep(FTile{X, Y}, EDirection::None);
+          if (Expected <= 0) {
+            SIM_EXPECT(Step == EDirection::None);
+            continue;
+          }
+          const FTile Next{X + StepX(Step), Y + StepY(Step)};
+          SIM_EXPECT(Walls.IsWalkable(Next.X, Next.Y) &&
+                     Dist[static_cast<size_t>(Next.Y * Params.Width +
+                                              Next.X)] == Expected - 1);
+        }
+      }
+    }
+  }
+}
+
+void TestJunctionGraphDecidesOnlyAtJunctions() {
+  // A corridor along y = 1 from x = 1 to 20 with a branch down from x = 10
+  FOccupancyGrid Walls;
+  Walls.Init(22, 12);
+  Walls.Fill(true);
+  for (int32_t X = 1; X <= 20; X++)
+    Walls.SetBlocked(X, 1, false);
+  for (int32_t Y = 2; Y <= 10; Y++)
+    Walls.SetBlocked(10, Y, false);
+
+  FJunctionGraph Graph;
+  Graph.Build(Walls);
+  SIM_EXPECT(Graph.GetNumNodes() == 4 && Graph.GetNumEdges() == 3);
+
+  // Walking away from the branch carries on to the dead end, while an
+  // enemy with no heading turns toward the goal
+  Graph.SetGoal(FTile{10, 10});
+  SIM_EXPECT(Graph.GetStep(FTile{3, 1}, EDirection::NegX) == EDirection::NegX);
+  SIM_EXPECT(Graph.GetStep(FTile{3, 1}, EDirection::None) == EDirection::PosX);
+  SIM_EXPECT(Graph.GetStep(FTile{1, 1}, EDirection::NegX) == EDirection::PosX);
+  SIM_EXPECT(Graph.GetStep(FTile{10, 1}, EDirection::PosX) ==
+             EDirection::PosY);
+
+  // A goal in the same corridor turns the enemy around
+  Graph.SetGoal(FTile{6, 1});
+  SIM_EXPECT(Graph.GetStep(FTile{3, 1}, EDirection::NegX) == EDirection::PosX);
+
+  // The goal moving along one corridor reuses that corridor's trees
+  Graph.SetGoal(FTile{10, 4});
+  const uint64_t Builds = Graph.GetTreeBuilds();
+  for (int32_t Y = 5; Y < 10; Y++)
+    Graph.SetGoal(FTile{10, Y});
+  SIM_EXPECT(Graph.GetTreeBuilds() == Builds);
+  SIM_EXPECT(Graph.GetDistance(FTile{20, 1}) == 18);
+
+  // Only a new map drops the cache
+  Graph.Build(Walls);
+  SIM_EXPECT(Graph.GetTreeBuilds() == 0 && !Graph.HasGoal());
+
+  // A closed loop without junctions still gets a node
+  FOccupancyGrid Loop;
+  Loop.Init(6, 6);
+  Loop.Fill(true);
+  for (int32_t i = 1; i <= 4; i++) {
+    Loop.SetBlocked(i, 1, false);
+    Loop.SetBlocked(i, 4, false);
+    Loop.SetBlocked(1, i, false);
+    Loop.SetBlocked(4, i, false);
+  }
+  Graph.Build(Loop);
+  SIM_EXPECT(Graph.GetNumNodes() == 1 && Graph.GetNumEdges() == 1);
+  Graph.SetGoal(FTile{4, 4});
+  SIM_EXPECT(Graph.GetDistance(FTile{1, 1}) == 6);
+  SIM_EXPECT(Graph.GetDistance(FTile{2, 1}) == 5);
+}
+
+void PrepareAll(FHierarchicalPath &Path, const FOccupancyGrid &Walls) {
+  for (int32_t Y = 0; Y < Walls.GetHeight(); Y += Path.GetClusterSize()) {
+    for (int32_t X = 0; X < Walls.GetWidth(); X += Path.GetClusterSize())
+      Path.Prepare(FTile{X, Y});
+  }
+}
+
+void TestHierarchicalPathIsNearOptimal() {
+  for (EMapStyle Style : {EMapStyle::Scatter, EMapStyle::Braided}) {
+    FMapParams Params;
+    Params.Width = 97;
+    Params.Height = 75;
+    Params.Style = Style;
+    FRandom Rng(19);
+    FMapLayout Layout;
+    GenerateLayout(Params, Rng, Layout);
+    const FOccupancyGrid &Walls = Layout.Walls;
+
+    FHierarchicalPath Path;
+    Path.Build(&Walls, 16);
+    SIM_EXPECT(Path.GetNumClusters() == 7 * 5);
+    SIM_EXPECT(Path.GetNumEntrances() > 0);
+
+    FRandom GoalRng(3);
+    int64_t Optimal = 0;
+    int64_t Routed = 0;
+    for (int32_t Goals = 0; Goals < 6; Goals++) {
+      FTile Goal{1, 1};
+      do {
+        Goal = FTile{GoalRng.RandRange(1, Params.Width - 2),
+                     GoalRng.RandRange(1, Params.Height - 2)};
+      } while (!Walls.IsWalkable(Goal.X, Goal.Y));
+      Path.SetGoal(Goal);
+      PrepareAll(Path, Walls);
+      const std::vector<int32_t> Dist = BfsDistances(Walls, Goal);
+
+      // Routes never beat the true distance and every step follows the
+      // route down by one tile
+      for (int32_t Y = 0; Y < Params.Height; Y++) {
+        for (int32_t X = 0; X < Params.Width; X++) {
+          const int32_t Expected =
+              Dist[static_cast<size_t>(Y * Params.Width + X)];
+          const int32_t Actual = Path.GetDistance(FTile{X, Y});
+          if (Expected < 0) {
+            SIM_EXPECT(Actual == FHierarchicalPath::Unreachable);
+            continue;
+          }
+          SIM_EXPECT(Actual != FHierarchicalPath::Unreachable &&
+                     Actual >= Expected);
+          Optimal += Expected;
+          Routed += Actual;
+
+          const EDirection Step = Path.GetStep(FTile{X, Y});
+          if (Expected == 0) {
+            SIM_EXPECT(Step == EDirection::None);
+            continue;
+          }
+          const FTile Next{X + StepX(Step), Y + StepY(Step)};
+          SIM_EXPECT(Step != EDirection::None &&
+                     Walls.IsWalkable(Next.X, Next.Y) &&
+                     Path.GetDistance(Next) == Actual - 1);
+        }
+      }
+    }
+    SIM_EXPECT(Routed <= Optimal + Optimal / 10);
+  }
+}
+
+void TestHierarchicalPathReachesGoalInWindingCluster() {
+  // The right cluster is one serpentine corridor behind a single
+  // entrance, so the goal at its far end is much further from that
+  // entrance than any edge between entrances
+  FOccupancyGrid Walls;
+  Walls.Init(32, 16);
+  Walls.Fill(true);
+  for (int32_t Y = 1; Y < 15; Y++) {
+    for (int32_t X = 1; X < 16; X++)
+      Walls.SetBlocked(X, Y, false);
+  }
+  for (int32_t Y = 1; Y < 15; Y += 2) {
+    for (int32_t X = 16; X < 31; X++)
+      Walls.SetBlocked(X, Y, false);
+    if (Y + 2 < 15)
+      Walls.SetBlocked((Y / 2) % 2 == 0 ? 30 : 17, Y + 1, false);
+  }
+  // Only row 1 crosses into the right cluster
+  for (int32_t Y = 3; Y < 15; Y += 2)
+    Walls.SetBlocked(16, Y, true);
+
+  const FTile Goal{30, 13};
+  FHierarchicalPath Path;
+  Path.Build(&Walls, 16);
+  Path.SetGoal(Goal);
+  PrepareAll(Path, Walls);
+
+  FFlowField Field;
+  Field.Init(&Walls);
+  Field.SetGoal(Goal);
+  SIM_EXPECT(Field.Update(1 << 30));
+
+  const std::vector<int32_t> Dist = BfsDistances(Walls, Goal);
+  for (const FTile &At : {FTile{30, 1}, FTile{15, 1}, FTile{1, 14}}) {
+    int32_t Steps = 0;
+    FTile Walk = At;
+    while (Field.GetStep(Walk.X, Walk.Y) != EDirection::None) {
+      const EDirection Step = Field.GetStep(Walk.X, Walk.Y);
+      Walk = FTile{Walk.X + StepX(Step), Walk.Y + StepY(Step)};
+      Steps++;
+    }
+    SIM_EXPECT(Walk == Goal);
+    SIM_EXPECT(Steps == Dist[static_cast<size_t>(At.Y * 32 + At.X)]);
+    SIM_EXPECT(Path.GetDistance(At) == Steps);
+  }
+}
+
+void TestHierarchicalPathRebuildsOnlyDirtyClusters() {
+  FMapParams Params;
+  Params.Width = 64;
+  Params.Height = 64;
+  Params.Style = EMapStyle::Braided;
+  FRandom Rng(8);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+  FOccupancyGrid &Walls = Layout.Walls;
+
+  FHierarchicalPath Path;
+  Path.Build(&Walls, 16);
+
+  // One tile inside a cluster and one on a cluster border
+  SIM_EXPECT(Path.RebuildDirty() == 0);
+  for (const FTile Tile : {FTile{21, 21}, FTile{31, 40}}) {
+    Walls.SetBlocked(Tile.X, Tile.Y, Walls.IsWalkable(Tile.X, Tile.Y));
+    Path.MarkTileChanged(Tile.X, Tile.Y);
+  }
+  SIM_EXPECT(Path.RebuildDirty() == 3);
+  SIM_EXPECT(!Path.HasGoal());
+
+  FHierarchicalPath Fresh;
+  Fresh.Build(&Walls, 16);
+  SIM_EXPECT(Path.GetNumEntrances() == Fresh.GetNumEntrances());
+  Path.SetGoal(Layout.PlayerStart);
+  Fresh.SetGoal(Layout.PlayerStart);
+  PrepareAll(Path, Walls);
+  PrepareAll(Fresh, Walls);
+  for (int32_t Y = 0; Y < Params.Height; Y++) {
+    for (int32_t X = 0; X < Params.Width; X++) {
+      SIM_EXPECT(Path.GetDistance(FTile{X, Y}) ==
+                 Fresh.GetDistance(FTile{X, Y}));
+      SIM_EXPECT(Path.GetStep(FTile{X, Y}) == Fresh.GetStep(FTile{X, Y}));
+    }
+  }
+
+  // In the open, a goal stepping away from a far cluster shifts all of
+  // its entrances by one, so its flood is reused
+  FOccupancyGrid Open;
+  Open.Init(64, 64);
+  FHierarchicalPath OpenPath;
+  OpenPath.Build(&Open, 16);
+  OpenPath.SetGoal(FTile{5, 5});
+  OpenPath.Prepare(FTile{50, 50});
+  const uint64_t Builds = OpenPath.GetFieldBuilds();
+  const int32_t Before = OpenPath.GetDistance(FTile{50, 50});
+  OpenPath.SetGoal(FTile{6, 5});
+  OpenPath.Prepare(FTile{50, 50});
+  SIM_EXPECT(OpenPath.GetFieldBuilds() == Builds);
+  SIM_EXPECT(OpenPath.GetDistance(FTile{50, 50}) == Before - 1);
+}
+
+void TestSwarmPreparesEveryTileAFastStepReaches() {
+  FOccupancyGrid Walls;
+  Walls.Init(64, 64);
+  for (int32_t i = 0; i < 64; i++) {
+    Walls.SetBlocked(i, 0);
+    Walls.SetBlocked(i, 63);
+    Walls.SetBlocked(0, i);
+    Walls.SetBlocked(63, i);
+  }
+  FHierarchicalPath Path;
+  Path.Build(&Walls, 8);
+  Path.SetGoal(FTile{60, 60});
+
+  // Three tiles per step, from a tile three short of the next cluster
+  FEnemySwarmParams Params;
+  Params.MoveSpeed = 600.f;
+  FEnemySwarm Swarm;
+  Swarm.Add(FTile{5, 5}, Params.GridSize);
+  Swarm.PreparePaths(0.5f, Params, Path);
+
+  for (int32_t Y = 1; Y <= 9; Y++) {
+    for (int32_t X = 1; X <= 9; X++) {
+      if (std::abs(X - 5) + std::abs(Y - 5) <= 4)
+        SIM_EXPECT(Path.GetDistance(FTile{X, Y}) !=
+                   FHierarchicalPath::Unreachable);
+    }
+  }
+}
+
+void TestParallelSwarmMatchesSerial() {
+  FMapParams Params;
+  Params.Width = 96;
+  Params.Height = 64;
+  Params.Style = EMapStyle::Braided;
+  FRandom Rng(21);
+  FMapLayout Layout;
+  GenerateLayout(Params, Rng, Layout);
+
+  FFlowField FlowField;
+  FlowField.Init(&Layout.Walls);
+
+  const FEnemySwarmParams SwarmParams;
+  FEnemySwarm Serial;
+  for (int32_t Y = 1; Y < Params.Height - 1; Y += 2) {
+    for (int32_t X = 1; X < Params.Width - 1; X += 3) {
+      if (Layout.Walls.IsWalkable(X, Y))
+        Serial.Add(FTile{X, Y}, SwarmParams.GridSize);
+    }
+  }
+  FEnemySwarm Threaded = Serial;
+  SIM_EXPECT(Serial.Num() > 500);
+
+  // Batches run in reverse order on their own threads
+  auto ParallelFor = [](int32_t Num, const auto &Body) {
+    std::vector<std::thread> Threads;
+    for (int32_t Index = Num - 1; Index >= 0; Index--)
+      Threads.emplace_back([&Body, Index]() { Body(Index); });
+    for (std::thread &Thread : Threads)
+      Thread.join();
+  };
+
+  // The player wanders so both the flow field and the fallback chase run
+  FTile Player = Layout.PlayerStart;
+  for (int32_t Step = 0; Step < 240; Step++) {
+    if (Step % 20 == 0) {
+      const FTile Next{Player.X + 1, Player.Y + (Step / 20) % 2};
+      if (Layout.Walls.IsWalkable(Next.X, Next.Y))
+        Player = Next;
+      FlowField.SetGoal(Player);
+    }
+    FlowField.Update(Step < 120 ? 1 << 30 : 64);
+    if (Step == 60) {
+      for (size_t i = 0; i < Serial.Num(); i += 7) {
+        Serial.Stun(i, 0.5f);
+        Threaded.Stun(i, 0.5f);
+      }
+    }
+
+    const float PlayerX = Player.X * SwarmParams.GridSize;
+    const float PlayerY = Player.Y * SwarmParams.GridSize;
+    Serial.Advance(1.f / 60.f, SwarmParams, PlayerX, PlayerY, Layout.Walls,
+                   &FlowField);
+    const FEnemySwarmSnapshot Snapshot{PlayerX, PlayerY, &Layout.Walls,
+                                       &FlowField};
+    Threaded.AdvanceParallel(1.f / 60.f, SwarmParams, Snapshot, 37,
+                             ParallelFor);
+  }
+
+  SIM_EXPECT(Serial.X == Threaded.X && Serial.Y == Threaded.Y);
+  SIM_EXPECT(Serial.TargetX == Threaded.TargetX &&
+             Serial.TargetY == Threaded.TargetY);
+  SIM_EXPECT(Serial.Direction == Threaded.Direction);
+  SIM_EXPECT(Serial.StunTimer == Threaded.StunTimer);
+  SIM_EXPECT(Serial.bIsStunned == Threaded.bIsStunned);
+  SIM_EXPECT(Serial.bNewTarget == Threaded.bNewTarget);
+}
+
+void TestNetGridStateRoundTrip() {
+  const float GridSize = 100.f;
+  FOccupancyGrid Grid;
+  Grid.Init(64, 64);
+  auto CanEnter = [&Grid](int32_t X, int32_t Y) {
+    return Grid.IsWalkable(X, Y);
+  };
+
+  // Walk a mover round a square, checking every frame's packed state.
+  // Progress rounds to 1/32 tile and clamps just short of the next tile.
+  static constexpr EDirection Turns[4] = {EDirection::PosX, EDirection::PosY,
+                                          EDirection::NegX, EDirection::NegY};
+  FMover Mover;
+  InitMover(Mover, 4000.f, 4000.f, GridSize);
+  for (int32_t Step = 0; Step < 2400; Step++) {
+    if (Step % 90 == 0)
+      Mover.NextDirection = Turns[(Step / 90) % 4];
+    StepPlayerMover(Mover, 1.f / 60.f, 230.f, GridSize, CanEnter);
+
+    FMover Received;
+    UnpackNetGridState(PackNetGridState(Mover), GridSize,
+                       Received);
+    SIM_EXPECT(Received.Target == Mover.Target);
+    SIM_EXPECT(Received.Direction == Mover.Direction);
+    SIM_EXPECT(std::fabs(Received.X - Mover.X) <= GridSize / 32.f);
+    SIM_EXPECT(std::fabs(Received.Y - Mover.Y) <= GridSize / 32.f);
+  }
+
+  FMover Still;
+  InitMover(Still, 4095.f * GridSize, 0.f, GridSize);
+  FMover Received;
+  UnpackNetGridState(PackNetGridState(Still), GridSize, Received);
+  SIM_EXPECT(Received.Target == (FTile{4095, 0}));
+  SIM_EXPECT(Received.X == Still.X && Received.Direction == EDirection::None);
+}
+
+void TestTileHashMatchesScan() {
+  FRandom Rng(11);
+  FTileHash Hash;
+  for (size_t Count : {size_t(0), size_t(1), size_t(37), size_t(500)}) {
+    std::vector<float> X, Y;
+    Hash.Reset(100.f);
+    for (size_t i = 0; i < Count; i++) {
+      // Off-center and negative positions too
+      X.push_back(Rng.NextFloat() * 3000.f - 500.f);
+      Y.push_back(Rng.NextFloat() * 2000.f - 500.f);
+      Hash.Add(X.back(), Y.back());
+    }
+    Hash.Build();
+
+    for (int32_t Query = 0; Query < 200; Query++) {
+      const float QX = Rng.NextFloat() * 3000.f - 500.f;
+      const float QY = Rng.NextFloat() * 2000.f - 500.f;
+      const float Reach = Query % 3 == 0 ? 30.f : Query % 3 == 1 ? 85.f : 250.f;
+      std::vector<int32_t> Seen(Count, 0);
+      Hash.ForEachNear(QX, QY, Reach, [&](uint32_t i) { Seen[i]++; });
+      for (size_t i = 0; i < Count; i++) {
+        SIM_EXPECT(Seen[i] <= 1);
+        if (Overlaps(QX, QY, X[i], Y[i], Reach))
+          SIM_EXPECT(Seen[i] == 1);
+      }
+    }
+  }
+}
+
+// Whole-grid, tile-at-a-time reference for FSmokeField::Step
+void ReferenceSmokeStep(const FOccupancyGrid &Walls,
+                        std::vector<float> &Density, float DeltaTime,
+                        float SpreadRate, float FadeRate) {
+  const int32_t Width = Walls.GetWidth();
+  const float Fade = std::exp(-FadeRate * DeltaTime);
+  const float Gain = std::min(SpreadRate * DeltaTime, 0.25f) * Fade;
+  auto At = [&](int32_t X, int32_t Y) {
+    return Walls.IsWalkable(X, Y) ? Density[Y * Width + X] : 0.f;
+  };
+  std::vector<float> Next(Density.size(), 0.f);
+  for (int32_t Y = 0; Y < Walls.GetHeight(); Y++) {
+    for (int32_t X = 0; X < Width; X++) {
+      if (!Walls.IsWalkable(X, Y))
+        continue;
+      const int32_t Open =
+          Walls.IsWalkable(X - 1, Y) + Walls.IsWalkable(X + 1, Y) +
+          Walls.IsWalkable(X, Y - 1) + Walls.IsWalkable(X, Y + 1);
+      const float Value =
+          At(X, Y) * (Fade - Gain * static_cast<float>(Open)) +
+          Gain * (At(X - 1, Y) + At(X + 1, Y) + At(X, Y - 1) + At(X, Y + 1));
+      Next[Y * Width + X] = Value >= FSmokeField::FlushDensity ? Value : 0.f;
+    }
+  }
+  Density.swap(Next);
+}
+
+void TestSmokeFieldMatchesReference() {
+  // Widths around the kernel's group of sixteen, and clouds that fade out
+  // completely before new ones land
+  for (int32_t Width : {5, 16, 37}) {
+    FMapParams Params;
+    Params.Width = Width;
+    Params.Height = 23;
+    Params.WallChance = 0.25f;
+    FRandom Rng(static_cast<uint64_t>(Width));
+    FMapLayout Layout;
+    GenerateLayout(Params, Rng, Layout);
+
+    FSmokeField Field;
+    Field.Init(Layout.Walls);
+    std::vector<float> Reference(Layout.Walls.GetNumTiles(), 0.f);
+    for (int32_t Step = 0; Step < 600; Step++) {
+      if (Step % 150 < 3) {
+        const int32_t X = static_cast<int32_t>(Rng.NextFloat() * Width);
+        const int32_t Y = static_cast<int32_t>(Rng.NextFloat() * 23);
+        Field.Deposit(X, Y, 1.f);
+        if (Layout.Walls.IsWalkable(X, Y))
+          Reference[Y * Width + X] += 1.f;
+      }
+      Field.Step(1.f / 60.f, 2.f, 3.f);
+      ReferenceSmokeStep(Layout.Walls, Reference, 1.f / 60.f, 2.f, 3.f);
+
+      bool bAnySmoke = false;
+      for (int32_t Y = 0; Y < 23; Y++) {
+        for (int32_t X = 0; X < Width; X++) {
+          const float Expected = Reference[Y * Width + X];
+          SIM_EXPECT(std::fabs(Field.GetDensity(X, Y) - Expected) <= 1e-5f);
+          bAnySmoke |= Expected > 0.f;
+        }
+      }
+      SIM_EXPECT(Field.IsEmpty() == !bAnySmoke);
+    }
+  }
+}
+
+void TestSmokeFieldStaysBehindWalls() {
+  // Two open rooms split by a wall column
+  FOccupancyGrid Walls;
+  Walls.Init(21, 9);
+  for (int32_t Y = 0; Y < 9; Y++)
+    Walls.SetBlocked(10, Y);
+
+  FSmokeField Field;
+  Field.Init(Walls);
+  Field.Deposit(10, 4, 1.f);
+  SIM_EXPECT(Field.IsEmpty());
+  Field.Deposit(5, 4, 1.f);
+  for (int32_t Step = 0; Step < 600; Step++)
+    Field.Step(1.f / 60.f, 4.f, 0.f);
+
+  // Without fading only the thin edge below FlushDensity is lost
+  SIM_EXPECT(Field.GetTotal() <= 1.0001);
+  SIM_EXPECT(Field.GetTotal() >= 0.995);
+  SIM_EXPECT(Field.GetDensity(0, 0) > 0.f);
+  for (int32_t Y = 0; Y < 9; Y++) {
+    for (int32_t X = 10; X < 21; X++)
+      SIM_EXPECT(Field.GetDensity(X, Y) == 0.f);
+  }
+
+  for (int32_t Step = 0; Step < 600; Step++)
+    Field.Step(1.f / 60.f, 4.f, 2.f);
+  SIM_EXPECT(Field.IsEmpty());
+  SIM_EXPECT(Field.GetTotal() == 0.0);
+}
+
+void TestSmokeFieldStunsEnemies() {
+  FSimConfig Config;
+  Config.SmokeModel = ESmokeModel::Field;
+  Config.PlayerExtent = 0.f;
+  Config.EnemyExtent = 0.f;
+  FSimWorld World;
+  World.Reset(Config, 7);
+
+  // The player stays put and farts whenever a chaser is two tiles away,
+  // so it walks into the smoke
+  int32_t Stuns = 0;
+  for (uint64_t Step = 0; Step < 3600; Step++) {
+    const FEnemySwarm &Enemies = World.GetEnemies();
+    const FMover &Player = World.GetPlayer().Mover;
+    FSimInput Input;
+    std::vector<uint8_t> WasStunned = Enemies.bIsStunned;
+    for (size_t e = 0; e < Enemies.Num(); e++) {
+      Input.bFart |= std::fabs(Enemies.X[e] - Player.X) +
+                         std::fabs(Enemies.Y[e] - Player.Y) <=
+                     2.f * Config.GridSize;
+    }
+    World.Step(Input);
+    for (size_t e = 0; e < Enemies.Num(); e++)
+      Stuns += !WasStunned[e] && Enemies.bIsStunned[e];
+  }
+  SIM_EXPECT(World.GetSmokes().empty());
+  SIM_EXPECT(Stuns > 0);
+}
+
+void TestRules() {
+  float Fuel = 3.f;
+  ConsumeFuel(Fuel, 5.f, 1.f);
+  SIM_EXPECT(Fuel == 0.f);
+  SIM_EXPECT(!TrySpendFartFuel(Fuel));
+  Fuel = 12.f;
+  SIM_EXPECT(TrySpendFartFuel(Fuel) && Fuel == 2.f);
+
+  bool bIsStunned = false;
+  float StunTimer = 0.f;
+  ApplyStun(bIsStunned, StunTimer, 0.25f);
+  SIM_EXPECT(TickStun(bIsStunned, StunTimer, 0.2f) && bIsStunned);
+  SIM_EXPECT(TickStun(bIsStunned, StunTimer, 0.2f) && !bIsStunned);
+  SIM_EXPECT(!TickStun(bIsStunned, StunTimer, 0.2f));
+
+  int32_t Score = 0;
+  int32_t Collected = 0;
+  CollectFlag(Score, Collected);
+  SIM_EXPECT(Score == FlagScore && Collected == 1);
+  SIM_EXPECT(HasCollectedAllFlags(1, 1) && !HasCollectedAllFlags(0, 0));
+}
+
+void TestPlayerStopsAtWalls() {
+  FOccupancyGrid Grid;
+  Grid.Init(5, 3);
+  for (int32_t X = 0; X < 5; X++) {
+    Grid.SetBlocked(X, 0);
+    Grid.SetBlocked(X, 2);
+  }
+  Grid.SetBlocked(0, 1);
+  Grid.SetBlocked(4, 1);
+
+  FMover Mover;
+  InitMover(Mover, 100.f, 100.f, 100.f);
+  Mover.NextDirection = EDirection::PosX;
+  auto CanEnter = [&Grid](int32_t X, int32_t Y) {
+    return Grid.IsWalkable(X, Y);
+  };
+  for (int32_t Step = 0; Step < 600; Step++)
+    StepPlayerMover(Mover, 1.f / 60.f, 300.f, 100.f, CanEnter);
+
+  SIM_EXPECT(Mover.Target == (FTile{3, 1}));
+  SIM_EXPECT(Mover.X == 300.f && Mover.Y == 100.f);
+  SIM_EXPECT(Mover.Direction == EDirection::None);
+}
+
+// Same turn script at 60 Hz and at 4 Hz: the fixed substeps must put the
+// mover on the same tile with the same progress at every 4 Hz boundary,
+// and every turn must land although a 4 Hz frame spans several tiles.
+void TestMoverIsFrameRateIndependent() {
+  const float GridSize = 100.f;
+  FOccupancyGrid Grid;
+  Grid.Init(16, 16);
+  for (int32_t I = 0; I < 16; I++) {
+    Grid.SetBlocked(I, 0);
+    Grid.SetBlocked(I, 15);
+    Grid.SetBlocked(0, I);
+    Grid.SetBlocked(15, I);
+  }
+  auto CanEnter = [&Grid](int32_t X, int32_t Y) {
+    return Grid.IsWalkable(X, Y);
+  };
+
+  static constexpr EDirection Turns[4] = {EDirection::PosX, EDirection::PosY,
+                                          EDirection::NegX, EDirection::NegY};
+  FMover Fast, Slow;
+  InitMover(Fast, 100.f, 100.f, GridSize);
+  InitMover(Slow, 100.f, 100.f, GridSize);
+  int32_t SlowTurns = 0;
+  for (int32_t Frame = 0; Frame < 40; Frame++) {
+    const EDirection Turn = Turns[(Frame / 6) % 4];
+    Fast.NextDirection = Turn;
+    Slow.NextDirection = Turn;
+    for (int32_t Sub = 0; Sub < 15; Sub++)
+      StepPlayerMover(Fast, 1.f / 60.f, 300.f, GridSize, CanEnter);
+    const EDirection Before = Slow.Direction;
+    StepPlayerMover(Slow, 0.25f, 300.f, GridSize, CanEnter);
+    SlowTurns += Slow.Direction != Before;
+
+    SIM_EXPECT(Fast.Target == Slow.Target);
+    SIM_EXPECT(Fast.Remaining == Slow.Remaining);
+    SIM_EXPECT(Fast.Direction == Slow.Direction);
+    SIM_EXPECT(Fast.X == Slow.X && Fast.Y == Slow.Y);
+  }
+  SIM_EXPECT(SlowTurns >= 6);
+  SIM_EXPECT(CanEnter(Slow.Target.X, Slow.Target.Y));
+}
+
+void TestStepDoesNotAllocate() {
+  const std::pair<EPathing, ESmokeModel> Modes[] = {
+      {EPathing::FlowField, ESmokeModel::Clouds},
+      {EPathing::JunctionGraph, ESmokeModel::Clouds},
+      {EPathing::Hierarchical, ESmokeModel::Clouds},
+      {EPathing::JunctionGraph, ESmokeModel::Field}};
+  for (const auto &Mode : Modes) {
+    FSimConfig Config;
+    Config.Map.Width = 48;
+    Config.Map.Height = 32;
+    Config.Map.ExtraEnemies = 30;
+    // Enemies can never touch the player, so the match runs throughout
+    Config.PlayerExtent = 0.f;
+    Config.EnemyExtent = 0.f;
+    Config.Pathing = Mode.first;
+    Config.SmokeModel = Mode.second;
+    FSimWorld World;
+    World.Reset(Config, 99);
+
+    // Caches fill during the first steps; after that nothing may allocate
+    uint64_t Step = 0;
+    for (; Step < 600; Step++)
+      World.Step(ScriptedInput(Step));
+    const uint64_t Before = NumAllocations.load();
+    for (; Step < 3600; Step++)
+      World.Step(ScriptedInput(Step));
+    SIM_EXPECT(World.GetState() == EMatchState::Running);
+    SIM_EXPECT(NumAllocations.load() == Before);
+  }
+}
+
+void TestRestartMatchesReset() {
+  const std::pair<EPathing, ESmokeModel> Modes[] = {
+      {EPathing::FlowField, ESmokeModel::Clouds},
+      {EPathing::JunctionGraph, ESmokeModel::Clouds},
+      {EPathing::Hierarchical, ESmokeModel::Clouds},
+      {EPathing::JunctionGraph, ESmokeModel::Field}};
+  for (const auto &Mode : Modes) {
+    FSimConfig Config;
+    Config.Map.ExtraEnemies = 10;
+    Config.Pathing = Mode.first;
+    Config.SmokeModel = Mode.second;
+    auto Play = [](FSimWorld &World) {
+      for (uint64_t Step = 0; Step < 60 * 60; Step++) {
+        if (World.Step(ScriptedInput(Step)) != EMatchState::Running)
+          break;
+      }
+    };
+
+    FSimWorld Fresh;
+    Fresh.Reset(Config, 77);
+    Play(Fresh);
+
+    // A different first match leaves every cache and buffer in use
+    FSimWorld Restarted;
+    Restarted.Reset(Config, 77);
+    for (uint64_t Step = 0; Step < 60 * 20; Step++)
+      Restarted.Step(ScriptedInput(Step * 7 + 3));
+    const uint64_t Before = NumAllocations.load();
+    Restarted.Restart();
+    SIM_EXPECT(NumAllocations.load() == Before);
+    SIM_EXPECT(Restarted.GetStepCount() == 0 && Restarted.GetScore() == 0);
+    SIM_EXPECT(Restarted.GetSmokeField().IsEmpty());
+    Play(Restarted);
+
+    SIM_EXPECT(Restarted.HashState() == Fresh.HashState());
+    SIM_EXPECT(Restarted.GetState() == Fresh.GetState());
+    SIM_EXPECT(Restarted.GetCollectedFlags() == Fresh.GetCollectedFlags());
+  }
+}
+
+void TestMatchIsDeterministic() {
+  EMatchState StateA, StateB, StateC;
+  const uint64_t HashA = RunMatch(1234, 60 * 120, StateA);
+  const uint64_t HashB = RunMatch(1234, 60 * 120, StateB);
+  const uint64_t HashC = RunMatch(4321, 60 * 120, StateC);
+  SIM_EXPECT(HashA == HashB && StateA == StateB);
+  SIM_EXPECT(HashA != HashC);
+}
+
+} // namespace
+
+int main() {
+  const std::vector<std::pair<const char *, std::function<void()>>> Tests = {
+      {"LayoutMatchesGeneratorRules", TestLayoutMatchesGeneratorRules},
+      {"ChunkedLayoutIsOrderIndependent", TestChunkedLayoutIsOrderIndependent},
+      {"SplitLayoutMatchesChunkedGeneration",
+       TestSplitLayoutMatchesChunkedGeneration},
+      {"LevelFileRoundTrip", TestLevelFileRoundTrip},
+      {"ReachabilityMatchesScalarFlood", TestReachabilityMatchesScalarFlood},
+      {"GeneratedTargetsAreReachable", TestGeneratedTargetsAreReachable},
+      {"FlowFieldTimeSlicingMatchesFullRebuild",
+       TestFlowFieldTimeSlicingMatchesFullRebuild},
+      {"FlowFieldPublishesWhileGoalMoves",
+       TestFlowFieldPublishesWhileGoalMoves},
+      {"JunctionGraphFollowsShortestPaths",
+       TestJunctionGraphFollowsShortestPaths},
+      {"JunctionGraphDecidesOnlyAtJunctions",
+       TestJunctionGraphDecidesOnlyAtJunctions},
+      {"HierarchicalPathIsNearOptimal", TestHierarchicalPathIsNearOptimal},
+      {"HierarchicalPathReachesGoalInWindingCluster",
+       TestHierarchicalPathReachesGoalInWindingCluster},
+      {"HierarchicalPathRebuildsOnlyDirtyClusters",
+       TestHierarchicalPathRebuildsOnlyDirtyClusters},
+      {"SwarmPreparesEveryTileAFastStepReaches",
+       TestSwarmPreparesEveryTileAFastStepReaches},
+      {"ParallelSwarmMatchesSerial", TestParallelSwarmMatchesSerial},
+      {"NetGridStateRoundTrip", TestNetGridStateRoundTrip},
+      {"TileHashMatchesScan", TestTileHashMatchesScan},
+      {"SmokeFieldMatchesReference", TestSmokeFieldMatchesReference},
+      {"SmokeFieldStaysBehindWalls", TestSmokeFieldStaysBehindWalls},
+      {"SmokeFieldStunsEnemies", TestSmokeFieldStunsEnemies},
+      {"Rules", TestRules},
+      {"PlayerStopsAtWalls", TestPlayerStopsAtWalls},
+      {"MoverIsFrameRateIndependent", TestMoverIsFrameRateIndependent},
+      {"StepDoesNotAllocate", TestStepDoesNotAllocate},
+      {"RestartMatchesReset", TestRestartMatchesReset},
+      {"MatchIsDeterministic", TestMatchIsDeterministic},
+  };
+
+  for (const auto &Test : Tests) {
+    const int Before = Failures;
+    Test.second();
+    std::printf("[%s] %s\n", Failures == Before ? " OK " : "FAIL", Test.first);
+  }
+  return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,521 @@
+// Headless batch runner for difficulty tuning.
+//
+// Plays many FSimWorld matches for every combination of the listed
+// parameter values, spread over all cores with a work-stealing pool, and
+// writes one aggregated CSV row per combination.
+//
+//   BangGuChaBatchSim --matches 10000 --move-speed 250,300,350
+//                     --stun 2,3 --wall 0.08,0.1,0.12 --policy seeker
+//                     --out sweep.csv
+//
+// Run with --help for every option.
+
+#include "BangGuChaSimWorld.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace BangGuChaSim;
+
+namespace {
+
+enum class EPolicy { Random, Scripted, Seeker };
+
+struct FOptions {
+  uint64_t MatchesPerCombo = 1000;
+  uint64_t BaseSeed = 1;
+  float MaxSeconds = 120.f;
+  int32_t MapWidth = 20;
+  int32_t MapHeight = 15;
+  size_t Threads = 0;
+  size_t MatchesPerTask = 64;
+  EPolicy Policy = EPolicy::Seeker;
+  EMapStyle Style = EMapStyle::Scatter;
+  EPathing Pathing = EPathing::JunctionGraph;
+  ESmokeModel SmokeModel = ESmokeModel::Clouds;
+  std::string OutPath = "batch_results.csv";
+
+  std::vector<float> MoveSpeeds = {300.f};
+  std::vector<float> StunDurations = {3.f};
+  std::vector<float> FuelRates = {5.f};
+  std::vector<float> WallChances = {0.1f};
+  std::vector<float> ItemChances = {0.05f};
+};
+
+struct FCombo {
+  float MoveSpeed;
+  float StunDuration;
+  float FuelRate;
+  float WallChance;
+  float ItemChance;
+};
+
+struct FTask {
+  size_t Combo = 0;
+  uint64_t FirstMatch = 0;
+  uint64_t NumMatches = 0;
+};
+
+struct FComboStats {
+  uint64_t Matches = 0;
+  uint64_t Wins = 0;
+  uint64_t Losses = 0;
+  uint64_t Timeouts = 0;
+  double TimeToDeathSum = 0.0;
+  double DurationSum = 0.0;
+  uint64_t FlagsCollected = 0;
+  uint64_t FlagsTotal = 0;
+  uint64_t Steps = 0;
+
+  void Merge(const FComboStats &Other) {
+    Matches += Other.Matches;
+    Wins += Other.Wins;
+    Losses += Other.Losses;
+    Timeouts += Other.Timeouts;
+    TimeToDeathSum += Other.TimeToDeathSum;
+    DurationSum += Other.DurationSum;
+    FlagsCollected += Other.FlagsCollected;
+    FlagsTotal += Other.FlagsTotal;
+    Steps += Other.Steps;
+  }
+};
+
+void PrintUsage() {
+  std::printf(
+      "Usage: BangGuChaBatchSim [options]\n"
+      "  --matches N          matches per parameter combination (1000)\n"
+      "  --move-speed LIST    player MoveSpeed values (300)\n"
+      "  --stun LIST          enemy StunDuration values (3)\n"
+      "  --fuel-rate LIST     FuelConsumptionRate values (5)\n"
+      "  --wall LIST          inner wall probabilities (0.1)\n"
+      "  --item LIST          flag probabilities (0.05)\n"
+      "  --map WxH            map size (20x15)\n"
+      "  --max-time SECONDS   simulated time limit per match (120)\n"
+      "  --policy NAME        random | scripted | seeker (seeker)\n"
+      "  --style NAME         scatter | backtracker | braided (scatter)\n"
+      "  --pathing NAME       graph | hpa | flow: enemy chase source (graph)\n"
+      "  --smoke NAME         clouds | field: how farts make smoke (clouds)\n"
+      "  --seed N             base seed; match i uses the same map seed in\n"
+      "                       every combination (1)\n"
+      "  --threads N          worker threads (all cores)\n"
+      "  --chunk N            matches per scheduled task (64)\n"
+      "  --out PATH           CSV output (batch_results.csv)\n"
+      "LIST is comma separated, e.g. 250,300,350\n");
+}
+
+bool ParseList(const char *Text, std::vector<float> &Out) {
+  Out.clear();
+  std::string Value(Text);
+  size_t Start = 0;
+  while (Start <= Value.size()) {
+    const size_t End = std::min(Value.find(',', Start), Value.size());
+    char *Parsed = nullptr;
+    const std::string Item = Value.substr(Start, End - Start);
+    const float Number = std::strtof(Item.c_str(), &Parsed);
+    if (Item.empty() || *Parsed != '\0')
+      return false;
+    Out.push_back(Number);
+    Start = End + 1;
+  }
+  return !Out.empty();
+}
+
+bool ParseOptions(int Argc, char **Argv, FOptions &Options) {
+  for (int i = 1; i < Argc; i++) {
+    const char *Arg = Argv[i];
+    const char *Value = i + 1 < Argc ? Argv[i + 1] : nullptr;
+    auto Is = [Arg](const char *Name) { return std::strcmp(Arg, Name) == 0; };
+
+    if (Is("--help") || Is("-h")) {
+      PrintUsage();
+      std::exit(0);
+    }
+    if (!Value) {
+      std::fprintf(stderr, "Missing value for %s\n", Arg);
+      return false;
+    }
+    i++;
+
+    bool bOk = true;
+    if (Is("--matches")) {
+      Options.MatchesPerCombo = std::strtoull(Value, nullptr, 10);
+    } else if (Is("--move-speed")) {
+      bOk = ParseList(Value, Options.MoveSpeeds);
+    } else if (Is("--stun")) {
+      bOk = ParseList(Value, Options.StunDurations);
+    } else if (Is("--fuel-rate")) {
+      bOk = ParseList(Value, Options.FuelRates);
+    } else if (Is("--wall")) {
+      bOk = ParseList(Value, Options.WallChances);
+    } else if (Is("--item")) {
+      bOk = ParseList(Value, Options.ItemChances);
+    } else if (Is("--map")) {
+      bOk = std::sscanf(Value, "%dx%d", &Options.MapWidth,
+                        &Options.MapHeight) == 2 &&
+            Options.MapWidth >= 4 && Options.MapHeight >= 4;
+    } else if (Is("--max-time")) {
+      Options.MaxSeconds = std::strtof(Value, nullptr);
+    } else if (Is("--policy")) {
+      if (std::strcmp(Value, "random") == 0)
+        Options.Policy = EPolicy::Random;
+      else if (std::strcmp(Value, "scripted") == 0)
+        Options.Policy = EPolicy::Scripted;
+      else if (std::strcmp(Value, "seeker") == 0)
+        Options.Policy = EPolicy::Seeker;
+      else
+        bOk = false;
+    } else if (Is("--style")) {
+      if (std::strcmp(Value, "scatter") == 0)
+        Options.Style = EMapStyle::Scatter;
+      else if (std::strcmp(Value, "backtracker") == 0)
+        Options.Style = EMapStyle::Backtracker;
+      else if (std::strcmp(Value, "braided") == 0)
+        Options.Style = EMapStyle::Braided;
+      else
+        bOk = false;
+    } else if (Is("--pathing")) {
+      if (std::strcmp(Value, "graph") == 0)
+        Options.Pathing = EPathing::JunctionGraph;
+      else if (std::strcmp(Value, "hpa") == 0)
+        Options.Pathing = EPathing::Hierarchical;
+      else if (std::strcmp(Value, "flow") == 0)
+        Options.Pathing = EPathing::FlowField;
+      else
+        bOk = false;
+    } else if (Is("--smoke")) {
+      if (std::strcmp(Value, "clouds") == 0)
+        Options.SmokeModel = ESmokeModel::Clouds;
+      else if (std::strcmp(Value, "field") == 0)
+        Options.SmokeModel = ESmokeModel::Field;
+      else
+        bOk = false;
+    } else if (Is("--seed")) {
+      Options.BaseSeed = std::strtoull(Value, nullptr, 10);
+    } else if (Is("--threads")) {
+      Options.Threads = std::strtoull(Value, nullptr, 10);
+    } else if (Is("--chunk")) {
+      Options.MatchesPerTask =
+          std::max<size_t>(1, std::strtoull(Value, nullptr, 10));
+    } else if (Is("--out")) {
+      Options.OutPath = Value;
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", Arg);
+      return false;
+    }
+
+    if (!bOk) {
+      std::fprintf(stderr, "Bad value for %s: %s\n", Arg, Value);
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *PolicyName(EPolicy Policy) {
+  switch (Policy) {
+  case EPolicy::Random:
+    return "random";
+  case EPolicy::Scripted:
+    return "scripted";
+  case EPolicy::Seeker:
+    return "seeker";
+  }
+  return "unknown";
+}
+
+const char *StyleName(EMapStyle Style) {
+  switch (Style) {
+  case EMapStyle::Scatter:
+    return "scatter";
+  case EMapStyle::Backtracker:
+    return "backtracker";
+  case EMapStyle::Braided:
+    return "braided";
+  }
+  return "unknown";
+}
+
+/**
+ * Player controllers. All decisions are taken from world state and a
+ * per-match RNG only, so every match is reproducible from its seed.
+ */
+class FPlayerPolicy {
+public:
+  FPlayerPolicy(EPolicy InPolicy, uint64_t Seed)
+      : Policy(InPolicy), Rng(FRandom::MixSeed(Seed, 0x504c4159)) {}
+
+  FSimInput Decide(const FSimWorld &World) {
+    switch (Policy) {
+    case EPolicy::Random:
+      return DecideRandom(World);
+    case EPolicy::Scripted:
+      return DecideScripted(World);
+    case EPolicy::Seeker:
+      return DecideSeeker(World);
+    }
+    return FSimInput();
+  }
+
+private:
+  static constexpr EDirection Dirs[4] = {EDirection::PosX, EDirection::NegX,
+                                         EDirection::PosY, EDirection::NegY};
+
+  FSimInput DecideRandom(const FSimWorld &World) {
+    FSimInput Input;
+    if (World.GetStepCount() % 15 == 0)
+      Input.Move = Dirs[Rng.NextUInt32() % 4];
+    Input.bFart = Rng.NextUInt32() % 90 == 0;
+    return Input;
+  }
+
+  // Fixed turn cycle with periodic smoke, identical for every map
+  FSimInput DecideScripted(const FSimWorld &World) {
+    static constexpr EDirection Cycle[4] = {EDirection::PosY, EDirection::PosX,
+                                            EDirection::NegY, EDirection::NegX};
+    const uint64_t Step = World.GetStepCount();
+    FSimInput Input;
+    if (Step % 40 == 0)
+      Input.Move = Cycle[(Step / 40) % 4];
+    Input.bFart = Step % 150 == 75;
+    return Input;
+  }
+
+  // Walks the shortest path to the nearest flag and drops smoke when an
+  // enemy gets within two tiles.
+  FSimInput DecideSeeker(const FSimWorld &World) {
+    const FSimConfig &Config = World.GetConfig();
+    const FMover &Mover = World.GetPlayer().Mover;
+    FSimInput Input;
+
+    const float Danger = 2.f * Config.GridSize;
+    const FEnemySwarm &Enemies = World.GetEnemies();
+    for (size_t e = 0; e < Enemies.Num(); e++) {
+      if (!Enemies.bIsStunned[e] &&
+          std::fabs(Enemies.X[e] - Mover.X) < Danger &&
+          std::fabs(Enemies.Y[e] - Mover.Y) < Danger) {
+        Input.bFart = true;
+        break;
+      }
+    }
+
+    // Plan once per tile entered; the queued turn is taken on reaching
+    // that tile's center
+    if (Mover.Target != PlannedFrom || Mover.Direction == EDirection::None) {
+      PlannedFrom = Mover.Target;
+      Input.Move = FirstStepToNearestFlag(World, Mover.Target);
+    }
+    return Input;
+  }
+
+  EDirection FirstStepToNearestFlag(const FSimWorld &World, FTile From) {
+    const FOccupancyGrid &Walls = World.GetLayout().Walls;
+    const int32_t Width = Walls.GetWidth();
+    const size_t NumTiles = Walls.GetNumTiles();
+    if (!Walls.IsWalkable(From.X, From.Y))
+      return EDirection::None;
+
+    FlagMask.assign(NumTiles, 0);
+    for (const FTile &Flag : World.GetRemainingFlags())
+      FlagMask[static_cast<size_t>(Flag.Y) * Width + Flag.X] = 1;
+
+    // BFS remembering the first step taken out of From
+    FirstStep.assign(NumTiles, 0xff);
+    Queue.clear();
+    const size_t Start = static_cast<size_t>(From.Y) * Width + From.X;
+    FirstStep[Start] = 0;
+    Queue.push_back(static_cast<int32_t>(Start));
+    for (size_t Head = 0; Head < Queue.size(); Head++) {
+      const int32_t Index = Queue[Head];
+      if (FlagMask[Index])
+        return static_cast<EDirection>(FirstStep[Index]);
+      const int32_t X = Index % Width;
+      const int32_t Y = Index / Width;
+      for (EDirection Dir : Dirs) {
+        const int32_t NX = X + StepX(Dir);
+        const int32_t NY = Y + StepY(Dir);
+        if (!Walls.IsWalkable(NX, NY))
+          continue;
+        const int32_t NIndex = NY * Width + NX;
+        if (FirstStep[NIndex] != 0xff)
+          continue;
+        FirstStep[NIndex] = Index == static_cast<int32_t>(Start)
+                                ? static_cast<uint8_t>(Dir)
+                                : FirstStep[Index];
+        Queue.push_back(NIndex);
+      }
+    }
+    return EDirection::None;
+  }
+
+  EPolicy Policy;
+  FRandom Rng;
+  FTile PlannedFrom{-1, -1};
+  std::vector<uint8_t> FlagMask;
+  std::vector<uint8_t> FirstStep;
+  std::vector<int32_t> Queue;
+};
+
+constexpr EDirection FPlayerPolicy::Dirs[4];
+
+void PlayMatch(const FOptions &Options, const FCombo &Combo, uint64_t Seed,
+               FSimWorld &World, FComboStats &Stats) {
+  FSimConfig Config;
+  Config.Map.Width = Options.MapWidth;
+  Config.Map.Height = Options.MapHeight;
+  Config.Map.WallChance = Combo.WallChance;
+  Config.Map.ItemChance = Combo.ItemChance;
+  Config.Map.Style = Options.Style;
+  Config.PlayerMoveSpeed = Combo.MoveSpeed;
+  Config.StunDuration = Combo.StunDuration;
+  Config.FuelConsumptionRate = Combo.FuelRate;
+  Config.Pathing = Options.Pathing;
+  Config.SmokeModel = Options.SmokeModel;
+
+  World.Reset(Config, Seed);
+  FPlayerPolicy Policy(Options.Policy, Seed);
+
+  const uint64_t MaxSteps = static_cast<uint64_t>(
+      std::ceil(Options.MaxSeconds / Config.FixedDeltaTime));
+  while (World.GetStepCount() < MaxSteps &&
+         World.Step(Policy.Decide(World)) == EMatchState::Running) {
+  }
+
+  Stats.Matches++;
+  Stats.Steps += World.GetStepCount();
+  Stats.DurationSum += World.GetElapsedTime();
+  Stats.FlagsCollected += static_cast<uint64_t>(World.GetCollectedFlags());
+  Stats.FlagsTotal += static_cast<uint64_t>(World.GetTotalFlags());
+  switch (World.GetState()) {
+  case EMatchState::Won:
+    Stats.Wins++;
+    break;
+  case EMatchState::Lost:
+    Stats.Losses++;
+    Stats.TimeToDeathSum += World.GetElapsedTime();
+    break;
+  case EMatchState::Running:
+    Stats.Timeouts++;
+    break;
+  }
+}
+
+double Ratio(double Numerator, uint64_t Denominator) {
+  return Denominator > 0 ? Numerator / static_cast<double>(Denominator) : 0.0;
+}
+
+} // namespace
+
+int main(int Argc, char **Argv) {
+  FOptions Options;
+  if (!ParseOptions(Argc, Argv, Options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<FCombo> Combos;
+  for (float MoveSpeed : Options.MoveSpeeds)
+    for (float Stun : Options.StunDurations)
+      for (float FuelRate : Options.FuelRates)
+        for (float Wall : Options.WallChances)
+          for (float Item : Options.ItemChances)
+            Combos.push_back(FCombo{MoveSpeed, Stun, FuelRate, Wall, Item});
+
+  const size_t NumWorkers =
+      Options.Threads > 0
+          ? Options.Threads
+          : std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  BangGuChaTools::TWorkStealingPool<FTask> Pool(NumWorkers);
+  for (size_t Combo = 0; Combo < Combos.size(); Combo++) {
+    for (uint64_t First = 0; First < Options.MatchesPerCombo;
+         First += Options.MatchesPerTask) {
+      Pool.Add(FTask{Combo, First,
+                     std::min<uint64_t>(Options.MatchesPerTask,
+                                        Options.MatchesPerCombo - First)});
+    }
+  }
+
+  // Per-worker accumulators, merged once at the end
+  std::vector<std::vector<FComboStats>> WorkerStats(
+      NumWorkers, std::vector<FComboStats>(Combos.size()));
+
+  const auto StartTime = std::chrono::steady_clock::now();
+  const size_t Steals =
+      Pool.Run([&](size_t Worker, const FTask &Task) {
+        FSimWorld World;
+        FComboStats &Stats = WorkerStats[Worker][Task.Combo];
+        for (uint64_t Match = Task.FirstMatch;
+             Match < Task.FirstMatch + Task.NumMatches; Match++) {
+          PlayMatch(Options, Combos[Task.Combo],
+                    FRandom::MixSeed(Options.BaseSeed, Match), World, Stats);
+        }
+      });
+  const double Seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - StartTime)
+                             .count();
+
+  std::FILE *Out = std::fopen(Options.OutPath.c_str(), "w");
+  if (!Out) {
+    std::fprintf(stderr, "Cannot open %s for writing\n",
+                 Options.OutPath.c_str());
+    return 1;
+  }
+  std::fprintf(Out, "policy,style,map_width,map_height,move_speed,"
+                    "stun_duration,"
+                    "fuel_rate,wall_chance,item_chance,matches,wins,losses,"
+                    "timeouts,win_rate,mean_time_to_death,mean_duration,"
+                    "mean_flags_collected,mean_flags_total\n");
+
+  uint64_t TotalMatches = 0;
+  uint64_t TotalSteps = 0;
+  for (size_t Combo = 0; Combo < Combos.size(); Combo++) {
+    FComboStats Stats;
+    for (const std::vector<FComboStats> &PerWorker : WorkerStats)
+      Stats.Merge(PerWorker[Combo]);
+    TotalMatches += Stats.Matches;
+    TotalSteps += Stats.Steps;
+
+    const FCombo &C = Combos[Combo];
+    std::fprintf(Out,
+                 "%s,%s,%d,%d,%g,%g,%g,%g,%g,%llu,%llu,%llu,%llu,%.6f,%.4f,"
+                 "%.4f,%.4f,%.4f\n",
+                 PolicyName(Options.Policy), StyleName(Options.Style),
+                 Options.MapWidth,
+                 Options.MapHeight, C.MoveSpeed, C.StunDuration, C.FuelRate,
+                 C.WallChance, C.ItemChance,
+                 static_cast<unsigned long long>(Stats.Matches),
+                 static_cast<unsigned long long>(Stats.Wins),
+                 static_cast<unsigned long long>(Stats.Losses),
+                 static_cast<unsigned long long>(Stats.Timeouts),
+                 Ratio(static_cast<double>(Stats.Wins), Stats.Matches),
+                 Ratio(Stats.TimeToDeathSum, Stats.Losses),
+                 Ratio(Stats.DurationSum, Stats.Matches),
+                 Ratio(static_cast<double>(Stats.FlagsCollected),
+                       Stats.Matches),
+                 Ratio(static_cast<double>(Stats.FlagsTotal), Stats.Matches));
+  }
+  std::fclose(Out);
+
+  const double MatchesPerSecond =
+      static_cast<double>(TotalMatches) / std::max(Seconds, 1e-9);
+  std::printf("combinations        %zu\n", Combos.size());
+  std::printf("matches             %llu\n",
+              static_cast<unsigned long long>(TotalMatches));
+  std::printf("simulated steps     %llu\n",
+              static_cast<unsigned long long>(TotalSteps));
+  std::printf("workers             %zu (steals: %zu)\n", NumWorkers, Steals);
+  std::printf("wall time           %.3f s\n", Seconds);
+  std::printf("matches/s           %.1f\n", MatchesPerSecond);
+  std::printf("matches/s/core      %.1f\n",
+              MatchesPerSecond / static_cast<double>(NumWorkers));
+  std::printf("results             %s\n", Options.OutPath.c_str());
+  return 0;
+}
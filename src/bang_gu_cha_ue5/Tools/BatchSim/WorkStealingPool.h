@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BangGuChaTools {
+
+/**
+ * Minimal work-stealing pool for batches of independent tasks.
+ *
+ * Tasks are dealt round-robin onto per-worker deques before the run starts.
+ * A worker pops from the back of its own deque and, once it runs dry,
+ * steals from the front of the others, so uneven task costs (short losses
+ * vs. long timeouts) still keep every core busy. Tasks may not spawn more
+ * tasks; that keeps termination trivial.
+ */
+template <typename TaskType> class TWorkStealingPool {
+public:
+  using FWorkFn = std::function<void(size_t WorkerIndex, const TaskType &)>;
+
+  explicit TWorkStealingPool(size_t InNumWorkers)
+      : Queues(InNumWorkers > 0 ? InNumWorkers : 1) {}
+
+  size_t GetNumWorkers() const { return Queues.size(); }
+
+  void Add(const TaskType &Task) {
+    Queues[NextQueue].Tasks.push_back(Task);
+    NextQueue = (NextQueue + 1) % Queues.size();
+  }
+
+  // Runs every queued task and returns the number of successful steals.
+  size_t Run(const FWorkFn &Work) {
+    std::atomic<size_t> Steals{0};
+    std::vector<std::thread> Threads;
+    Threads.reserve(Queues.size());
+    for (size_t Worker = 0; Worker < Queues.size(); Worker++) {
+      Threads.emplace_back([this, Worker, &Work, &Steals] {
+        TaskType Task;
+        while (true) {
+          if (PopLocal(Worker, Task)) {
+            Work(Worker, Task);
+          } else if (Steal(Worker, Task)) {
+            Steals.fetch_add(1, std::memory_order_relaxed);
+            Work(Worker, Task);
+          } else {
+            break;
+          }
+        }
+      });
+    }
+    for (std::thread &Thread : Threads)
+      Thread.join();
+    return Steals.load();
+  }
+
+private:
+  struct FQueue {
+    std::mutex Mutex;
+    std::deque<TaskType> Tasks;
+  };
+
+  bool PopLocal(size_t Worker, TaskType &Out) {
+    FQueue &Queue = Queues[Worker];
+    std::lock_guard<std::mutex> Lock(Queue.Mutex);
+    if (Queue.Tasks.empty())
+      return false;
+    Out = Queue.Tasks.back();
+    Queue.Tasks.pop_back();
+    return true;
+  }
+
+  bool Steal(size_t Thief, TaskType &Out) {
+    for (size_t Offset = 1; Offset < Queues.size(); Offset++) {
+      FQueue &Victim = Queues[(Thief + Offset) % Queues.size()];
+      std::lock_guard<std::mutex> Lock(Victim.Mutex);
+      if (Victim.Tasks.empty())
+        continue;
+      Out = Victim.Tasks.front();
+      Victim.Tasks.pop_front();
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<FQueue> Queues;
+  size_t NextQueue = 0;
+};
+
+} // namespace BangGuChaTools
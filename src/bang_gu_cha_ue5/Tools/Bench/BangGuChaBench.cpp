@@ -0,0 +1,898 @@
+// Microbenchmarks for the gameplay hot paths, run on the headless sim core.
+//
+//   can_move_to        FOccupancyGrid::IsWalkable, behind CanActorMoveTo
+//   choose_direction   ChooseEnemyDirection with a ready flow field
+//   player_step        StepPlayerMover, the pawn's UpdateMovement
+//   swarm_advance      FEnemySwarm::Advance, per enemy per step
+//   swarm_advance_mt   FEnemySwarm::AdvanceParallel on --threads workers
+//   overlaps_scan      one frame of flag, smoke and catch overlaps by
+//                      testing every pair, per enemy
+//   overlaps_grid      the same frame with the flags in an FTileHash, as
+//                      FSimWorld and the grid overlap mode resolve it
+//   flow_field         full FFlowField rebuild toward a new goal
+//   smoke_field        FSmokeField::Step with smoke on every open tile
+//   junction_graph     FJunctionGraph::Build for the whole map
+//   junction_step      FJunctionGraph::GetStep with the goal's trees cached
+//   hpa_build          FHierarchicalPath::Build for the whole map
+//   hpa_goal           FHierarchicalPath::SetGoal toward a new goal, then
+//                      Prepare for 64 tiles spread over the map
+//   hpa_step           FHierarchicalPath::GetStep with every cluster prepared
+//   generate_scatter   GenerateLayout with the default rules
+//   level_load         memory-map a cached level file and LoadLevel it,
+//                      to compare with generate_scatter
+//   generate_braided   GenerateLayout with a braided maze
+//   match_reset        FSimWorld::Reset, a new match from the seed up
+//   match_restart      FSimWorld::Restart after a minute of play, the
+//                      in-place restart to compare with match_reset
+//
+// Every benchmark runs for each map size and the swarm benches also for each
+// enemy count. Results are one CSV row (or JSON object) per case. With
+// --baseline, rows whose ns_per_op grew past --tolerance are reported and
+// the exit code is 2.
+//
+//   BangGuChaBench --out bench.csv
+//   BangGuChaBench --baseline bench.csv --tolerance 0.15
+//
+// Run with --help for every option.
+
+#include "BangGuChaSimEnemySwarm.h"
+#include "BangGuChaSimFlowField.h"
+#include "BangGuChaSimHierarchicalPath.h"
+#include "BangGuChaSimJunctionGraph.h"
+#include "BangGuChaSimLevelFile.h"
+#include "BangGuChaSimMapGen.h"
+#include "BangGuChaSimRules.h"
+#include "BangGuChaSimSmokeField.h"
+#include "BangGuChaSimTileHash.h"
+#include "BangGuChaSimWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace BangGuChaSim;
+
+namespace {
+
+struct FMapSize {
+  int32_t Width;
+  int32_t Height;
+};
+
+struct FOptions {
+  std::vector<FMapSize> Maps = {
+      {20, 15}, {64, 64}, {256, 256}, {1024, 1024}, {4096, 4096}};
+  std::vector<int32_t> EnemyCounts = {2, 10, 100, 1000, 10000};
+  double MinMs = 200.0;
+  std::string Filter;
+  bool bJson = false;
+  std::string OutPath;
+  std::string BaselinePath;
+  double Tolerance = 0.1;
+  uint64_t Seed = 1;
+  int32_t Threads =
+      std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+};
+
+struct FResult {
+  std::string Benchmark;
+  FMapSize Map;
+  int32_t Enemies;
+  uint64_t Iterations;
+  double Seconds;
+  uint64_t Ops;
+
+  double NsPerOp() const {
+    return Ops > 0 ? Seconds * 1e9 / static_cast<double>(Ops) : 0.0;
+  }
+  double OpsPerSecond() const {
+    return Seconds > 0.0 ? static_cast<double>(Ops) / Seconds : 0.0;
+  }
+};
+
+using FResultKey = std::tuple<std::string, int32_t, int32_t, int32_t>;
+
+FResultKey KeyOf(const FResult &Result) {
+  return FResultKey(Result.Benchmark, Result.Map.Width, Result.Map.Height,
+                    Result.Enemies);
+}
+
+void PrintUsage() {
+  std::printf(
+      "Usage: BangGuChaBench [options]\n"
+      "  --maps LIST          WxH sizes (20x15,64x64,256x256,1024x1024,\n"
+      "                       4096x4096)\n"
+      "  --enemies LIST       swarm sizes (2,10,100,1000,10000)\n"
+      "  --min-time MS        minimum timed run per case (200)\n"
+      "  --filter TEXT        only benchmarks whose name contains TEXT\n"
+      "  --format NAME        csv | json (csv)\n"
+      "  --out PATH           write results here instead of stdout\n"
+      "  --baseline PATH      earlier CSV output to compare against\n"
+      "  --tolerance F        allowed ns_per_op growth, 0.1 = 10%% (0.1)\n"
+      "  --seed N             map seed (1)\n"
+      "  --threads N          workers for the _mt cases (all cores)\n"
+      "  --quick              small maps and swarms, short runs (smoke test)\n"
+      "LIST is comma separated\n");
+}
+
+std::vector<std::string> Split(const std::string &Text, char Separator) {
+  std::vector<std::string> Parts;
+  size_t Start = 0;
+  while (Start <= Text.size()) {
+    const size_t End = std::min(Text.find(Separator, Start), Text.size());
+    Parts.push_back(Text.substr(Start, End - Start));
+    Start = End + 1;
+  }
+  return Parts;
+}
+
+bool ParseOptions(int Argc, char **Argv, FOptions &Options) {
+  for (int i = 1; i < Argc; i++) {
+    const char *Arg = Argv[i];
+    auto Is = [Arg](const char *Name) { return std::strcmp(Arg, Name) == 0; };
+
+    if (Is("--help") || Is("-h")) {
+      PrintUsage();
+      std::exit(0);
+    }
+    if (Is("--quick")) {
+      Options.Maps = {{20, 15}, {64, 64}};
+      Options.EnemyCounts = {2, 100};
+      Options.MinMs = 5.0;
+      Options.Threads = 2;
+      continue;
+    }
+    if (i + 1 >= Argc) {
+      std::fprintf(stderr, "Missing value for %s\n", Arg);
+      return false;
+    }
+    const char *Value = Argv[++i];
+
+    bool bOk = true;
+    if (Is("--maps")) {
+      Options.Maps.clear();
+      for (const std::string &Item : Split(Value, ',')) {
+        FMapSize Size{0, 0};
+        bOk = bOk &&
+              std::sscanf(Item.c_str(), "%dx%d", &Size.Width, &Size.Height) ==
+                  2 &&
+              Size.Width >= 8 && Size.Height >= 8;
+        Options.Maps.push_back(Size);
+      }
+    } else if (Is("--enemies")) {
+      Options.EnemyCounts.clear();
+      for (const std::string &Item : Split(Value, ',')) {
+        const int32_t Count = std::atoi(Item.c_str());
+        bOk = bOk && Count > 0;
+        Options.EnemyCounts.push_back(Count);
+      }
+    } else if (Is("--min-time")) {
+      Options.MinMs = std::strtod(Value, nullptr);
+    } else if (Is("--filter")) {
+      Options.Filter = Value;
+    } else if (Is("--format")) {
+      Options.bJson = std::strcmp(Value, "json") == 0;
+      bOk = Options.bJson || std::strcmp(Value, "csv") == 0;
+    } else if (Is("--out")) {
+      Options.OutPath = Value;
+    } else if (Is("--baseline")) {
+      Options.BaselinePath = Value;
+    } else if (Is("--tolerance")) {
+      Options.Tolerance = std::strtod(Value, nullptr);
+    } else if (Is("--seed")) {
+      Options.Seed = std::strtoull(Value, nullptr, 10);
+    } else if (Is("--threads")) {
+      Options.Threads = std::atoi(Value);
+      bOk = Options.Threads > 0;
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", Arg);
+      return false;
+    }
+
+    if (!bOk) {
+      std::fprintf(stderr, "Bad value for %s: %s\n", Arg, Value);
+      return false;
+    }
+  }
+  return !Options.Maps.empty() && !Options.EnemyCounts.empty();
+}
+
+// Keeps results alive so the optimizer cannot drop the measured work
+volatile uint64_t Sink = 0;
+
+/**
+ * Calls Body (which returns the ops it performed) until MinMs has passed,
+ * after one untimed warm-up call. Slow cases still get one timed call.
+ */
+FResult Measure(const std::string &Name, FMapSize Map, int32_t Enemies,
+                double MinMs, const std::function<uint64_t()> &Body) {
+  Body();
+
+  FResult Result{Name, Map, Enemies, 0, 0.0, 0};
+  const auto Start = std::chrono::steady_clock::now();
+  do {
+    Result.Ops += Body();
+    Result.Iterations++;
+    Result.Seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - Start)
+                         .count();
+  } while (Result.Seconds * 1000.0 < MinMs);
+  return Result;
+}
+
+// Open tiles in a fixed pseudo-random order, shared by the query benches
+std::vector<FTile> SampleOpenTiles(const FOccupancyGrid &Grid, size_t Count,
+                                   FRandom &Rng) {
+  std::vector<FTile> Tiles;
+  Tiles.reserve(Count);
+  for (size_t Attempt = 0; Tiles.size() < Count && Attempt < Count * 64;
+       Attempt++) {
+    const FTile Tile{Rng.RandRange(1, Grid.GetWidth() - 2),
+                     Rng.RandRange(1, Grid.GetHeight() - 2)};
+    if (Grid.IsWalkable(Tile.X, Tile.Y))
+      Tiles.push_back(Tile);
+  }
+  if (Tiles.empty())
+    Tiles.push_back(FTile{1, 1});
+  return Tiles;
+}
+
+/**
+ * Read-only memory map of a whole file, the standalone stand-in for
+ * IPlatformFile::OpenMapped.
+ */
+class FMappedFile {
+public:
+  FMappedFile() = default;
+  FMappedFile(const FMappedFile &) = delete;
+  FMappedFile &operator=(const FMappedFile &) = delete;
+  ~FMappedFile() { Close(); }
+
+  bool Open(const std::string &Path) {
+    Close();
+#if defined(_WIN32)
+    File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER FileSize;
+    if (File == INVALID_HANDLE_VALUE || !GetFileSizeEx(File, &FileSize) ||
+        FileSize.QuadPart == 0)
+      return Close(), false;
+    Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    Data = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    Size = static_cast<size_t>(FileSize.QuadPart);
+#else
+    const int Fd = open(Path.c_str(), O_RDONLY);
+    struct stat Stat;
+    if (Fd < 0 || fstat(Fd, &Stat) != 0 || Stat.st_size == 0) {
+      if (Fd >= 0)
+        close(Fd);
+      return false;
+    }
+    Size = static_cast<size_t>(Stat.st_size);
+    Data = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, Fd, 0);
+    close(Fd);
+    if (Data == MAP_FAILED)
+      Data = nullptr;
+#endif
+    if (!Data)
+      Close();
+    return Data != nullptr;
+  }
+
+  void Close() {
+#if defined(_WIN32)
+    if (Data)
+      UnmapViewOfFile(Data);
+    if (Mapping)
+      CloseHandle(Mapping);
+    if (File != INVALID_HANDLE_VALUE)
+      CloseHandle(File);
+    Mapping = nullptr;
+    File = INVALID_HANDLE_VALUE;
+#else
+    if (Data)
+      munmap(Data, Size);
+#endif
+    Data = nullptr;
+    Size = 0;
+  }
+
+  const void *GetData() const { return Data; }
+  size_t GetSize() const { return Size; }
+
+private:
+  void *Data = nullptr;
+  size_t Size = 0;
+#if defined(_WIN32)
+  HANDLE File = INVALID_HANDLE_VALUE;
+  HANDLE Mapping = nullptr;
+#endif
+};
+
+/**
+ * Persistent workers for the _mt cases, so a step pays for a wake-up rather
+ * than for thread creation. The calling thread takes indices too and
+ * ParallelFor returns once every index has run.
+ */
+class FWorkerPool {
+public:
+  explicit FWorkerPool(int32_t NumThreads) {
+    for (int32_t i = 1; i < NumThreads; i++)
+      Threads.emplace_back([this]() { WorkerLoop(); });
+  }
+
+  ~FWorkerPool() {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      bStop = true;
+    }
+    Wake.notify_all();
+    for (std::thread &Thread : Threads)
+      Thread.join();
+  }
+
+  void ParallelFor(int32_t Num, const std::function<void(int32_t)> &Body) {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Job = &Body;
+      JobSize = Num;
+      Next.store(0);
+      Busy = Threads.size();
+      Generation++;
+    }
+    Wake.notify_all();
+    RunJob(Body, Num);
+
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Done.wait(Lock, [this]() { return Busy == 0; });
+  }
+
+private:
+  void RunJob(const std::function<void(int32_t)> &Body, int32_t Num) {
+    for (int32_t Index = Next.fetch_add(1); Index < Num;
+         Index = Next.fetch_add(1))
+      Body(Index);
+  }
+
+  void WorkerLoop() {
+    uint64_t Seen = 0;
+    for (;;) {
+      const std::function<void(int32_t)> *Body = nullptr;
+      int32_t Num = 0;
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Wake.wait(Lock, [&]() { return bStop || Generation != Seen; });
+        if (bStop)
+          return;
+        Seen = Generation;
+        Body = Job;
+        Num = JobSize;
+      }
+      RunJob(*Body, Num);
+
+      std::lock_guard<std::mutex> Lock(Mutex);
+      if (--Busy == 0)
+        Done.notify_one();
+    }
+  }
+
+  std::vector<std::thread> Threads;
+  std::mutex Mutex;
+  std::condition_variable Wake;
+  std::condition_variable Done;
+  const std::function<void(int32_t)> *Job = nullptr;
+  int32_t JobSize = 0;
+  std::atomic<int32_t> Next{0};
+  size_t Busy = 0;
+  uint64_t Generation = 0;
+  bool bStop = false;
+};
+
+class FBenchSuite {
+public:
+  explicit FBenchSuite(const FOptions &InOptions)
+      : Options(InOptions), Workers(InOptions.Threads) {}
+
+  std::vector<FResult> Run() {
+    for (const FMapSize &Map : Options.Maps) {
+      PrepareMap(Map);
+      RunMapBenches(Map);
+      for (int32_t Enemies : Options.EnemyCounts) {
+        RunSwarmBench(Map, Enemies);
+        RunOverlapBench(Map, Enemies);
+      }
+    }
+    return Results;
+  }
+
+private:
+  bool IsSelected(const char *Name) const {
+    return Options.Filter.empty() ||
+           std::strstr(Name, Options.Filter.c_str()) != nullptr;
+  }
+
+  void Add(const FResult &Result) {
+    Results.push_back(Result);
+    std::fprintf(stderr, "  %-18s %5dx%-5d %6d enemies  %12.2f ns/op\n",
+                 Result.Benchmark.c_str(), Result.Map.Width,
+                 Result.Map.Height, Result.Enemies, Result.NsPerOp());
+  }
+
+  void PrepareMap(FMapSize Map) {
+    Params = FMapParams();
+    Params.Width = Map.Width;
+    Params.Height = Map.Height;
+    FRandom Rng(Options.Seed);
+    GenerateLayout(Params, Rng, Layout);
+
+    FlowField.Init(&Layout.Walls);
+    FlowField.SetGoal(Layout.PlayerStart);
+    FlowField.Update(INT_MAX);
+
+    FRandom SampleRng(FRandom::MixSeed(Options.Seed, 1));
+    OpenTiles = SampleOpenTiles(Layout.Walls, 4096, SampleRng);
+  }
+
+  void RunMapBenches(FMapSize Map) {
+    const FOccupancyGrid &Walls = Layout.Walls;
+    const float GridSize = 100.f;
+
+    if (IsSelected("can_move_to")) {
+      // Four neighbour checks per tile, as a mover does at a tile center
+      Add(Measure("can_move_to", Map, 0, Options.MinMs, [&]() {
+        uint64_t Open = 0;
+        for (const FTile &Tile : OpenTiles) {
+          Open += Walls.IsWalkable(Tile.X + 1, Tile.Y);
+          Open += Walls.IsWalkable(Tile.X - 1, Tile.Y);
+          Open += Walls.IsWalkable(Tile.X, Tile.Y + 1);
+          Open += Walls.IsWalkable(Tile.X, Tile.Y - 1);
+        }
+        Sink = Sink + Open;
+        return static_cast<uint64_t>(OpenTiles.size() * 4);
+      }));
+    }
+
+    if (IsSelected("choose_direction")) {
+      const float PlayerX = Layout.PlayerStart.X * GridSize;
+      const float PlayerY = Layout.PlayerStart.Y * GridSize;
+      auto CanEnter = [&](int32_t X, int32_t Y) {
+        return Walls.IsWalkable(X, Y);
+      };
+      Add(Measure("choose_direction", Map, 0, Options.MinMs, [&]() {
+        uint64_t Sum = 0;
+        for (const FTile &Tile : OpenTiles) {
+          Sum += static_cast<uint64_t>(ChooseEnemyDirection(
+              Tile, Tile.X * GridSize, Tile.Y * GridSize, EDirection::PosX,
+              PlayerX, PlayerY, nullptr, nullptr, &FlowField, CanEnter));
+        }
+        Sink = Sink + Sum;
+        return static_cast<uint64_t>(OpenTiles.size());
+      }));
+    }
+
+    if (IsSelected("player_step")) {
+      FMover Mover;
+      InitMover(Mover, GridSize, GridSize, GridSize);
+      uint64_t Step = 0;
+      static constexpr EDirection Turns[4] = {
+          EDirection::PosY, EDirection::PosX, EDirection::NegY,
+          EDirection::NegX};
+      auto CanEnter = [&](int32_t X, int32_t Y) {
+        return Walls.IsWalkable(X, Y);
+      };
+      Add(Measure("player_step", Map, 0, Options.MinMs, [&]() {
+        for (int32_t i = 0; i < 1024; i++, Step++) {
+          if (Step % 30 == 0)
+            Mover.NextDirection = Turns[(Step / 30) % 4];
+          StepPlayerMover(Mover, 1.f / 60.f, 300.f, GridSize, CanEnter);
+        }
+        Sink = Sink + static_cast<uint64_t>(Mover.X);
+        return uint64_t(1024);
+      }));
+    }
+
+    if (IsSelected("flow_field")) {
+      // Alternate goals so every call is a real rebuild
+      FFlowField Field;
+      Field.Init(&Walls);
+      size_t Next = 0;
+      Add(Measure("flow_field", Map, 0, Options.MinMs, [&]() {
+        Field.SetGoal(OpenTiles[Next++ % OpenTiles.size()]);
+        Field.Update(INT_MAX);
+        return uint64_t(1);
+      }));
+    }
+
+    if (IsSelected("smoke_field")) {
+      // No fade, so every row stays in play for the whole run
+      FSmokeField Field;
+      Field.Init(Walls);
+      for (const FTile &Tile : OpenTiles)
+        Field.Deposit(Tile.X, Tile.Y, 1.f);
+      Add(Measure("smoke_field", Map, 0, Options.MinMs, [&]() {
+        Field.Step(1.f / 60.f, 2.f, 0.f);
+        return uint64_t(1);
+      }));
+      Sink = Sink + static_cast<uint64_t>(Field.GetTotal());
+    }
+
+    if (IsSelected("junction_graph")) {
+      FJunctionGraph Graph;
+      Add(Measure("junction_graph", Map, 0, Options.MinMs, [&]() {
+        Graph.Build(Walls);
+        Sink = Sink + Graph.GetNumEdges();
+        return uint64_t(1);
+      }));
+    }
+
+    if (IsSelected("junction_step")) {
+      FJunctionGraph Graph;
+      Graph.Build(Walls);
+      Graph.SetGoal(Layout.PlayerStart);
+      Add(Measure("junction_step", Map, 0, Options.MinMs, [&]() {
+        uint64_t Sum = 0;
+        for (const FTile &Tile : OpenTiles)
+          Sum += static_cast<uint64_t>(Graph.GetStep(Tile, EDirection::None));
+        Sink = Sink + Sum;
+        return static_cast<uint64_t>(OpenTiles.size());
+      }));
+    }
+
+    if (IsSelected("hpa_build")) {
+      FHierarchicalPath Path;
+      Add(Measure("hpa_build", Map, 0, Options.MinMs, [&]() {
+        Path.Build(&Walls);
+        Sink = Sink + Path.GetNumEntrances();
+        return uint64_t(1);
+      }));
+    }
+
+    if (IsSelected("hpa_goal")) {
+      // Alternate goals so every call is a real search, out to as many
+      // clusters as a crowd of enemies would ask about
+      FHierarchicalPath Path;
+      Path.Build(&Walls);
+      size_t Next = 0;
+      const size_t NumPrepared = std::min<size_t>(64, OpenTiles.size());
+      Add(Measure("hpa_goal", Map, 0, Options.MinMs, [&]() {
+        Path.SetGoal(OpenTiles[Next++ % OpenTiles.size()]);
+        for (size_t i = 0; i < NumPrepared; i++)
+          Path.Prepare(OpenTiles[i]);
+        return uint64_t(1);
+      }));
+    }
+
+    if (IsSelected("hpa_step")) {
+      FHierarchicalPath Path;
+      Path.Build(&Walls);
+      Path.SetGoal(Layout.PlayerStart);
+      for (const FTile &Tile : OpenTiles)
+        Path.Prepare(Tile);
+      Add(Measure("hpa_step", Map, 0, Options.MinMs, [&]() {
+        uint64_t Sum = 0;
+        for (const FTile &Tile : OpenTiles)
+          Sum += static_cast<uint64_t>(Path.GetStep(Tile));
+        Sink = Sink + Sum;
+        return static_cast<uint64_t>(OpenTiles.size());
+      }));
+    }
+
+    if (IsSelected("generate_scatter") || IsSelected("generate_braided")) {
+      FMapLayout Scratch;
+      uint64_t Seed = Options.Seed;
+      for (EMapStyle Style : {EMapStyle::Scatter, EMapStyle::Braided}) {
+        const char *Name = Style == EMapStyle::Scatter ? "generate_scatter"
+                                                       : "generate_braided";
+        if (!IsSelected(Name))
+          continue;
+        FMapParams StyleParams = Params;
+        StyleParams.Style = Style;
+        Add(Measure(Name, Map, 0, Options.MinMs, [&]() {
+          FRandom Rng(Seed++);
+          GenerateLayout(StyleParams, Rng, Scratch);
+          return uint64_t(1);
+        }));
+      }
+    }
+
+    if (IsSelected("level_load")) {
+      // A cache entry for this map, as GenerateMap would leave behind.
+      // Every call maps, validates and copies out the whole file.
+      const uint64_t Key = MakeLevelCacheKey(Params, Options.Seed);
+      const std::filesystem::path Path =
+          std::filesystem::temp_directory_path() / GetLevelCacheFileName(Key);
+      std::vector<uint8_t> Bytes;
+      WriteLevel(Layout, Options.Seed, Key, Bytes);
+      if (FILE *File = std::fopen(Path.string().c_str(), "wb")) {
+        const bool bWritten =
+            std::fwrite(Bytes.data(), 1, Bytes.size(), File) == Bytes.size();
+        std::fclose(File);
+        FMapLayout Loaded;
+        if (bWritten) {
+          Add(Measure("level_load", Map, 0, Options.MinMs, [&]() {
+            FMappedFile Mapped;
+            FLevelView View;
+            if (Mapped.Open(Path.string()) &&
+                View.Parse(Mapped.GetData(), Mapped.GetSize()) &&
+                LoadLevel(View, Loaded))
+              Sink = Sink + Loaded.Flags.size();
+            return uint64_t(1);
+          }));
+        }
+        std::remove(Path.string().c_str());
+      }
+    }
+
+    if (IsSelected("match_reset") || IsSelected("match_restart")) {
+      FSimConfig Config;
+      Config.Map = Params;
+      FSimWorld World;
+      if (IsSelected("match_reset")) {
+        Add(Measure("match_reset", Map, 0, Options.MinMs, [&]() {
+          World.Reset(Config, Options.Seed);
+          Sink = Sink + World.GetTotalFlags();
+          return uint64_t(1);
+        }));
+      }
+      if (IsSelected("match_restart")) {
+        // Standing still with a fart now and then dirties the enemies,
+        // flags and smoke a restart has to put back
+        World.Reset(Config, Options.Seed);
+        for (int32_t Step = 0; Step < 60 * 60; Step++) {
+          FSimInput Input;
+          Input.bFart = Step % 120 == 0;
+          World.Step(Input);
+        }
+        Add(Measure("match_restart", Map, 0, Options.MinMs, [&]() {
+          World.Restart();
+          Sink = Sink + World.GetTotalFlags();
+          return uint64_t(1);
+        }));
+      }
+    }
+  }
+
+  void RunSwarmBench(FMapSize Map, int32_t Enemies) {
+    if (!IsSelected("swarm_advance") && !IsSelected("swarm_advance_mt"))
+      return;
+
+    // Spawns spread over the whole map; the flow field pulls them to the
+    // player start
+    const FEnemySwarmParams SwarmParams;
+    FEnemySwarm Swarm;
+    Swarm.Reserve(static_cast<size_t>(Enemies));
+    for (int32_t i = 0; i < Enemies; i++)
+      Swarm.Add(OpenTiles[static_cast<size_t>(i) % OpenTiles.size()],
+                SwarmParams.GridSize);
+
+    const float PlayerX = Layout.PlayerStart.X * SwarmParams.GridSize;
+    const float PlayerY = Layout.PlayerStart.Y * SwarmParams.GridSize;
+    const FEnemySwarm Start = Swarm;
+    if (IsSelected("swarm_advance")) {
+      Add(Measure("swarm_advance", Map, Enemies, Options.MinMs, [&]() {
+        for (int32_t Step = 0; Step < 16; Step++)
+          Swarm.Advance(1.f / 60.f, SwarmParams, PlayerX, PlayerY,
+                        Layout.Walls, &FlowField);
+        Sink = Sink + static_cast<uint64_t>(Swarm.X[0]);
+        return static_cast<uint64_t>(Enemies) * 16;
+      }));
+    }
+
+    if (!IsSelected("swarm_advance_mt"))
+      return;
+
+    // Same batch size as the enemy manager's default
+    Swarm = Start;
+    const FEnemySwarmSnapshot Snapshot{PlayerX, PlayerY, &Layout.Walls,
+                                       &FlowField};
+    auto ParallelFor = [this](int32_t Num, const auto &Body) {
+      Workers.ParallelFor(Num, Body);
+    };
+    Add(Measure("swarm_advance_mt", Map, Enemies, Options.MinMs, [&]() {
+      for (int32_t Step = 0; Step < 16; Step++)
+        Swarm.AdvanceParallel(1.f / 60.f, SwarmParams, Snapshot, 256,
+                              ParallelFor);
+      Sink = Sink + static_cast<uint64_t>(Swarm.X[0]);
+      return static_cast<uint64_t>(Enemies) * 16;
+    }));
+  }
+
+  void RunOverlapBench(FMapSize Map, int32_t Enemies) {
+    if (!IsSelected("overlaps_scan") && !IsSelected("overlaps_grid"))
+      return;
+
+    // Enemies and a full fuel tank of clouds spread over the map, with the
+    // player on its start tile
+    constexpr float GridSize = 100.f;
+    constexpr float FlagReach = 70.f;
+    constexpr float SmokeReach = 85.f;
+    constexpr float CatchReach = 80.f;
+    constexpr size_t NumSmokes = 10;
+    std::vector<float> EnemyX, EnemyY, SmokeX, SmokeY;
+    for (int32_t i = 0; i < Enemies; i++) {
+      const FTile &Tile = OpenTiles[static_cast<size_t>(i) % OpenTiles.size()];
+      EnemyX.push_back(Tile.X * GridSize);
+      EnemyY.push_back(Tile.Y * GridSize);
+    }
+    for (size_t i = 0; i < NumSmokes; i++) {
+      const FTile &Tile = OpenTiles[i * OpenTiles.size() / NumSmokes];
+      SmokeX.push_back(Tile.X * GridSize);
+      SmokeY.push_back(Tile.Y * GridSize);
+    }
+    const float PlayerX = Layout.PlayerStart.X * GridSize;
+    const float PlayerY = Layout.PlayerStart.Y * GridSize;
+
+    if (IsSelected("overlaps_scan")) {
+      Add(Measure("overlaps_scan", Map, Enemies, Options.MinMs, [&]() {
+        uint64_t Hits = 0;
+        for (const FTile &Flag : Layout.Flags)
+          Hits += Overlaps(PlayerX, PlayerY, Flag.X * GridSize,
+                           Flag.Y * GridSize, FlagReach);
+        for (size_t e = 0; e < EnemyX.size(); e++) {
+          for (size_t i = 0; i < NumSmokes; i++)
+            Hits += Overlaps(EnemyX[e], EnemyY[e], SmokeX[i], SmokeY[i],
+                             SmokeReach);
+          Hits += Overlaps(EnemyX[e], EnemyY[e], PlayerX, PlayerY, CatchReach);
+        }
+        Sink = Sink + Hits;
+        return static_cast<uint64_t>(Enemies);
+      }));
+    }
+
+    if (!IsSelected("overlaps_grid"))
+      return;
+
+    // Flags only rehash after a pickup, so that build is not timed
+    FTileHash FlagHash;
+    FlagHash.Reset(GridSize);
+    for (const FTile &Flag : Layout.Flags)
+      FlagHash.Add(Flag.X * GridSize, Flag.Y * GridSize);
+    FlagHash.Build();
+    Add(Measure("overlaps_grid", Map, Enemies, Options.MinMs, [&]() {
+      uint64_t Hits = 0;
+      FlagHash.ForEachNear(PlayerX, PlayerY, FlagReach, [&](uint32_t i) {
+        Hits += Overlaps(PlayerX, PlayerY, Layout.Flags[i].X * GridSize,
+                         Layout.Flags[i].Y * GridSize, FlagReach);
+      });
+      for (size_t e = 0; e < EnemyX.size(); e++) {
+        for (size_t i = 0; i < NumSmokes; i++)
+          Hits += Overlaps(EnemyX[e], EnemyY[e], SmokeX[i], SmokeY[i],
+                           SmokeReach);
+        Hits += Overlaps(EnemyX[e], EnemyY[e], PlayerX, PlayerY, CatchReach);
+      }
+      Sink = Sink + Hits;
+      return static_cast<uint64_t>(Enemies);
+    }));
+  }
+
+  const FOptions &Options;
+  FWorkerPool Workers;
+  FMapParams Params;
+  FMapLayout Layout;
+  FFlowField FlowField;
+  std::vector<FTile> OpenTiles;
+  std::vector<FResult> Results;
+};
+
+void WriteResults(std::FILE *Out, const std::vector<FResult> &Results,
+                  bool bJson) {
+  if (!bJson) {
+    std::fprintf(Out, "benchmark,map_width,map_height,enemies,iterations,"
+                      "seconds,ns_per_op,ops_per_second\n");
+  }
+  for (const FResult &Result : Results) {
+    const char *Format =
+        bJson ? "{\"benchmark\":\"%s\",\"map_width\":%d,\"map_height\":%d,"
+                "\"enemies\":%d,\"iterations\":%llu,\"seconds\":%.6f,"
+                "\"ns_per_op\":%.4f,\"ops_per_second\":%.1f}\n"
+              : "%s,%d,%d,%d,%llu,%.6f,%.4f,%.1f\n";
+    std::fprintf(Out, Format, Result.Benchmark.c_str(), Result.Map.Width,
+                 Result.Map.Height, Result.Enemies,
+                 static_cast<unsigned long long>(Result.Iterations),
+                 Result.Seconds, Result.NsPerOp(), Result.OpsPerSecond());
+  }
+}
+
+bool LoadBaseline(const std::string &Path,
+                  std::map<FResultKey, double> &NsPerOp) {
+  std::FILE *In = std::fopen(Path.c_str(), "r");
+  if (!In)
+    return false;
+
+  char Line[512];
+  while (std::fgets(Line, sizeof(Line), In)) {
+    const std::vector<std::string> Fields = Split(Line, ',');
+    if (Fields.size() < 7 || Fields[0] == "benchmark")
+      continue;
+    NsPerOp[FResultKey(Fields[0], std::atoi(Fields[1].c_str()),
+                       std::atoi(Fields[2].c_str()),
+                       std::atoi(Fields[3].c_str()))] =
+        std::strtod(Fields[6].c_str(), nullptr);
+  }
+  std::fclose(In);
+  return true;
+}
+
+// Prints every case slower than the baseline by more than Tolerance
+int32_t CompareToBaseline(const std::vector<FResult> &Results,
+                          const std::map<FResultKey, double> &Baseline,
+                          double Tolerance) {
+  int32_t Regressions = 0;
+  for (const FResult &Result : Results) {
+    const auto Found = Baseline.find(KeyOf(Result));
+    if (Found == Baseline.end() || Found->second <= 0.0)
+      continue;
+    const double Change = Result.NsPerOp() / Found->second - 1.0;
+    if (Change > Tolerance) {
+      std::fprintf(stderr,
+                   "REGRESSION %s %dx%d enemies=%d: %.2f -> %.2f ns/op "
+                   "(+%.1f%%)\n",
+                   Result.Benchmark.c_str(), Result.Map.Width,
+                   Result.Map.Height, Result.Enemies, Found->second,
+                   Result.NsPerOp(), Change * 100.0);
+      Regressions++;
+    }
+  }
+  return Regressions;
+}
+
+} // namespace
+
+int main(int Argc, char **Argv) {
+  FOptions Options;
+  if (!ParseOptions(Argc, Argv, Options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::map<FResultKey, double> Baseline;
+  if (!Options.BaselinePath.empty() &&
+      !LoadBaseline(Options.BaselinePath, Baseline)) {
+    std::fprintf(stderr, "Cannot read baseline %s\n",
+                 Options.BaselinePath.c_str());
+    return 1;
+  }
+
+  FBenchSuite Suite(Options);
+  const std::vector<FResult> Results = Suite.Run();
+
+  std::FILE *Out = Options.OutPath.empty()
+                       ? stdout
+                       : std::fopen(Options.OutPath.c_str(), "w");
+  if (!Out) {
+    std::fprintf(stderr, "Cannot open %s for writing\n",
+                 Options.OutPath.c_str());
+    return 1;
+  }
+  WriteResults(Out, Results, Options.bJson);
+  if (Out != stdout)
+    std::fclose(Out);
+
+  if (!Baseline.empty() &&
+      CompareToBaseline(Results, Baseline, Options.Tolerance) > 0)
+    return 2;
+  return 0;
+}
@@ -0,0 +1,193 @@
+// Microbenchmark for map generation and the reachability pass.
+//
+// For every map style, times layout generation alone, the word-parallel
+// FReachability validation, a tile-at-a-time BFS doing the same check, and
+// the full GenerateLayout including corridor repair. Reports the median
+// over all iterations, plus how many targets were sealed off before repair,
+// and exits non-zero if any flag or enemy spawn is unreachable after it.
+//
+//   BangGuChaMazeBench --size 1024 --iterations 20
+
+#include "BangGuChaSimMapGen.h"
+#include "BangGuChaSimReachability.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BangGuChaSim;
+
+namespace {
+
+struct FOptions {
+  int32_t Size = 1024;
+  int32_t Iterations = 20;
+  uint64_t Seed = 1;
+};
+
+void PrintUsage() {
+  std::printf("Usage: BangGuChaMazeBench [options]\n"
+              "  --size N         square map side in tiles (1024)\n"
+              "  --iterations N   timed runs per style (20)\n"
+              "  --seed N         base seed (1)\n");
+}
+
+bool ParseOptions(int Argc, char **Argv, FOptions &Options) {
+  for (int i = 1; i < Argc; i++) {
+    const char *Arg = Argv[i];
+    if (std::strcmp(Arg, "--help") == 0 || std::strcmp(Arg, "-h") == 0) {
+      PrintUsage();
+      std::exit(0);
+    }
+    if (i + 1 >= Argc) {
+      std::fprintf(stderr, "Missing value for %s\n", Arg);
+      return false;
+    }
+    const char *Value = Argv[++i];
+    if (std::strcmp(Arg, "--size") == 0) {
+      Options.Size = std::atoi(Value);
+    } else if (std::strcmp(Arg, "--iterations") == 0) {
+      Options.Iterations = std::atoi(Value);
+    } else if (std::strcmp(Arg, "--seed") == 0) {
+      Options.Seed = std::strtoull(Value, nullptr, 10);
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", Arg);
+      return false;
+    }
+  }
+  return Options.Size >= 8 && Options.Iterations >= 1;
+}
+
+template <typename Fn> double TimeMs(Fn &&Body) {
+  const auto Start = std::chrono::steady_clock::now();
+  Body();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - Start)
+      .count();
+}
+
+double Median(std::vector<double> Samples) {
+  std::sort(Samples.begin(), Samples.end());
+  return Samples[Samples.size() / 2];
+}
+
+// Reference check: plain BFS over the packed grid, one tile at a time
+size_t ScalarReachable(const FMapLayout &Layout, std::vector<uint8_t> &Seen,
+                       std::vector<FTile> &Queue) {
+  const FOccupancyGrid &Walls = Layout.Walls;
+  const int32_t Width = Walls.GetWidth();
+  Seen.assign(Walls.GetNumTiles(), 0);
+  Queue.clear();
+  Seen[Layout.PlayerStart.Y * Width + Layout.PlayerStart.X] = 1;
+  Queue.push_back(Layout.PlayerStart);
+  for (size_t Head = 0; Head < Queue.size(); Head++) {
+    const FTile At = Queue[Head];
+    for (EDirection Dir : {EDirection::PosX, EDirection::NegX,
+                           EDirection::PosY, EDirection::NegY}) {
+      const int32_t X = At.X + StepX(Dir);
+      const int32_t Y = At.Y + StepY(Dir);
+      if (Walls.IsWalkable(X, Y) && !Seen[static_cast<size_t>(Y) * Width + X]) {
+        Seen[static_cast<size_t>(Y) * Width + X] = 1;
+        Queue.push_back(FTile{X, Y});
+      }
+    }
+  }
+
+  size_t Unreached = 0;
+  for (const FTile &Flag : Layout.Flags)
+    Unreached += !Seen[static_cast<size_t>(Flag.Y) * Width + Flag.X];
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Unreached += !Seen[static_cast<size_t>(Spawn.Y) * Width + Spawn.X];
+  return Unreached;
+}
+
+size_t WordParallelUnreachable(const FMapLayout &Layout,
+                               FReachability &Reach) {
+  Reach.Init(Layout.Walls);
+  Reach.Flood(Layout.PlayerStart.X, Layout.PlayerStart.Y);
+  size_t Unreached = 0;
+  for (const FTile &Flag : Layout.Flags)
+    Unreached += !Reach.IsReached(Flag.X, Flag.Y);
+  for (const FTile &Spawn : Layout.EnemySpawns)
+    Unreached += !Reach.IsReached(Spawn.X, Spawn.Y);
+  return Unreached;
+}
+
+} // namespace
+
+int main(int Argc, char **Argv) {
+  FOptions Options;
+  if (!ParseOptions(Argc, Argv, Options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  struct FStyle {
+    const char *Name;
+    EMapStyle Style;
+  };
+  const FStyle Styles[] = {{"scatter", EMapStyle::Scatter},
+                           {"backtracker", EMapStyle::Backtracker},
+                           {"braided", EMapStyle::Braided}};
+
+  std::printf("%dx%d, %d iterations, median ms\n", Options.Size, Options.Size,
+              Options.Iterations);
+  std::printf("%-12s %10s %10s %10s %10s %8s\n", "style", "generate",
+              "validate", "bfs", "full", "sealed");
+
+  bool bAllReachable = true;
+  FMapLayout Layout;
+  FReachability Reach;
+  std::vector<uint8_t> Seen;
+  std::vector<FTile> Queue;
+
+  for (const FStyle &Style : Styles) {
+    FMapParams Params;
+    Params.Width = Options.Size;
+    Params.Height = Options.Size;
+    Params.Style = Style.Style;
+
+    std::vector<double> Generate, Validate, Scalar, Full;
+    size_t Sealed = 0;
+    for (int32_t Iteration = 0; Iteration < Options.Iterations; Iteration++) {
+      const uint64_t Seed = FRandom::MixSeed(Options.Seed, Iteration);
+
+      Params.bEnsureReachable = false;
+      FRandom Rng(Seed);
+      Generate.push_back(TimeMs([&] { GenerateLayout(Params, Rng, Layout); }));
+
+      size_t FastUnreached = 0;
+      size_t SlowUnreached = 0;
+      Validate.push_back(TimeMs(
+          [&] { FastUnreached = WordParallelUnreachable(Layout, Reach); }));
+      Scalar.push_back(TimeMs(
+          [&] { SlowUnreached = ScalarReachable(Layout, Seen, Queue); }));
+      if (FastUnreached != SlowUnreached) {
+        std::fprintf(stderr, "%s seed %llu: flood mismatch %zu vs %zu\n",
+                     Style.Name, static_cast<unsigned long long>(Seed),
+                     FastUnreached, SlowUnreached);
+        bAllReachable = false;
+      }
+
+      Params.bEnsureReachable = true;
+      Rng.Reseed(Seed);
+      Full.push_back(TimeMs([&] { GenerateLayout(Params, Rng, Layout); }));
+      if (WordParallelUnreachable(Layout, Reach) != 0 ||
+          ScalarReachable(Layout, Seen, Queue) != 0) {
+        std::fprintf(stderr, "%s seed %llu: unreachable target after repair\n",
+                     Style.Name, static_cast<unsigned long long>(Seed));
+        bAllReachable = false;
+      }
+      Sealed += SlowUnreached;
+    }
+
+    std::printf("%-12s %10.3f %10.3f %10.3f %10.3f %8zu\n", Style.Name,
+                Median(Generate), Median(Validate), Median(Scalar),
+                Median(Full), Sealed);
+  }
+
+  return bAllReachable ? 0 : 1;
+}